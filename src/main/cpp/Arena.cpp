@@ -0,0 +1,98 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <new>
+#include "Arena.hpp"
+#if defined(__unix__) || defined(__APPLE__)
+#define USE_MMAP
+#include <sys/mman.h>
+#endif
+
+/*
+ * Size of a huge page on the platforms that we know. Blocks are rounded to a multiple of this size,
+ * so that the kernel can back them entirely by huge pages. This is also the minimal block size.
+ */
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/*
+ * Creates an arena without memory. The first block is allocated on the first call to `allocate(…)`.
+ */
+Arena::Arena() {
+}
+
+/*
+ * Releases all memory. The arrays given by this arena shall not be used anymore.
+ */
+Arena::~Arena() {
+    release();
+}
+
+/*
+ * Allocates a new block of at least the given number of bytes, which becomes the block where
+ * the next arrays will be taken. The space left in the previous block, if any, is not used.
+ */
+void Arena::addBlock(size_t minimum) {
+    size_t capacity = ((std::max(minimum, (size_t) 1) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+    #ifdef USE_MMAP
+    void* address = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (address == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    #ifdef MADV_HUGEPAGE
+    madvise(address, capacity, MADV_HUGEPAGE);      // Only a hint, ignored if transparent huge pages are disabled.
+    #endif
+    #else
+    void* address = ::operator new(capacity, std::align_val_t(ARENA_ALIGNMENT));
+    #endif
+    blocks.push_back({static_cast<char*>(address), capacity, 0});
+}
+
+/*
+ * Releases all blocks to the operating system.
+ */
+void Arena::release() {
+    for (Block& block : blocks) {
+        #ifdef USE_MMAP
+        munmap(block.bytes, block.capacity);
+        #else
+        ::operator delete(block.bytes, std::align_val_t(ARENA_ALIGNMENT));
+        #endif
+    }
+    blocks.clear();
+}
+
+/*
+ * Returns an array of the given number of bytes, aligned on `ARENA_ALIGNMENT` bytes.
+ * The content of the array is undetermined: it may contain the values written before the last `reset()`.
+ * The array is valid until the next call to `reset()`. Throws `std::bad_alloc` if there is not enough memory.
+ */
+void* Arena::allocate(size_t numBytes) {
+    numBytes = ((numBytes + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT) * ARENA_ALIGNMENT;
+    if (blocks.empty() || blocks.back().capacity - blocks.back().used < numBytes) {
+        addBlock(numBytes);
+    }
+    Block& block = blocks.back();
+    void* array = block.bytes + block.used;
+    block.used += numBytes;
+    return array;
+}
+
+/*
+ * Makes all memory available again for the next allocations. All arrays given by this arena become invalid.
+ * If more than one block was needed since the last reset, they are replaced by a single block of the total
+ * size. Consequently, a sequence of allocations which is repeated after each reset needs no new block after
+ * the first time, and reuses memory pages which are already mapped.
+ */
+void Arena::reset() {
+    if (blocks.size() > 1) {
+        size_t total = 0;
+        for (const Block& block : blocks) {
+            total += block.capacity;
+        }
+        release();
+        addBlock(total);
+    } else if (!blocks.empty()) {
+        blocks.back().used = 0;
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+
+/*
+ * Alignment in bytes of all arrays returned by `Arena`. This is the size of a cache line,
+ * which is also the size of the largest vector register (AVX-512).
+ */
+#define ARENA_ALIGNMENT 64
+
+/*
+ * Memory from which the tests take all their temporary arrays. Arrays are never released individually:
+ * they are all released together by `reset()`, after which the same memory is given again to the next
+ * allocations. The harness calls `reset()` between repetitions of the tests, so that the memory is
+ * allocated (and the pages are faulted in) only during the first repetition. The memory blocks are
+ * aligned on `ARENA_ALIGNMENT` bytes and, when large enough, are backed by huge pages if the operating
+ * system allows it.
+ *
+ * This class is not thread-safe. Arrays used by worker threads shall be allocated before the threads start.
+ */
+class Arena {
+    /*
+     * A contiguous block of memory, with the number of bytes already given to callers.
+     */
+    struct Block {
+        char*  bytes;
+        size_t capacity;
+        size_t used;
+    };
+
+    /*
+     * The blocks allocated since the last call to `reset()`. Only the last block has free space.
+     */
+    std::vector<Block> blocks;
+
+    void addBlock(size_t);
+    void release();
+
+    public:
+        Arena();
+        ~Arena();
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+        void*  allocate(size_t);
+        void   reset();
+
+        /*
+         * Returns an array of `count` elements of type `T`, initialized to zero if `clear` is true.
+         * The array is valid until the next call to `reset()`.
+         */
+        template<typename T> T* allocate(size_t count, bool clear = false) {
+            T* array = static_cast<T*>(allocate(count * sizeof(T)));
+            if (clear) {
+                std::fill(array, array + count, T());
+            }
+            return array;
+        }
+};
+
+#endif
@@ -0,0 +1,283 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <atomic>
+#include <fstream>
+#include <algorithm>
+#include "AsyncReader.hpp"
+#ifdef __linux__
+#define USE_IO_URING
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+/*
+ * Maximal number of chunks submitted to io_uring and not yet completed.
+ * This is also the size of the submission queue.
+ */
+#define RING_ENTRIES 64
+
+#ifdef USE_IO_URING
+/*
+ * The submission and completion queues shared with the kernel. The pointers are in the memory mapped
+ * at the offsets given by `io_uring_setup`. The heads and tails are read and written with atomic
+ * operations because they are shared with the kernel. This implementation does not use `liburing`
+ * for avoiding a dependency, and uses only the features available since Linux 5.6.
+ */
+struct AsyncReader::Ring {
+    int              fd;
+    void*            sqMemory;
+    size_t           sqSize;
+    void*            cqMemory;
+    size_t           cqSize;
+    io_uring_sqe*    sqes;
+    size_t           sqesSize;
+    unsigned*        sqHead;
+    unsigned*        sqTail;
+    unsigned*        sqArray;
+    unsigned         sqMask;
+    unsigned*        cqHead;
+    unsigned*        cqTail;
+    io_uring_cqe*    cqes;
+    unsigned         cqMask;
+    unsigned         inFlight;      // Number of chunks submitted and not yet completed.
+
+    static Ring* create();
+    ~Ring();
+};
+
+/*
+ * Maps the queues of a new io_uring instance in memory. Returns NULL if io_uring is not available.
+ */
+AsyncReader::Ring* AsyncReader::Ring::create() {
+    io_uring_params params = {};
+    int fd = (int) syscall(__NR_io_uring_setup, RING_ENTRIES, &params);
+    if (fd < 0) {
+        return NULL;
+    }
+    size_t sqSize   = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cqSize   = params.cq_off.cqes  + params.cq_entries * sizeof(io_uring_cqe);
+    size_t sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    bool   single   = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+        sqSize = cqSize = std::max(sqSize, cqSize);
+    }
+    void* sqMemory = mmap(NULL, sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    void* cqMemory = single ? sqMemory :
+                     mmap(NULL, cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    void* sqes     = mmap(NULL, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqMemory == MAP_FAILED || cqMemory == MAP_FAILED || sqes == MAP_FAILED) {
+        if (sqes     != MAP_FAILED) munmap(sqes, sqesSize);
+        if (cqMemory != MAP_FAILED && !single) munmap(cqMemory, cqSize);
+        if (sqMemory != MAP_FAILED) munmap(sqMemory, sqSize);
+        close(fd);
+        return NULL;
+    }
+    Ring* r = new Ring();
+    r->fd       = fd;
+    r->sqMemory = sqMemory;
+    r->sqSize   = sqSize;
+    r->cqMemory = cqMemory;
+    r->cqSize   = cqSize;
+    r->sqesSize = sqesSize;
+    char* sq = static_cast<char*>(r->sqMemory);
+    char* cq = static_cast<char*>(r->cqMemory);
+    r->sqes     = static_cast<io_uring_sqe*>(sqes);
+    r->sqHead   = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    r->sqTail   = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    r->sqArray  = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    r->sqMask   = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    r->cqHead   = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    r->cqTail   = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    r->cqes     = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    r->cqMask   = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    r->inFlight = 0;
+    return r;
+}
+
+/*
+ * Unmaps the queues and closes the io_uring instance.
+ */
+AsyncReader::Ring::~Ring() {
+    munmap(sqes, sqesSize);
+    if (cqMemory != sqMemory) {
+        munmap(cqMemory, cqSize);
+    }
+    munmap(sqMemory, sqSize);
+    close(fd);
+}
+#endif
+
+/*
+ * Creates a reader for at most `depth` files read concurrently.
+ * The io_uring instance is created immediately, or the fallback is selected if that failed.
+ */
+AsyncReader::AsyncReader(int depth) : requests(depth), ring(NULL) {
+    for (Request& request : requests) {
+        request.fd      = -1;
+        request.pending = 0;
+        request.failed  = false;
+    }
+    #ifdef USE_IO_URING
+    ring = Ring::create();
+    #endif
+}
+
+/*
+ * Waits for the completion of all reads, then releases the io_uring instance.
+ * The reads must complete before the buffers of the caller are released.
+ */
+AsyncReader::~AsyncReader() {
+    for (size_t slot=0; slot < requests.size(); slot++) {
+        wait((int) slot);
+    }
+    #ifdef USE_IO_URING
+    delete ring;
+    #endif
+}
+
+/*
+ * Returns a name of the mechanism used for reading the files, for reporting purposes.
+ */
+const char* AsyncReader::backend() const {
+    return (ring != NULL) ? "io_uring" : "thread";
+}
+
+/*
+ * Starts reading `length` bytes of the given file in the `target` buffer. The slot shall not have
+ * a read in progress, i.e. either no read was started in that slot or `wait(slot)` has been invoked.
+ * Errors are not reported by this method, but by the `wait(slot)` method.
+ */
+void AsyncReader::start(int slot, const std::filesystem::path& file, char* target, size_t length) {
+    Request& request = requests.at(slot);
+    request.target  = target;
+    request.length  = length;
+    request.pending = 0;
+    request.failed  = false;
+    #ifdef USE_IO_URING
+    if (ring != NULL) {
+        request.fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (request.fd < 0) {
+            request.failed = true;
+            return;
+        }
+        for (size_t offset = 0; offset < length; offset += ASYNC_READ_CHUNK_SIZE) {
+            request.pending++;
+            submit(slot, offset);
+        }
+        return;
+    }
+    #endif
+    request.thread = std::async(std::launch::async, [file, target, length]() {
+        std::ifstream in(file, std::ios::binary);
+        in.read(target, length);
+        return in.gcount() == (std::streamsize) length;
+    });
+}
+
+/*
+ * Submits the read of the bytes from the given offset to the end of the chunk containing that offset.
+ * The offset is usually at the beginning of a chunk, except when resubmitting the remaining of a short
+ * read. If the submission queue is full, this method waits for the completion of some previous chunks.
+ */
+void AsyncReader::submit(int slot, size_t offset) {
+    #ifdef USE_IO_URING
+    while (ring->inFlight >= RING_ENTRIES) {
+        reap();
+    }
+    const Request& request = requests[slot];
+    size_t end = std::min((offset / ASYNC_READ_CHUNK_SIZE + 1) * ASYNC_READ_CHUNK_SIZE, request.length);
+    unsigned tail = *ring->sqTail;
+    unsigned index = tail & ring->sqMask;
+    io_uring_sqe* sqe = &ring->sqes[index];
+    *sqe = {};
+    sqe->opcode    = IORING_OP_READ;
+    sqe->fd        = request.fd;
+    sqe->off       = offset;
+    sqe->addr      = reinterpret_cast<uint64_t>(request.target + offset);
+    sqe->len       = (uint32_t) (end - offset);
+    sqe->user_data = ((uint64_t) slot << 48) | offset;
+    ring->sqArray[index] = index;
+    std::atomic_ref<unsigned>(*ring->sqTail).store(tail + 1, std::memory_order_release);
+    ring->inFlight++;
+    /*
+     * If the submission failed, the entry stays in the queue and will be submitted
+     * by the next call to `io_uring_enter` in `reap()`.
+     */
+    syscall(__NR_io_uring_enter, ring->fd, 1, 0, 0, NULL, 0);
+    #else
+    (void) slot;
+    (void) offset;
+    #endif
+}
+
+/*
+ * Waits for at least one completion, then processes all available completions.
+ * Short reads are resubmitted for the remaining bytes of the chunk.
+ */
+void AsyncReader::reap() {
+    #ifdef USE_IO_URING
+    unsigned head = *ring->cqHead;
+    unsigned toSubmit = *ring->sqTail - std::atomic_ref<unsigned>(*ring->sqHead).load(std::memory_order_acquire);
+    if (head == std::atomic_ref<unsigned>(*ring->cqTail).load(std::memory_order_acquire)) {
+        if (syscall(__NR_io_uring_enter, ring->fd, toSubmit, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR) {
+            for (Request& request : requests) {     // Should not happen. Abandon all reads.
+                request.failed |= (request.pending != 0);
+                request.pending = 0;
+            }
+            ring->inFlight = 0;
+            return;
+        }
+    }
+    unsigned tail = std::atomic_ref<unsigned>(*ring->cqTail).load(std::memory_order_acquire);
+    while (head != tail) {
+        const io_uring_cqe& cqe = ring->cqes[head & ring->cqMask];
+        int    slot   = (int) (cqe.user_data >> 48);
+        size_t offset = cqe.user_data & ((UINT64_C(1) << 48) - 1);
+        int    result = cqe.res;
+        std::atomic_ref<unsigned>(*ring->cqHead).store(++head, std::memory_order_release);
+        ring->inFlight--;
+        Request& request = requests[slot];
+        size_t end = std::min((offset / ASYNC_READ_CHUNK_SIZE + 1) * ASYNC_READ_CHUNK_SIZE, request.length);
+        if (result == -EINTR || result == -EAGAIN) {
+            submit(slot, offset);
+        } else if (result <= 0) {
+            request.failed = true;                  // I/O error, or end of file before `length` bytes.
+            request.pending--;
+        } else if (offset + result < end) {
+            submit(slot, offset + result);
+        } else {
+            request.pending--;
+        }
+    }
+    #endif
+}
+
+/*
+ * Waits for the completion of the read in the given slot. Returns whether all bytes have been read.
+ * After this method returned, the slot can be reused for another read.
+ */
+bool AsyncReader::wait(int slot) {
+    Request& request = requests.at(slot);
+    bool success;
+    if (request.thread.valid()) {
+        success = request.thread.get();
+    } else {
+        while (request.pending != 0) {
+            reap();
+        }
+        success = !request.failed;
+    }
+    #ifdef USE_IO_URING
+    if (request.fd >= 0) {
+        close(request.fd);
+        request.fd = -1;
+    }
+    #endif
+    return success;
+}
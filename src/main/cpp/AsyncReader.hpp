@@ -0,0 +1,63 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#ifndef ASYNC_READER_HPP
+#define ASYNC_READER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <future>
+#include <filesystem>
+
+/*
+ * Reads whole files in background, in buffers provided by the caller. Each read is identified by a slot
+ * number from 0 inclusive to the `depth` given at construction time exclusive, and a slot can be reused
+ * for a new read after `wait(slot)` returned. On Linux, the reads are submitted to the kernel with io_uring,
+ * by chunks of `ASYNC_READ_CHUNK_SIZE` bytes. If io_uring is not available (old kernel, or disabled by the
+ * security policy), or on other systems, each read is done by a separate thread.
+ *
+ * This class is not thread-safe: all methods shall be invoked from the same thread.
+ */
+class AsyncReader {
+    /*
+     * A file being read, or the last file read in a slot.
+     */
+    struct Request {
+        int    fd;              // File descriptor if io_uring is used, or -1.
+        char*  target;          // Where to store the bytes.
+        size_t length;          // Number of bytes to read.
+        int    pending;         // Number of chunks not yet read (io_uring only).
+        bool   failed;          // Whether an error occurred.
+        std::future<bool> thread;       // The fallback reader, or invalid if io_uring is used.
+    };
+
+    std::vector<Request> requests;
+
+    /*
+     * The io_uring queues mapped in memory, or NULL if the fallback threads are used.
+     * The structure is defined in the implementation file because it depends on Linux headers.
+     */
+    struct Ring;
+    Ring* ring;
+
+    void submit(int slot, size_t offset);
+    void reap();
+
+    public:
+        AsyncReader(int depth);
+        ~AsyncReader();
+        AsyncReader(const AsyncReader&) = delete;
+        AsyncReader& operator=(const AsyncReader&) = delete;
+        const char* backend() const;
+        void start(int slot, const std::filesystem::path& file, char* target, size_t length);
+        bool wait(int slot);
+};
+
+/*
+ * Number of bytes read by each request submitted to io_uring.
+ */
+#define ASYNC_READ_CHUNK_SIZE (1024 * 1024)
+
+#endif
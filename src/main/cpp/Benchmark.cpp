@@ -0,0 +1,548 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <regex>
+#include <memory>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <thread>
+#include "TestCase.hpp"
+#include "Throughput.hpp"
+#ifdef __linux__
+#define USE_AFFINITY
+#include <sched.h>
+#endif
+
+/*
+ * Options of the benchmark, in addition to the options of the tests described in `Configuration`.
+ */
+struct BenchmarkOptions {
+    /*
+     * Number of runs of each benchmark before the measurements, for warming up the caches,
+     * the branch predictors and the processor frequency. Those runs are still verified.
+     */
+    int warmup = 3;
+
+    /*
+     * Number of measured runs of each benchmark.
+     */
+    int repetitions = 20;
+
+    /*
+     * The processor on which to pin the benchmark thread, or -1 for the processor on which the benchmark
+     * started, or -2 for no pinning. Benchmarks using many threads are never pinned.
+     */
+    int cpu = -1;
+
+    /*
+     * Regular expression that the benchmark names shall contain, or empty for running all benchmarks.
+     */
+    std::string filter;
+
+    /*
+     * File where to write the results in JSON format, or empty for none.
+     */
+    std::string jsonFile;
+
+    /*
+     * File where to write the latency histograms, in CSV format if the extension is ".csv"
+     * or in JSON format otherwise, or empty for not recording the latencies.
+     */
+    std::string latencyFile;
+
+    /*
+     * Number of points of the throughput benchmarks, or 0 for not running them. See `ThroughputTest`.
+     */
+    int throughputPoints = 0;
+
+    bool parse(int&, char**);
+};
+
+/*
+ * The measurements of one benchmark after outlier rejection. Times are in nanoseconds.
+ */
+struct BenchmarkResult {
+    const char* name;
+    int    samples, outliers;
+    double median, mean, stddev, min, max;
+    double interpolations;      // Number of interpolations in each run.
+
+    double nanosPerPoint() const;
+};
+
+/*
+ * The durations of the iterations and of the batches of `SIMD_BATCH_SIZE` points of one benchmark,
+ * merged over all measured runs. The histogram of batches is empty for the variants which do not
+ * compute the interpolations by batches in the benchmark thread.
+ */
+struct LatencyResult {
+    const char* name;
+    LatencyHistogram iterations, batches;
+};
+
+/*
+ * Parses the benchmark options and removes them from the command line, leaving the other options for
+ * `Configuration::parse(…)`. Recognized options are `--warmup=…`, `--repetitions=…`, `--cpu=…` (a processor
+ * number or `none`), `--filter=…`, `--json=…`, `--latency=…` and `--throughput=…`. Returns `false` if an option has an invalid value.
+ */
+bool BenchmarkOptions::parse(int& argc, char** argv) {
+    int remaining = 1;
+    for (int i=1; i<argc; i++) {
+        const char* arg = argv[i];
+        const char* value = strchr(arg, '=');
+        if (value) {
+            std::string name(arg, value++ - arg);
+            int* target = NULL;
+            int  minimum = 0;
+            long maximum = 1000000;
+            if      (name == "--warmup")      target = &warmup;
+            else if (name == "--repetitions") {target = &repetitions; minimum = 1;}
+            else if (name == "--throughput")  {target = &throughputPoints; maximum = 100000000;}
+            else if (name == "--cpu") {
+                if (strcmp(value, "none") == 0) {
+                    cpu = -2;
+                    continue;
+                }
+                target = &cpu;
+            }
+            else if (name == "--filter") {filter   = value; continue;}
+            else if (name == "--json")   {jsonFile = value; continue;}
+            else if (name == "--latency") {latencyFile = value; continue;}
+            if (target) {
+                char* end;
+                long n = strtol(value, &end, 10);
+                if (*end != 0 || n < minimum || n > maximum) {
+                    std::cout << "Invalid option: " << arg << '\n'
+                              << "Benchmark options: [--warmup=3] [--repetitions=20] [--cpu=N|none]"
+                                 " [--filter=regex] [--json=file] [--latency=file] [--throughput=points]\n";
+                    return false;
+                }
+                *target = (int) n;
+                continue;
+            }
+        }
+        argv[remaining++] = argv[i];
+    }
+    argc = remaining;
+    return true;
+}
+
+/*
+ * Returns the median time divided by the number of interpolations. For the test variants,
+ * the latter is the number of points multiplied by the number of iterations.
+ */
+double BenchmarkResult::nanosPerPoint() const {
+    return median / interpolations;
+}
+
+/*
+ * Returns the value at the given fraction of the sorted samples, with linear interpolation between samples.
+ */
+double quantile(const std::vector<double>& sorted, double fraction) {
+    double position = fraction * (sorted.size() - 1);
+    size_t lower = (size_t) position;
+    size_t upper = std::min(lower + 1, sorted.size() - 1);
+    return sorted[lower] + (position - lower) * (sorted[upper] - sorted[lower]);
+}
+
+/*
+ * Computes the statistics of the given execution times. Outliers are the times outside the Tukey fences,
+ * which are 1.5 times the interquartile range below the first quartile or above the third quartile.
+ * Outliers are usually caused by interruptions (other processes, page faults, timer interrupts) that
+ * are not related to the code being measured, so they are excluded from the statistics.
+ */
+BenchmarkResult summarize(const char* name, std::vector<double> samples, double interpolations) {
+    std::sort(samples.begin(), samples.end());
+    double q1    = quantile(samples, 0.25);
+    double q3    = quantile(samples, 0.75);
+    double lower = q1 - 1.5 * (q3 - q1);
+    double upper = q3 + 1.5 * (q3 - q1);
+    std::vector<double> kept;
+    for (double time : samples) {
+        if (time >= lower && time <= upper) {
+            kept.push_back(time);
+        }
+    }
+    BenchmarkResult result;
+    result.name     = name;
+    result.interpolations = interpolations;
+    result.samples  = (int) kept.size();
+    result.outliers = (int) (samples.size() - kept.size());
+    result.median   = quantile(kept, 0.5);
+    result.min      = kept.front();
+    result.max      = kept.back();
+    result.mean     = 0;
+    for (double time : kept) {
+        result.mean += time;
+    }
+    result.mean /= kept.size();
+    double variance = 0;
+    for (double time : kept) {
+        double d = time - result.mean;
+        variance += d*d;
+    }
+    result.stddev = (kept.size() > 1) ? std::sqrt(variance / (kept.size() - 1)) : 0;
+    return result;
+}
+
+/*
+ * Restricts the current thread to the given processor, or allows it on all the processors
+ * of `original` if `cpu` is negative. Returns whether the operation succeeded.
+ * Defined only on platforms where thread affinity is supported.
+ */
+#ifdef USE_AFFINITY
+bool pin(int cpu, const cpu_set_t& original) {
+    cpu_set_t mask = original;
+    if (cpu >= 0) {
+        CPU_ZERO(&mask);
+        CPU_SET(cpu, &mask);
+    }
+    return sched_setaffinity(0, sizeof(mask), &mask) == 0;
+}
+#endif
+
+/*
+ * Returns the given text between quotes, with the characters that are special in JSON escaped.
+ */
+std::string quote(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') quoted += '\\';
+        if ((unsigned char) c >= ' ') quoted += c;
+    }
+    return quoted + '"';
+}
+
+/*
+ * Writes the results in the JSON format of Google Benchmark, so that the tools of that project
+ * (e.g. `compare.py`) can be used for tracking regressions between releases. Each benchmark is
+ * reported as a "median" aggregate, with additional fields for the other statistics.
+ * Returns whether the file has been written.
+ */
+bool writeJSON(const BenchmarkOptions& options, const std::vector<BenchmarkResult>& results,
+               const char* executable, const char* kernelName)
+{
+    std::ofstream out(options.jsonFile);
+    if (!out.is_open()) {
+        return false;
+    }
+    char date[32];
+    time_t now = time(NULL);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+    out << "{\n"
+        << "  \"context\": {\n"
+        << "    \"date\": "               << quote(date)       << ",\n"
+        << "    \"executable\": "         << quote(executable) << ",\n"
+        << "    \"num_cpus\": "           << std::thread::hardware_concurrency() << ",\n"
+        << "    \"library_build_type\": \"release\",\n"
+        << "    \"kernel\": "             << quote(kernelName) << ",\n"
+        << "    \"width\": "              << config.width  << ",\n"
+        << "    \"height\": "             << config.height << ",\n"
+        << "    \"points\": "             << config.numInterpolationPoints << ",\n"
+        << "    \"iterations\": "         << config.numVerifiedIterations  << ",\n"
+        << "    \"tile\": "               << config.tileSize    << ",\n"
+        << "    \"throughput_points\": "  << options.throughputPoints << ",\n"
+        << "    \"warmup\": "             << options.warmup      << ",\n"
+        << "    \"repetitions\": "        << options.repetitions << ",\n"
+        << "    \"cpu\": "                << options.cpu         << '\n'
+        << "  },\n"
+        << "  \"benchmarks\": [";
+    const char* separator = "\n";
+    for (const BenchmarkResult& result : results) {
+        char numbers[512];
+        snprintf(numbers, sizeof(numbers),
+                 "      \"repetitions\": %d,\n"
+                 "      \"iterations\": %d,\n"
+                 "      \"outliers\": %d,\n"
+                 "      \"real_time\": %.1f,\n"
+                 "      \"cpu_time\": %.1f,\n"
+                 "      \"time_unit\": \"ns\",\n"
+                 "      \"mean\": %.1f,\n"
+                 "      \"stddev\": %.1f,\n"
+                 "      \"min\": %.1f,\n"
+                 "      \"max\": %.1f,\n"
+                 "      \"ns_per_point\": %.4f,\n"
+                 "      \"points_per_second\": %.0f\n",
+                 options.repetitions, result.samples, result.outliers, result.median, result.median,
+                 result.mean, result.stddev, result.min, result.max, result.nanosPerPoint(),
+                 1E9 / result.nanosPerPoint());
+        out << separator
+            << "    {\n"
+            << "      \"name\": "     << quote(std::string(result.name) + "_median") << ",\n"
+            << "      \"run_name\": " << quote(result.name) << ",\n"
+            << "      \"run_type\": \"aggregate\",\n"
+            << "      \"aggregate_name\": \"median\",\n"
+            << numbers
+            << "    }";
+        separator = ",\n";
+    }
+    out << "\n  ]\n}\n";
+    return out.good();
+}
+
+/*
+ * Writes the latency histograms in CSV format, with one row per benchmark and scope (iteration or batch),
+ * or in JSON format with the non-empty buckets in addition of the percentiles. Times are in nanoseconds.
+ * Returns whether the file has been written.
+ */
+bool writeLatencies(const BenchmarkOptions& options, const std::vector<LatencyResult>& results) {
+    std::ofstream out(options.latencyFile);
+    if (!out.is_open()) {
+        return false;
+    }
+    const std::string& file = options.latencyFile;
+    const bool csv = file.size() >= 4 && file.compare(file.size() - 4, 4, ".csv") == 0;
+    if (csv) {
+        out << "benchmark,scope,count,min_ns,mean_ns";
+        for (const char* name : LATENCY_PERCENTILE_NAMES) {
+            out << ',' << name << "_ns";
+        }
+        out << ",max_ns\n";
+    } else {
+        out << "{\n"
+            << "  \"points\": "     << config.numInterpolationPoints << ",\n"
+            << "  \"iterations\": " << config.numVerifiedIterations  << ",\n"
+            << "  \"batch_size\": " << SIMD_BATCH_SIZE << ",\n"
+            << "  \"benchmarks\": [";
+    }
+    const char* separator = "\n";
+    for (const LatencyResult& result : results) {
+        for (int scope=0; scope<2; scope++) {
+            const LatencyHistogram& histogram = scope ? result.batches : result.iterations;
+            const char* scopeName = scope ? "batch" : "iteration";
+            if (histogram.count() == 0) {
+                continue;
+            }
+            char mean[32];
+            snprintf(mean, sizeof(mean), "%.1f", histogram.mean());
+            if (csv) {
+                out << result.name << ',' << scopeName << ',' << histogram.count() << ',' << histogram.min() << ',' << mean;
+                for (double fraction : LATENCY_PERCENTILES) {
+                    out << ',' << histogram.percentile(fraction);
+                }
+                out << ',' << histogram.max() << '\n';
+            } else {
+                out << separator
+                    << "    {\n"
+                    << "      \"name\": "  << quote(result.name) << ",\n"
+                    << "      \"scope\": " << quote(scopeName)   << ",\n"
+                    << "      \"count\": " << histogram.count()  << ",\n"
+                    << "      \"min\": "   << histogram.min()    << ",\n"
+                    << "      \"mean\": "  << mean               << ",\n";
+                for (int i=0; i<NUM_LATENCY_PERCENTILES; i++) {
+                    out << "      " << quote(LATENCY_PERCENTILE_NAMES[i]) << ": " << histogram.percentile(LATENCY_PERCENTILES[i]) << ",\n";
+                }
+                out << "      \"max\": "   << histogram.max()    << ",\n"
+                    << "      \"buckets\": ";
+                histogram.writeBuckets(out);
+                out << "\n    }";
+                separator = ",\n";
+            }
+        }
+    }
+    if (!csv) {
+        out << "\n  ]\n}\n";
+    }
+    return out.good();
+}
+
+/*
+ * Prints the table of latency percentiles, in microseconds.
+ */
+void printLatencies(const std::vector<LatencyResult>& results) {
+    printf("\n%-36s %-9s %10s", "Latency (us)", "Scope", "Count");
+    for (const char* name : LATENCY_PERCENTILE_NAMES) {
+        printf(" %10s", name);
+    }
+    printf(" %10s\n", "max");
+    for (const LatencyResult& result : results) {
+        for (int scope=0; scope<2; scope++) {
+            const LatencyHistogram& histogram = scope ? result.batches : result.iterations;
+            if (histogram.count() != 0) {
+                printf("%-36s %-9s %10llu", result.name, scope ? "batch" : "iteration", (unsigned long long) histogram.count());
+                for (double fraction : LATENCY_PERCENTILES) {
+                    printf(" %10.2f", histogram.percentile(fraction) / 1E3);
+                }
+                printf(" %10.2f\n", histogram.max() / 1E3);
+            }
+        }
+    }
+}
+
+/*
+ * Prints a row of the table of results.
+ */
+void printResult(const BenchmarkResult& result) {
+    printf("%-36s %12.3f %12.3f %10.2f %12.2f %10d\n", result.name, result.median / 1E6, result.stddev / 1E6,
+           result.nanosPerPoint(), 1E3 / result.nanosPerPoint(), result.outliers);
+}
+
+/*
+ * Returns whether the results of the given test are the same as the results of its reference variant, as verified
+ * by `NaN-test`. The references are computed when first needed with the given arena, and kept in the given vector
+ * for the next runs. If the results are the same, the mismatches that the test may report are the chaotic drift
+ * of the calculation rather than an error. This happens in the first iterations when the number of points is large
+ * (see `config.numStrictIterations`). The caller shall not invoke this method for a test which tolerates errors
+ * or is its own reference, as it cannot be compared in that case.
+ */
+bool sameAsReference(TestCase* test, std::vector<std::unique_ptr<TestCase>>& references, Arena& arena, DataCache& cache) {
+    const int r = test->referenceVariant();
+    if (!references[r]) {
+        references[r].reset(createTestVariant(r, arena, cache));
+        if (references[r]->computeAndCompare() <= 0) {
+            return false;
+        }
+    }
+    return references[r]->resultEquals(test);
+}
+
+/*
+ * Runs the throughput variants as separate benchmarks, after the test variants. Each run is verified against
+ * the results of the scalar variant. Returns `false` if the raster cannot be read or if a run fails.
+ */
+bool runThroughput(const BenchmarkOptions& options, const std::regex& pattern, DataCache& cache,
+                   std::vector<BenchmarkResult>& results)
+{
+    const float* values = cache.raster(true, std::endian::native, RasterLayout(config.width, config.height, 0));
+    if (!values) {
+        std::cout << "Cannot read the raster in " << cache.file(true, "") << ".\n";
+        return false;
+    }
+    ThroughputTest test(values, config.width, config.height, options.throughputPoints);
+    for (int t=0; t<NUM_THROUGHPUT_VARIANTS; t++) {
+        if (!options.filter.empty() && !std::regex_search(THROUGHPUT_VARIANT_IDS[t], pattern)) {
+            continue;
+        }
+        std::vector<double> samples;
+        for (int run = -options.warmup; run < options.repetitions; run++) {
+            double time = test.run(t);
+            if (!test.verify()) {
+                std::cout << THROUGHPUT_VARIANT_IDS[t] << ": TEST FAILURE (results differ from the scalar variant)\n";
+                return false;
+            }
+            if (run >= 0) {
+                samples.push_back(time);
+            }
+        }
+        printResult(results.emplace_back(summarize(THROUGHPUT_VARIANT_IDS[t], samples, test.numPoints)));
+    }
+    return true;
+}
+
+/*
+ * Runs each test variant as a separate benchmark. Each run creates a new test case, like the test executable,
+ * but the data files are loaded only once and the memory is reused between runs. Every run is verified, and
+ * the benchmark stops if a run fails. A run is verified as in the test executable: its results shall be identical
+ * to the results of its reference variant, or for the variants that are not compared with a reference, the first
+ * iterations shall have no mismatch. The test options are the same as for the test executable, with the
+ * addition of the options documented in `BenchmarkOptions::parse(…)`. If `--throughput` is specified,
+ * the single-pass throughput benchmarks are executed after the test variants. If `--latency` is specified,
+ * the durations of the iterations and batches of the measured runs are recorded in histograms, which are
+ * printed as percentiles after the results and written in the specified file.
+ */
+int main(int argc, char** argv) {
+    BenchmarkOptions options;
+    if (!options.parse(argc, argv) || !config.parse(argc, argv)) {
+        return 1;
+    }
+    std::regex pattern(options.filter);
+    const char* kernelName;
+    selectInterpolationKernel(config.width, &kernelName);
+    #ifdef USE_AFFINITY
+    cpu_set_t original;
+    sched_getaffinity(0, sizeof(original), &original);
+    if (options.cpu == -1) {
+        options.cpu = sched_getcpu();
+    }
+    if (options.cpu >= 0 && !pin(options.cpu, original)) {
+        std::cout << "Cannot pin the benchmark on processor " << options.cpu << ".\n";
+        return 1;
+    }
+    #else
+    options.cpu = -2;
+    #endif
+    std::cout << "Vectorized interpolation kernel: " << kernelName << '\n'
+              << "Benchmark thread pinned on processor: ";
+    if (options.cpu >= 0) std::cout << options.cpu; else std::cout << "none";
+    std::cout << "\nWarmup runs: " << options.warmup << ", measured runs: " << options.repetitions << "\n\n";
+    printf("%-36s %12s %12s %10s %12s %10s\n", "Benchmark", "Median (ms)", "Stddev (ms)", "ns/point", "Mpoints/s", "Outliers");
+
+    Arena arena, referenceArena;
+    DataCache cache;
+    std::vector<std::unique_ptr<TestCase>> references(NUM_TEST_VARIANTS);
+    std::vector<BenchmarkResult> results;
+    std::vector<LatencyResult> latencies;
+    for (int t=0; t<NUM_TEST_VARIANTS; t++) {
+        if (!isVariantEnabled(t)) {
+            continue;
+        }
+        if (!options.filter.empty() && !std::regex_search(TEST_VARIANT_IDS[t], pattern)) {
+            continue;
+        }
+        LatencyResult* latency = NULL;
+        if (!options.latencyFile.empty()) {
+            latency = &latencies.emplace_back();
+            latency->name = TEST_VARIANT_IDS[t];
+        }
+        std::vector<double> samples;
+        for (int run = -options.warmup; run < options.repetitions; run++) {
+            arena.reset();          // The test case of the previous run has been destroyed.
+            std::unique_ptr<TestCase> test(createTestVariant(t, arena, cache));
+            #ifdef USE_AFFINITY
+            if (options.cpu >= 0) {
+                pin((test->threadCount() > 1) ? -1 : options.cpu, original);
+            }
+            #endif
+            if (latency && run >= 0) {
+                test->setLatencyHistograms(&latency->iterations, &latency->batches);
+            }
+            double time = test->computeAndCompare();
+            if (time <= 0) {
+                std::cout << TEST_VARIANT_IDS[t] << ": TEST FAILURE (are the data files present and matching the options?)\n";
+                return 1;
+            }
+            const bool compared = (test->tolerance() == 0 && test->referenceVariant() != t);
+            if (compared && !sameAsReference(test.get(), references, referenceArena, cache)) {
+                std::cout << TEST_VARIANT_IDS[t] << ": TEST FAILURE (results differ from the reference "
+                          << TEST_VARIANT_IDS[test->referenceVariant()] << ")\n";
+                return 1;
+            }
+            if (!compared && !test->success()) {
+                std::cout << TEST_VARIANT_IDS[t] << ": TEST FAILURE (mismatches in the first " << config.numStrictIterations
+                          << " iterations; is a smaller --strict value needed?)\n";
+                return 1;
+            }
+            if (run >= 0) {
+                samples.push_back(time);
+            }
+        }
+        printResult(results.emplace_back(summarize(TEST_VARIANT_IDS[t], samples,
+                    (double) config.numInterpolationPoints * config.numVerifiedIterations)));
+    }
+    if (options.throughputPoints > 0 && !runThroughput(options, pattern, cache, results)) {
+        return 1;
+    }
+    if (!latencies.empty()) {
+        printLatencies(latencies);
+    }
+    std::cout << "Note: differences in execution times are not necessarily because of NaNs,\n"
+                 "because the branch testing NaN intentionally performs more interpolations.\n";
+    if (!options.jsonFile.empty() && !writeJSON(options, results, argv[0], kernelName)) {
+        std::cout << "Cannot write " << options.jsonFile << ".\n";
+        return 1;
+    }
+    if (!latencies.empty() && !writeLatencies(options, latencies)) {
+        std::cout << "Cannot write " << options.latencyFile << ".\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "ByteOrder.hpp"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/*
+ * Swaps the bytes one element at a time. Used when no vector instruction is available,
+ * and for the last elements when the number of bytes is not a multiple of the vector size.
+ * The `memcpy` calls are for avoiding alignment and aliasing issues, and are optimized away.
+ */
+template<typename T> void swapBytesScalar(const char* source, char* target, size_t numBytes) {
+    for (size_t i=0; i<numBytes; i += sizeof(T)) {
+        T value;
+        memcpy(&value, source + i, sizeof(T));
+        value = byteswap(value);
+        memcpy(target + i, &value, sizeof(T));
+    }
+}
+
+/*
+ * Dispatches to the scalar implementation for the given element size.
+ */
+void swapBytesScalar(const char* source, char* target, size_t numBytes, int elementSize) {
+    switch (elementSize) {
+        case 2: swapBytesScalar<uint16_t>(source, target, numBytes); break;
+        case 4: swapBytesScalar<uint32_t>(source, target, numBytes); break;
+        case 8: swapBytesScalar<uint64_t>(source, target, numBytes); break;
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/*
+ * Returns the `pshufb` control mask reversing the bytes of all elements in a 16 bytes lane.
+ */
+inline __m128i shuffleMask(int elementSize) {
+    int8_t mask[16];
+    for (int i=0; i<16; i++) {
+        mask[i] = (int8_t) ((i - i % elementSize) + (elementSize - 1 - i % elementSize));
+    }
+    return _mm_loadu_si128((const __m128i*) mask);
+}
+
+/*
+ * Swaps 32 bytes per step with the AVX2 `vpshufb` instruction.
+ */
+__attribute__((target("avx2")))
+void swapBytesAVX2(const char* source, char* target, size_t numBytes, int elementSize) {
+    const __m256i mask = _mm256_broadcastsi128_si256(shuffleMask(elementSize));
+    size_t i = 0;
+    for (; i + 32 <= numBytes; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (source + i));
+        _mm256_storeu_si256((__m256i*) (target + i), _mm256_shuffle_epi8(v, mask));
+    }
+    swapBytesScalar(source + i, target + i, numBytes - i, elementSize);
+}
+
+/*
+ * Swaps 16 bytes per step with the SSSE3 `pshufb` instruction.
+ */
+__attribute__((target("ssse3")))
+void swapBytesSSSE3(const char* source, char* target, size_t numBytes, int elementSize) {
+    const __m128i mask = shuffleMask(elementSize);
+    size_t i = 0;
+    for (; i + 16 <= numBytes; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (source + i));
+        _mm_storeu_si128((__m128i*) (target + i), _mm_shuffle_epi8(v, mask));
+    }
+    swapBytesScalar(source + i, target + i, numBytes - i, elementSize);
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+/*
+ * Swaps 16 bytes per step with the NEON `rev16`, `rev32` or `rev64` instructions.
+ */
+void swapBytesNEON(const char* source, char* target, size_t numBytes, int elementSize) {
+    size_t i = 0;
+    for (; i + 16 <= numBytes; i += 16) {
+        uint8x16_t v = vld1q_u8((const uint8_t*) (source + i));
+        switch (elementSize) {
+            case 2: v = vrev16q_u8(v); break;
+            case 4: v = vrev32q_u8(v); break;
+            case 8: v = vrev64q_u8(v); break;
+        }
+        vst1q_u8((uint8_t*) (target + i), v);
+    }
+    swapBytesScalar(source + i, target + i, numBytes - i, elementSize);
+}
+#endif
+
+/*
+ * Copies bytes while reversing the byte order of each element, using the fastest instructions
+ * supported by the processor. See the header file for the documentation.
+ */
+void swapBytes(const void* source, void* target, size_t numBytes, int elementSize) {
+    const char* s = static_cast<const char*>(source);
+    char*       t = static_cast<char*>(target);
+    #if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) {
+        swapBytesAVX2(s, t, numBytes, elementSize);
+        return;
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        swapBytesSSSE3(s, t, numBytes, elementSize);
+        return;
+    }
+    #elif defined(__ARM_NEON) && defined(__aarch64__)
+    swapBytesNEON(s, t, numBytes, elementSize);
+    return;
+    #endif
+    swapBytesScalar(s, t, numBytes, elementSize);
+}
+
+/*
+ * Reads and swaps bytes by chunks. See the header file for the documentation.
+ */
+bool readAndSwap(std::istream& stream, char* target, size_t numBytes, int elementSize) {
+    for (size_t position = 0; position < numBytes; position += SWAP_CHUNK_SIZE) {
+        size_t length = std::min((size_t) SWAP_CHUNK_SIZE, numBytes - position);
+        stream.read(target + position, length);
+        if (!stream.good()) {
+            return false;
+        }
+        if (elementSize > 1) {
+            swapBytes(target + position, target + position, length, elementSize);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,67 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#ifndef BYTE_ORDER_HPP
+#define BYTE_ORDER_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <type_traits>
+
+/*
+ * Number of bytes read and swapped in a single step by `readAndSwap(…)` and by the memory-mapped
+ * files. This is small enough for the bytes to still be in the cache when they are swapped.
+ */
+#define SWAP_CHUNK_SIZE (256 * 1024)
+
+/*
+ * Reverses the byte order of a single value. Standard `std::byteswap` is used when available
+ * (C++23), otherwise the compiler built-in. Both compile to a single `bswap` or `rev` instruction.
+ */
+template<typename T> inline T byteswap(T value) {
+    #ifdef __cpp_lib_byteswap
+    return std::byteswap(value);
+    #else
+    if constexpr (sizeof(T) == 2) return __builtin_bswap16(value);
+    if constexpr (sizeof(T) == 4) return __builtin_bswap32(value);
+    if constexpr (sizeof(T) == 8) return __builtin_bswap64(value);
+    #endif
+}
+
+/*
+ * Reads the value at the given address, stored in the given byte order, and returns it in native byte order.
+ * When the byte order is not the native one, the bytes are swapped in a register after the load, which allows
+ * to use a file mapped in memory without copy. The `memcpy` call is optimized away.
+ */
+template<std::endian ORDER, typename T> inline T load(const T* address) {
+    if constexpr (ORDER == std::endian::native) {
+        return *address;
+    } else {
+        static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Unsupported element size.");
+        typedef std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t> Bits;
+        Bits bits;
+        memcpy(&bits, address, sizeof(T));
+        return std::bit_cast<T>(byteswap(bits));
+    }
+}
+
+/*
+ * Copies `numBytes` bytes from `source` to `target` while reversing the byte order of each element.
+ * The element size can be 2, 4 or 8 bytes, and `numBytes` must be a multiple of that size.
+ * The `source` and `target` pointers may be the same for swapping the bytes in place.
+ */
+void swapBytes(const void* source, void* target, size_t numBytes, int elementSize);
+
+/*
+ * Reads `numBytes` bytes from the given stream and stores them in `target` with the byte order of each
+ * element reversed. The bytes are read and swapped by chunks of `SWAP_CHUNK_SIZE` bytes, so that each
+ * chunk is swapped while still in the cache instead of in a second pass over the whole array.
+ * An element size of 1 means that no swapping is done. Returns whether all bytes have been read.
+ */
+bool readAndSwap(std::istream& stream, char* target, size_t numBytes, int elementSize);
+
+#endif
@@ -0,0 +1,58 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include "TestCase.hpp"
+
+/*
+ * Compresses the raster of the "nan" and "nodata" sub-directories of the data directory in "raster.nanz" files,
+ * with tiles of `config.tileSize` pixels. Then, decodes each file with all processors and verifies that all bit
+ * patterns are restored. See `Configuration::parse(…)` for the command-line options.
+ */
+int main(int argc, char** argv) {
+    if (!config.parse(argc, argv)) {
+        return 1;
+    }
+    const size_t numValues = (size_t) config.width * config.height;
+    const int numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<float> decoded(numValues);
+    DataCache cache;
+    printf("%-8s %14s %14s %8s %12s\n", "Raster", "Raw (bytes)", "Compressed", "Ratio", "Decode (ms)");
+    for (int useNaN = 1; useNaN >= 0; useNaN--) {
+        const float* values = cache.raster(useNaN, std::endian::native, RasterLayout(config.width, config.height, 0));
+        if (!values) {
+            std::cout << "Cannot read the raster in " << cache.file(useNaN, "") << ".\n";
+            return 1;
+        }
+        std::vector<uint8_t> bytes = compressRaster(values, config.width, config.height, config.tileSize);
+        std::filesystem::path file = cache.file(useNaN, "raster.nanz");
+        std::ofstream out(file, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        out.close();
+        if (!out) {
+            std::cout << "Cannot write " << file << ".\n";
+            return 1;
+        }
+        CompressedRaster compressed;
+        std::fill(decoded.begin(), decoded.end(), 0.0f);
+        auto startTime = std::chrono::high_resolution_clock::now();
+        bool success = compressed.attach(bytes.data(), bytes.size()) && compressed.decodeAll(decoded.data(), numThreads);
+        auto endTime = std::chrono::high_resolution_clock::now();
+        if (!success || memcmp(decoded.data(), values, numValues * sizeof(float)) != 0) {
+            std::cout << "TEST FAILURE: the decoded raster is not identical to the original one.\n";
+            return 1;
+        }
+        printf("%-8s %14zu %14zu %8.3f %12.3f\n", useNaN ? "nan" : "nodata", numValues * sizeof(float), bytes.size(),
+               (double) bytes.size() / (numValues * sizeof(float)),
+               duration_cast<std::chrono::nanoseconds>(endTime - startTime).count() / 1E6);
+    }
+    return 0;
+}
@@ -0,0 +1,438 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <algorithm>
+#include "CompressedRaster.hpp"
+
+/*
+ * Size of the fixed part of the header: the magic number, the version, the width, the height,
+ * the tile size and the number of tiles. The offsets of the tiles follow.
+ */
+#define HEADER_SIZE 24
+#define FORMAT_VERSION 1
+static const uint8_t MAGIC[4] = {'N', 'a', 'N', 'Z'};
+
+/*
+ * Maximal number of bytes in a PackBits literal block and in a PackBits repeated block.
+ */
+#define MAX_LITERAL 128
+#define MAX_REPEAT  129
+
+/*
+ * Encoding of a plane of the valid values, given by the byte before the plane.
+ */
+#define PLANE_RAW      0
+#define PLANE_PACKBITS 1
+
+/*
+ * A run of pixels in a tile: either identical NaN, or valid values taken from the shuffled planes.
+ */
+struct Run {
+    uint32_t length;
+    bool     isNaN;
+    uint32_t bits;
+};
+
+/*
+ * Returns whether the given bit pattern is a NaN. This is tested on the bits rather than
+ * with `std::isnan` for having the same result no matter the compiler options.
+ */
+static inline bool isNaN(uint32_t bits) {
+    return (bits & 0x7FFFFFFF) > 0x7F800000;
+}
+
+/*
+ * Returns whether a run of at least two identical NaN starts at the given index. Isolated NaN are stored
+ * with the valid values, because a run would take more space than their 4 bytes in the shuffled planes.
+ */
+static inline bool startsNaNRun(const std::vector<uint32_t>& pixels, size_t i) {
+    return i + 1 < pixels.size() && isNaN(pixels[i]) && pixels[i + 1] == pixels[i];
+}
+
+/*
+ * Appends the `n` lowest bytes of the given value in little-endian byte order.
+ */
+static void putLittleEndian(std::vector<uint8_t>& out, uint64_t value, int n) {
+    for (int i=0; i<n; i++) {
+        out.push_back((uint8_t) (value >> (8*i)));
+    }
+}
+
+/*
+ * Decodes `n` bytes in little-endian byte order. The caller shall have verified the bounds.
+ */
+static uint64_t getLittleEndian(const uint8_t* in, int n) {
+    uint64_t value = 0;
+    for (int i=0; i<n; i++) {
+        value |= (uint64_t) in[i] << (8*i);
+    }
+    return value;
+}
+
+/*
+ * Appends a variable-length integer: 7 bits per byte, lowest bits first,
+ * with the highest bit set in all bytes except the last one.
+ */
+static void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t) (value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t) value);
+}
+
+/*
+ * Decodes a variable-length integer and advances the cursor. Returns false if the end is reached before the last byte.
+ */
+static bool getVarint(const uint8_t*& in, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; in < end && shift < 64; shift += 7) {
+        uint8_t b = *in++;
+        value |= (uint64_t) (b & 0x7F) << shift;
+        if (b < 0x80) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Appends the given bytes compressed with PackBits. A control byte `c` from 0 to 127 is followed by `c + 1` literal bytes.
+ * A control byte from 128 to 255 is followed by one byte to repeat `c - 126` times. Runs shorter than 3 bytes are stored
+ * as literals, because they would not be shorter as repeated blocks and would break the literal blocks.
+ */
+static void packBits(const uint8_t* in, size_t n, std::vector<uint8_t>& out) {
+    size_t i = 0;
+    while (i < n) {
+        size_t run = 1;
+        while (i + run < n && run < MAX_REPEAT && in[i + run] == in[i]) run++;
+        if (run >= 3) {
+            out.push_back((uint8_t) (run + 126));
+            out.push_back(in[i]);
+            i += run;
+            continue;
+        }
+        size_t start = i;
+        while (i < n && i - start < MAX_LITERAL) {
+            if (i + 2 < n && in[i] == in[i+1] && in[i] == in[i+2]) break;
+            i++;
+        }
+        out.push_back((uint8_t) (i - start - 1));
+        out.insert(out.end(), in + start, in + i);
+    }
+}
+
+/*
+ * Decodes exactly `n` bytes compressed with PackBits and advances the cursor.
+ * Returns false if the compressed bytes are invalid.
+ */
+static bool unpackBits(const uint8_t*& in, const uint8_t* end, uint8_t* out, size_t n) {
+    size_t i = 0;
+    while (i < n) {
+        if (in >= end) return false;
+        unsigned c = *in++;
+        if (c < 128) {
+            size_t count = c + 1;
+            if (count > n - i || count > (size_t) (end - in)) return false;
+            memcpy(out + i, in, count);
+            in += count;
+            i  += count;
+        } else {
+            size_t count = c - 126;
+            if (count > n - i || in >= end) return false;
+            memset(out + i, *in++, count);
+            i += count;
+        }
+    }
+    return true;
+}
+
+/*
+ * Compresses the given raster in row-major order, with tiles of `tileSize` × `tileSize` pixels.
+ * Returns the bytes of the file, including the header.
+ */
+std::vector<uint8_t> compressRaster(const float* values, int width, int height, int tileSize) {
+    const int tilesPerRow    = (width  + tileSize - 1) / tileSize;
+    const int tilesPerColumn = (height + tileSize - 1) / tileSize;
+    const int numTiles = tilesPerRow * tilesPerColumn;
+    std::vector<uint8_t> out(MAGIC, MAGIC + 4);
+    putLittleEndian(out, FORMAT_VERSION, 4);
+    putLittleEndian(out, width,    4);
+    putLittleEndian(out, height,   4);
+    putLittleEndian(out, tileSize, 4);
+    putLittleEndian(out, numTiles, 4);
+    out.resize(HEADER_SIZE + (numTiles + 1) * sizeof(uint64_t));
+    const uint32_t* source = reinterpret_cast<const uint32_t*>(values);
+    std::vector<uint32_t> pixels, valid;
+    std::vector<Run> runs;
+    std::vector<uint8_t> plane;
+    for (int tile = 0; tile < numTiles; tile++) {
+        uint64_t offset = out.size();
+        for (int i=0; i<8; i++) {
+            out[HEADER_SIZE + tile * sizeof(uint64_t) + i] = (uint8_t) (offset >> (8*i));
+        }
+        /*
+         * Collect the pixels of the tile in row-major order, then split them in runs of identical NaN
+         * and runs of other values. Consecutive valid values are accumulated for the shuffled planes.
+         */
+        int x0 = (tile % tilesPerRow) * tileSize;
+        int y0 = (tile / tilesPerRow) * tileSize;
+        int tw = std::min(tileSize, width  - x0);
+        int th = std::min(tileSize, height - y0);
+        pixels.clear();
+        for (int y = y0; y < y0 + th; y++) {
+            pixels.insert(pixels.end(), source + (size_t) y * width + x0, source + (size_t) y * width + x0 + tw);
+        }
+        runs.clear();
+        valid.clear();
+        for (size_t i = 0; i < pixels.size();) {
+            size_t j = i + 1;
+            if (startsNaNRun(pixels, i)) {
+                while (j < pixels.size() && pixels[j] == pixels[i]) j++;
+                runs.push_back({(uint32_t) (j - i), true, pixels[i]});
+            } else {
+                while (j < pixels.size() && !startsNaNRun(pixels, j)) j++;
+                runs.push_back({(uint32_t) (j - i), false, 0});
+                valid.insert(valid.end(), pixels.begin() + i, pixels.begin() + j);
+            }
+            i = j;
+        }
+        putVarint(out, runs.size());
+        putVarint(out, valid.size());
+        for (const Run& run : runs) {
+            putVarint(out, ((uint64_t) run.length << 1) | run.isNaN);
+            if (run.isNaN) {
+                putLittleEndian(out, run.bits, 4);
+            }
+        }
+        plane.resize(valid.size());
+        for (int k=0; k<4; k++) {
+            for (size_t i=0; i<valid.size(); i++) {
+                plane[i] = (uint8_t) (valid[i] >> (8*k));
+            }
+            size_t start = out.size();
+            out.push_back(PLANE_PACKBITS);
+            packBits(plane.data(), plane.size(), out);
+            if (out.size() - start > plane.size()) {
+                out.resize(start);
+                out.push_back(PLANE_RAW);
+                out.insert(out.end(), plane.begin(), plane.end());
+            }
+        }
+    }
+    uint64_t end = out.size();
+    for (int i=0; i<8; i++) {
+        out[HEADER_SIZE + numTiles * sizeof(uint64_t) + i] = (uint8_t) (end >> (8*i));
+    }
+    return out;
+}
+
+/*
+ * Creates a raster without data. The `attach(…)` method shall be invoked before to decode tiles.
+ */
+CompressedRaster::CompressedRaster() {
+    bytes       = NULL;
+    length      = 0;
+    tilesPerRow = 0;
+    width       = 0;
+    height      = 0;
+    tileSize    = 0;
+}
+
+/*
+ * Reads the header of the given compressed bytes. Returns false if the header is invalid.
+ * The bytes are not copied, and shall stay valid as long as tiles are decoded.
+ */
+bool CompressedRaster::attach(const void* data, size_t numBytes) {
+    bytes  = static_cast<const uint8_t*>(data);
+    length = numBytes;
+    offsets.clear();
+    if (numBytes < HEADER_SIZE || memcmp(bytes, MAGIC, 4) != 0 || getLittleEndian(bytes + 4, 4) != FORMAT_VERSION) {
+        return false;
+    }
+    width    = (int) getLittleEndian(bytes +  8, 4);
+    height   = (int) getLittleEndian(bytes + 12, 4);
+    tileSize = (int) getLittleEndian(bytes + 16, 4);
+    uint64_t count = getLittleEndian(bytes + 20, 4);
+    if (width <= 0 || height <= 0 || tileSize <= 0) {
+        return false;
+    }
+    tilesPerRow = (width + tileSize - 1) / tileSize;
+    if (count != (uint64_t) tilesPerRow * ((height + tileSize - 1) / tileSize) ||
+        numBytes < HEADER_SIZE + (count + 1) * sizeof(uint64_t))
+    {
+        return false;
+    }
+    uint64_t previous = HEADER_SIZE + (count + 1) * sizeof(uint64_t);
+    for (uint64_t i=0; i<=count; i++) {
+        uint64_t offset = getLittleEndian(bytes + HEADER_SIZE + i * sizeof(uint64_t), 8);
+        if (offset < previous || offset > numBytes) {
+            offsets.clear();
+            return false;
+        }
+        offsets.push_back(previous = offset);
+    }
+    return true;
+}
+
+/*
+ * Returns the number of bytes of the compressed raster, including the header.
+ */
+size_t CompressedRaster::compressedSize() const {
+    return offsets.empty() ? 0 : offsets.back();
+}
+
+/*
+ * Returns the number of tiles, or 0 if no valid raster has been attached.
+ */
+int CompressedRaster::numTiles() const {
+    return offsets.empty() ? 0 : (int) offsets.size() - 1;
+}
+
+/*
+ * Decodes the given tile in a raster of `width` × `height` pixels in row-major order.
+ * Only the pixels of the tile are written. Returns false if the compressed bytes are invalid.
+ * This method can be invoked concurrently by different threads, for different tiles.
+ */
+bool CompressedRaster::decodeTile(int tile, float* target) const {
+    if (tile < 0 || tile >= numTiles()) {
+        return false;
+    }
+    const uint8_t* in  = bytes + offsets[tile];
+    const uint8_t* end = bytes + offsets[tile + 1];
+    const int x0 = (tile % tilesPerRow) * tileSize;
+    const int y0 = (tile / tilesPerRow) * tileSize;
+    const int tw = std::min(tileSize, width  - x0);
+    const int th = std::min(tileSize, height - y0);
+    const uint64_t numPixels = (uint64_t) tw * th;
+    uint64_t numRuns, numValid;
+    if (!getVarint(in, end, numRuns) || !getVarint(in, end, numValid) || numRuns > numPixels || numValid > numPixels) {
+        return false;
+    }
+    /*
+     * Read the runs first, because the planes of valid values are after them.
+     */
+    std::vector<Run> runs(numRuns);
+    uint64_t total = 0, totalValid = 0;
+    for (Run& run : runs) {
+        uint64_t token;
+        if (!getVarint(in, end, token)) return false;
+        run.length = (uint32_t) (token >> 1);
+        run.isNaN  = (token & 1) != 0;
+        if (run.isNaN) {
+            if (end - in < 4) return false;
+            run.bits = (uint32_t) getLittleEndian(in, 4);
+            in += 4;
+        } else {
+            totalValid += run.length;
+        }
+        total += run.length;
+    }
+    if (total != numPixels || totalValid != numValid) {
+        return false;
+    }
+    std::vector<uint8_t> planes(4 * numValid);
+    for (int k=0; k<4; k++) {
+        uint8_t* plane = &planes[k * numValid];
+        if (in >= end) {
+            return false;
+        }
+        uint8_t mode = *in++;
+        if (mode == PLANE_RAW && (uint64_t) (end - in) >= numValid) {
+            memcpy(plane, in, numValid);
+            in += numValid;
+        } else if (mode != PLANE_PACKBITS || !unpackBits(in, end, plane, numValid)) {
+            return false;
+        }
+    }
+    /*
+     * Write the runs in the tile, splitting them at the end of each row of the tile.
+     */
+    uint32_t* out = reinterpret_cast<uint32_t*>(target);
+    uint64_t pixel = 0, next = 0;
+    for (const Run& run : runs) {
+        uint64_t remaining = run.length;
+        while (remaining != 0) {
+            int row = (int) (pixel / tw);
+            int col = (int) (pixel % tw);
+            int n   = (int) std::min<uint64_t>(remaining, tw - col);
+            uint32_t* rowStart = out + (size_t) (y0 + row) * width + x0 + col;
+            if (run.isNaN) {
+                std::fill(rowStart, rowStart + n, run.bits);
+            } else {
+                for (int i=0; i<n; i++, next++) {
+                    rowStart[i] =  (uint32_t) planes[next]
+                                 | ((uint32_t) planes[next +     numValid] <<  8)
+                                 | ((uint32_t) planes[next + 2 * numValid] << 16)
+                                 | ((uint32_t) planes[next + 3 * numValid] << 24);
+                }
+            }
+            pixel     += n;
+            remaining -= n;
+        }
+    }
+    return true;
+}
+
+/*
+ * Decodes all tiles in a raster of `width` × `height` pixels in row-major order, using the given number of threads.
+ * Returns false if the compressed bytes are invalid.
+ */
+bool CompressedRaster::decodeAll(float* target, int numThreads) const {
+    const int n = numTiles();
+    numThreads = std::max(1, std::min(numThreads, n));
+    std::vector<uint8_t> success(numThreads);
+    auto worker = [this, target, n, numThreads, &success](int t) {
+        bool ok = true;
+        for (int tile = t; tile < n; tile += numThreads) {
+            ok &= decodeTile(tile, target);
+        }
+        success[t] = ok;
+    };
+    std::vector<std::thread> workers;
+    for (int t=1; t<numThreads; t++) {
+        workers.emplace_back(worker, t);
+    }
+    worker(0);
+    for (std::thread& w : workers) {
+        w.join();
+    }
+    return n != 0 && std::all_of(success.begin(), success.end(), [](uint8_t ok) {return ok;});
+}
+
+/*
+ * Decodes the tiles containing the four pixels used by the bilinear interpolation of each of the `count` points,
+ * if not already decoded. The `decoded` vector tells which tiles are already decoded, and is updated by this method.
+ * It is resized to the number of tiles if needed, so it can be initially empty. Points out of bounds are ignored.
+ * Returns the number of tiles decoded by this call, or -1 if the compressed bytes are invalid.
+ */
+int CompressedRaster::decodeTouched(const double* xy, int count, float* target, std::vector<uint8_t>& decoded) const {
+    decoded.resize(numTiles());
+    int numDecoded = 0;
+    for (int i=0; i<count; i++) {
+        double x = std::floor(xy[2*i]);
+        double y = std::floor(xy[2*i + 1]);
+        if (!(x >= 0 && y >= 0 && x < width - 1 && y < height - 1)) {
+            continue;
+        }
+        int tx0 = (int) x / tileSize, tx1 = ((int) x + 1) / tileSize;
+        int ty0 = (int) y / tileSize, ty1 = ((int) y + 1) / tileSize;
+        for (int ty = ty0; ty <= ty1; ty++) {
+            for (int tx = tx0; tx <= tx1; tx++) {
+                int tile = ty * tilesPerRow + tx;
+                if (!decoded[tile]) {
+                    if (!decodeTile(tile, target)) {
+                        return -1;
+                    }
+                    decoded[tile] = 1;
+                    numDecoded++;
+                }
+            }
+        }
+    }
+    return numDecoded;
+}
@@ -0,0 +1,68 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#ifndef COMPRESSED_RASTER_HPP
+#define COMPRESSED_RASTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * A raster of `float` values compressed by tiles, which can be decoded independently and in parallel.
+ * The file starts with the following header, where all integers are in little-endian byte order:
+ *
+ *   - The magic number "NaNZ" followed by the format version (currently 1) as a 32 bits integer.
+ *   - The raster width, height and tile size as 32 bits integers, then the number of tiles.
+ *   - The offsets in bytes from the beginning of the file to each tile, as 64 bits integers.
+ *     An additional offset after the last tile gives the end of the last tile.
+ *
+ * Tiles are in row-major order, and the pixels in each tile too. Tiles on the right and bottom edges are clipped
+ * to the raster bounds. Each tile is encoded as a sequence of runs followed by the compressed valid values:
+ *
+ *   - The number of runs and the number of valid values, as variable-length integers.
+ *   - For each run, a variable-length integer with the run length shifted left by one bit, and the lowest bit set
+ *     for a run of identical NaN. The latter are followed by the bit pattern of the NaN (4 bytes). Runs with the
+ *     lowest bit cleared are the other values, taken in order from the compressed valid values. Isolated NaN
+ *     are in the latter runs.
+ *   - The valid values, shuffled in 4 planes where plane `k` contains byte `k` of the little-endian representation
+ *     of all valid values of the tile. Each plane starts with a byte which is 1 if the plane is compressed with
+ *     a PackBits run-length encoding, or 0 if the plane is stored without compression.
+ *
+ * The byte shuffling puts the sign and exponent bytes together in the last plane, where they repeat often because
+ * the values of a raster are usually in a small range. The NaN runs make areas of missing values (e.g. clouds or lands)
+ * almost free, without loss of the payloads. Variable-length integers use 7 bits per byte, lowest bits first.
+ *
+ * An instance of this class does not own the compressed bytes. The caller shall keep them alive.
+ */
+class CompressedRaster {
+    /*
+     * The compressed bytes, including the header.
+     */
+    const uint8_t* bytes;
+    size_t length;
+
+    /*
+     * Number of tiles in a row, and the offsets of each tile in `bytes`.
+     */
+    int tilesPerRow;
+    std::vector<uint64_t> offsets;
+
+    public:
+        int width;
+        int height;
+        int tileSize;
+
+        CompressedRaster();
+        bool   attach(const void* bytes, size_t length);
+        size_t compressedSize() const;
+        int    numTiles() const;
+        bool   decodeTile(int tile, float* target) const;
+        bool   decodeAll(float* target, int numThreads) const;
+        int    decodeTouched(const double* xy, int count, float* target, std::vector<uint8_t>& decoded) const;
+};
+
+std::vector<uint8_t> compressRaster(const float* values, int width, int height, int tileSize);
+
+#endif
@@ -0,0 +1,172 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cstdio>
+#include <climits>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include "Distributed.hpp"
+
+/*
+ * Statistics of one iteration in the reduction of the results of all ranks. The number of mismatches
+ * is stored as a `double` for allowing the use of a single MPI type, and is exact up to 2⁵³.
+ */
+struct IterationResult {
+    double maxError;
+    double mismatches;
+};
+
+/*
+ * The reduction operation on arrays of `IterationResult`: maximum of the errors and sum of the mismatches.
+ */
+static void combineResults(void* in, void* inout, int* length, MPI_Datatype*) {
+    const IterationResult* source = static_cast<const IterationResult*>(in);
+    IterationResult* target = static_cast<IterationResult*>(inout);
+    for (int i=0; i < *length; i++) {
+        target[i].maxError    = std::max(target[i].maxError, source[i].maxError);
+        target[i].mismatches += source[i].mismatches;
+    }
+}
+
+/*
+ * Creates a new test distributed over all ranks of the given communicator. Each rank gets a range of points
+ * which is a multiple of the batch size of the vectorized kernels, except the last range.
+ */
+TestNaNDistributed::TestNaNDistributed(Arena& arena, DataCache& cache, MPI_Comm comm)
+        : TestNaN(arena, cache, std::endian::native, 0)
+{
+    communicator = comm;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &numRanks);
+    const int numPoints  = config.numInterpolationPoints;
+    const int numBatches = (numPoints + SIMD_BATCH_SIZE - 1) / SIMD_BATCH_SIZE;
+    const int chunkSize  = ((numBatches + numRanks - 1) / numRanks) * SIMD_BATCH_SIZE;
+    firstPoint    = std::min(rank * chunkSize, numPoints);
+    lastPoint     = std::min(firstPoint + chunkSize, numPoints);
+    broadcastTime = 0;
+}
+
+/*
+ * Reads the raster on rank 0 and sends it to all other ranks. The values are sent in chunks
+ * because the number of elements in an MPI message is an `int`. Returns NULL on all ranks
+ * if rank 0 cannot read the raster.
+ */
+const float* TestNaNDistributed::broadcastRaster() {
+    const size_t numValues = (size_t) config.width * config.height;
+    const float* values = (rank == 0) ? loadRaster() : NULL;
+    int available = (rank != 0 || values != NULL);
+    MPI_Bcast(&available, 1, MPI_INT, 0, communicator);
+    if (!available) {
+        return NULL;
+    }
+    if (rank != 0) {
+        values = arena.allocate<float>(numValues);
+    }
+    auto startTime = std::chrono::high_resolution_clock::now();
+    float* buffer = const_cast<float*>(values);         // Only read by rank 0.
+    for (size_t start = 0; start < numValues; start += INT_MAX) {
+        int count = (int) std::min(numValues - start, (size_t) INT_MAX);
+        MPI_Bcast(buffer + start, count, MPI_UINT32_T, 0, communicator);
+    }
+    auto endTime = std::chrono::high_resolution_clock::now();
+    broadcastTime = duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+    return values;
+}
+
+/*
+ * Performs the interpolations of the points of this rank, then combines the statistics of all ranks.
+ * All ranks shall invoke this method, and all ranks get the combined statistics. The returned time
+ * includes the reduction, but not the broadcast of the raster which is measured separately.
+ */
+double TestNaNDistributed::computeAndCompare() {
+    std::chrono::time_point<std::chrono::high_resolution_clock> startTime, endTime;
+    const float* values = broadcastRaster();
+    if (values) {
+        const int width         = config.width;
+        const int height        = config.height;
+        const int numIterations = config.numVerifiedIterations;
+        const int count         = lastPoint - firstPoint;
+        /*
+         * All ranks shall take part in the reduction, so a rank which cannot read its files
+         * does not return before the others know. This is decided before the computation.
+         */
+        Raster raster(values, width, height);
+        double* coordinates = loadCoordinates();
+        ExpectedResults expectedResults;
+        int ready = (coordinates != NULL) && openExpectedResults(expectedResults, firstPoint, count);
+        MPI_Allreduce(MPI_IN_PLACE, &ready, 1, MPI_INT, MPI_MIN, communicator);
+        if (ready) {
+            IterationResult* local  = arena.allocate<IterationResult>(numIterations, true);
+            IterationResult* global = arena.allocate<IterationResult>(numIterations, true);
+            double  results[SIMD_BATCH_SIZE];
+            int32_t reasons[SIMD_BATCH_SIZE];
+            uint64_t total[NUM_PERF_COUNTERS], snapshot[NUM_PERF_COUNTERS];
+            MPI_Barrier(communicator);
+            startTime = std::chrono::high_resolution_clock::now();
+            startCounters(total);
+            for (int it=0; it<numIterations; it++) {
+                startCounters(snapshot);
+                const double* expectedResultCursor = expectedResults.next();
+                if (!expectedResultCursor) {
+                    std::cout << "Cannot read the expected results of iteration " << it << " on rank " << rank << ".\n";
+                    MPI_Abort(communicator, 1);
+                }
+                double stats = 0;
+                int mismatches = 0;
+                for (int start = firstPoint; start < lastPoint; start += SIMD_BATCH_SIZE) {
+                    int n = std::min(SIMD_BATCH_SIZE, lastPoint - start);
+                    double* batch = coordinates + 2*start;
+                    if (interpolate(raster, std::span<const double>(batch, 2*n), std::span(results, n), std::span(reasons, n)) != n) {
+                        std::cout << "Coordinates out of bounds in iteration " << it << " on rank " << rank << ".\n";
+                        MPI_Abort(communicator, 1);
+                    }
+                    const double* expectedValues = expectedResultCursor + (start - firstPoint);
+                    for (int i=0; i<n; i++) {
+                        double nodata = (reasons[i] - FIRST_QUIET_NAN) + MISSING_VALUE_THRESHOLD;
+                        double result = verifyResult(isMissing(results[i]), nodata, results[i], expectedValues[i], mismatches, stats);
+                        movePoint(batch + 2*i, result, width, height);
+                    }
+                }
+                local[it].maxError   = stats;
+                local[it].mismatches = mismatches;
+                stopCounters(snapshot, it);
+            }
+            /*
+             * The single reduction of the statistics of all iterations.
+             */
+            MPI_Datatype type;
+            MPI_Op operation;
+            MPI_Type_contiguous(2, MPI_DOUBLE, &type);
+            MPI_Type_commit(&type);
+            MPI_Op_create(combineResults, 1, &operation);
+            MPI_Allreduce(local, global, numIterations, type, operation, communicator);
+            MPI_Op_free(&operation);
+            MPI_Type_free(&type);
+            for (int it=0; it<numIterations; it++) {
+                errorStatistics [it] = global[it].maxError;
+                nodataMismatches[it] = (int) global[it].mismatches;
+            }
+            stopCounters(total, numIterations);
+            endTime = std::chrono::high_resolution_clock::now();
+        }
+    }
+    return duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+/*
+ * Returns whether the combined statistics are equal to the statistics of the given test.
+ */
+bool TestNaNDistributed::sameResults(TestCase* other) {
+    return resultEquals(other);
+}
+
+/*
+ * Prints the number of ranks, the number of points of this rank and the time spent in broadcasting the raster.
+ */
+void TestNaNDistributed::printDetails() const {
+    printf("Ranks: %d, points on rank %d: %d, raster broadcast: %.3f ms\n",
+           numRanks, rank, lastPoint - firstPoint, broadcastTime / 1E6);
+}
@@ -0,0 +1,48 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#ifndef DISTRIBUTED_HPP
+#define DISTRIBUTED_HPP
+
+#include <mpi.h>
+#include "TestCase.hpp"
+
+/*
+ * Same calculation as `TestNaN` but with the points distributed over the ranks of an MPI communicator,
+ * which may be processes on different nodes. The raster is read by rank 0 only and broadcast once to the
+ * other ranks, as 32 bits integers for making sure that no conversion alters the NaN payloads. Each rank
+ * reads the coordinates and the expected results of its own range of points, and executes the chain of all
+ * iterations on that range, because that chain does not depend on other points.
+ *
+ * The statistics of all ranks are combined with a single reduction at the end: the maximum of the errors
+ * and the sum of the mismatches of each iteration. Those operations are associative, so the results are
+ * identical to the ones of `TestNaN` regardless the number of ranks.
+ */
+class TestNaNDistributed : public TestNaN {
+    /*
+     * The communicator of the ranks sharing the computation, the rank of this process and the number of ranks.
+     */
+    MPI_Comm communicator;
+    int rank, numRanks;
+
+    /*
+     * The range of points of this rank, from `firstPoint` inclusive to `lastPoint` exclusive.
+     */
+    int firstPoint, lastPoint;
+
+    /*
+     * Time in nanoseconds spent in broadcasting the raster during the last execution.
+     */
+    double broadcastTime;
+
+    const float* broadcastRaster();
+
+    public:
+        TestNaNDistributed(Arena& arena, DataCache& cache, MPI_Comm communicator);
+        double computeAndCompare();
+        bool   sameResults(TestCase*);
+        void   printDetails() const;
+};
+
+#endif
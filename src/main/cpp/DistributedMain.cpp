@@ -0,0 +1,53 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cstdio>
+#include <iostream>
+#include "Distributed.hpp"
+
+/*
+ * Runs the test distributed over all ranks, then verifies on rank 0 that the combined statistics
+ * are the same as the statistics of the test executed in a single process.
+ * Returns the exit code of the process.
+ */
+static int run(int rank) {
+    Arena arena;
+    DataCache cache;
+    TestNaNDistributed test(arena, cache, MPI_COMM_WORLD);
+    double time = test.computeAndCompare();
+    if (rank != 0) {
+        return (time > 0) ? 0 : 1;
+    }
+    TestNaN reference(arena, cache, std::endian::native, 0);
+    double referenceTime = reference.computeAndCompare();
+    if (time <= 0 || referenceTime <= 0) {
+        std::cout << "TEST FAILURE (are the data files present and matching the options?)\n";
+        return 1;
+    }
+    test.printStatistics();
+    printf("Time: %.3f ms (including the reduction), single process time: %.3f ms\n",
+           time / 1E6, referenceTime / 1E6);
+    bool same = test.sameResults(&reference);
+    std::cout << "Same statistics as a single process: " << (same ? "yes" : "no") << '\n';
+    if (!same || !test.success()) {
+        std::cout << "TEST FAILURE.\n";
+        return 1;
+    }
+    std::cout << "Success (mismatches in the last iterations are normal).\n";
+    return 0;
+}
+
+/*
+ * Runs the NaN test with the points distributed over the ranks of `MPI_COMM_WORLD`.
+ * Example: `mpirun -n 4 ./NaN-distributed`. All ranks shall have access to the data files,
+ * except the raster which is read by rank 0 only. See `Configuration::parse(…)` for the options.
+ */
+int main(int argc, char** argv) {
+    MPI_Init(&argc, &argv);
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    int status = config.parse(argc, argv) ? run(rank) : 1;
+    MPI_Finalize();
+    return status;
+}
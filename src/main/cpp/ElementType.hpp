@@ -0,0 +1,156 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#ifndef ELEMENT_TYPE_HPP
+#define ELEMENT_TYPE_HPP
+
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * IEEE 754 half-precision value (1 sign bit, 5 exponent bits, 10 mantissa bits), stored as its bit pattern.
+ * The arithmetic is done after conversion to `float`, so only the storage is in half-precision. Quiet NaNs
+ * have 9 bits of payload, which is enough for 512 missing value reasons.
+ */
+struct Half {
+    uint16_t bits;
+};
+
+/*
+ * "Brain floating point" value (1 sign bit, 8 exponent bits, 7 mantissa bits), stored as its bit pattern.
+ * This is the 16 most significant bits of a `float`, so it has the same range but less precision.
+ * Quiet NaNs have 6 bits of payload, which is enough for 64 missing value reasons.
+ */
+struct BFloat16 {
+    uint16_t bits;
+};
+
+/*
+ * Properties of the types of the raster elements. Each specialization defines the following members:
+ *
+ *   - `Bits`:            signed integer type of the same size as the element, for comparing NaN payloads.
+ *   - `Value`:           type in which the element is used in calculations (`float` or `double`).
+ *   - `FIRST_QUIET_NAN`: bit pattern of the first positive quiet NaN, as a signed integer.
+ *   - `EXACT`:           whether all `float` values of the test can be stored without rounding.
+ *   - `TOLERANCE`:       if not exact, the maximal rounding error of the values of the test, in ±100.
+ *   - `bits(e)`:         the bit pattern of the element, compared as signed integers for NaN payload precedence.
+ *   - `value(e)`:        the element converted to the type used in calculations.
+ *   - `fromFloat(v)`:    the element for a `float` value, with NaN payloads moved to the payload bits.
+ *
+ * The conversions of NaN copy the payload explicitly instead of relying on the hardware conversion,
+ * which keeps the payload in the most significant bits of the mantissa where they would be lost
+ * by a 16 bits type. The sign bit is preserved. Payloads too large for the target type are truncated.
+ */
+template<typename T> struct ElementType;
+
+/*
+ * Single-precision values, used as-is. This is the type of the data files.
+ */
+template<> struct ElementType<float> {
+    typedef int32_t Bits;
+    typedef float   Value;
+    static constexpr Bits   FIRST_QUIET_NAN = 0x7FC00000;
+    static constexpr bool   EXACT = true;
+    static constexpr double TOLERANCE = 0;
+    static inline Bits  bits(float e)      {return std::bit_cast<Bits>(e);}
+    static inline float value(float e)     {return e;}
+    static inline float fromFloat(float v) {return v;}
+};
+
+/*
+ * Double-precision values. Quiet NaNs have 51 bits of payload, which is more than 10¹⁵ reasons.
+ */
+template<> struct ElementType<double> {
+    typedef int64_t Bits;
+    typedef double  Value;
+    static constexpr Bits   FIRST_QUIET_NAN = 0x7FF8000000000000;
+    static constexpr bool   EXACT = true;
+    static constexpr double TOLERANCE = 0;
+    static inline Bits   bits(double e)  {return std::bit_cast<Bits>(e);}
+    static inline double value(double e) {return e;}
+    static inline double fromFloat(float v) {
+        uint32_t f = std::bit_cast<uint32_t>(v);
+        if ((f & 0x7FFFFFFF) > 0x7F800000) {
+            uint64_t sign = (uint64_t) (f & 0x80000000) << 32;
+            return std::bit_cast<double>(sign | FIRST_QUIET_NAN | (f & 0x003FFFFF));
+        }
+        return v;
+    }
+};
+
+/*
+ * Half-precision values. The conversion to `float` is branch-free. The subnormal numbers are converted with
+ * an integer to float conversion instead of a multiplication, because `-ffast-math` may flush the latter to zero.
+ */
+template<> struct ElementType<Half> {
+    typedef int16_t Bits;
+    typedef float   Value;
+    static constexpr Bits   FIRST_QUIET_NAN = 0x7E00;
+    static constexpr bool   EXACT = false;
+    static constexpr double TOLERANCE = 0x1p-5;         // Half of the spacing between values in [64 … 128].
+    static inline Bits bits(Half e) {return (Bits) e.bits;}
+
+    static inline float value(Half e) {
+        uint32_t sign   = (uint32_t) (e.bits & 0x8000) << 16;
+        uint32_t em     = e.bits & 0x7FFF;
+        float    normal = std::bit_cast<float>(em << 13) * 0x1p112f;
+        float    small  = (float) em * 0x1p-24f;
+        uint32_t bits   = std::bit_cast<uint32_t>((em < 0x0400) ? small : normal);
+        bits = (em >= 0x7C00) ? (0x7F800000 | ((em & 0x03FF) << 13)) : bits;     // Infinity and NaN.
+        return std::bit_cast<float>(bits | sign);
+    }
+
+    static inline Half fromFloat(float v) {
+        uint32_t f    = std::bit_cast<uint32_t>(v);
+        uint16_t sign = (f >> 16) & 0x8000;
+        f &= 0x7FFFFFFF;
+        if (f > 0x7F800000) {
+            return {(uint16_t) (sign | FIRST_QUIET_NAN | (f & 0x01FF))};
+        }
+        if (f >= 0x477FF000) {                              // Values rounded to infinity.
+            return {(uint16_t) (sign | 0x7C00)};
+        }
+        if (f < 0x38800000) {                               // Subnormal numbers and zero.
+            return {(uint16_t) (sign | (uint16_t) std::lrint(std::bit_cast<float>(f) * 0x1p24f))};
+        }
+        f += 0xC8000FFF + ((f >> 13) & 1);                  // Change the exponent bias, round to nearest even.
+        return {(uint16_t) (sign | (f >> 13))};
+    }
+};
+
+/*
+ * Brain floating point values. The conversion to `float` is only a shift.
+ */
+template<> struct ElementType<BFloat16> {
+    typedef int16_t Bits;
+    typedef float   Value;
+    static constexpr Bits   FIRST_QUIET_NAN = 0x7FC0;
+    static constexpr bool   EXACT = false;
+    static constexpr double TOLERANCE = 0x1p-2;         // Half of the spacing between values in [64 … 128].
+    static inline Bits  bits(BFloat16 e)  {return (Bits) e.bits;}
+    static inline float value(BFloat16 e) {return std::bit_cast<float>((uint32_t) e.bits << 16);}
+
+    static inline BFloat16 fromFloat(float v) {
+        uint32_t f = std::bit_cast<uint32_t>(v);
+        if ((f & 0x7FFFFFFF) > 0x7F800000) {
+            return {(uint16_t) (((f >> 16) & 0x8000) | FIRST_QUIET_NAN | (f & 0x003F))};
+        }
+        return {(uint16_t) ((f + 0x7FFF + ((f >> 16) & 1)) >> 16)};     // Round to nearest even.
+    }
+};
+
+/*
+ * Converts `count` values from `float` to the given element type. This function has the signature
+ * expected by `DataCache::raster(…)` for creating copies of the rasters in other element types.
+ */
+template<typename T> void convertElements(const float* source, void* target, size_t count) {
+    T* elements = static_cast<T*>(target);
+    for (size_t i=0; i<count; i++) {
+        elements[i] = ElementType<T>::fromFloat(source[i]);
+    }
+}
+
+#endif
@@ -0,0 +1,164 @@
+#
+# Builds the tests and the benchmark with different compiler options, then prints a table with the correctness
+# and the execution times of each build side by side. This script is executed by the `flag-matrix` target,
+# which provides the following variables (REPETITIONS is optional and defaults to 20):
+#
+#   SOURCE_DIR   the directory of this script and of `CMakeLists.txt`.
+#   BINARY_DIR   the directory where to create one sub-directory per build.
+#   DATA_DIR     the directory of the data files, given to the `--data` option.
+#   FILTER       the regular expression of the benchmarks to execute.
+#
+# A build is correct if `NaN-test` succeeds, which includes the comparison of all test variants with
+# the reference. The benchmark verifies every run too. The builds are:
+#
+#   strict             IEEE 754 rules without contraction of multiplications and additions.
+#   fast-math          the default options of this project.
+#   finite-math        `-ffast-math` including `-ffinite-math-only`, with the integer comparisons selected
+#                      automatically instead of `std::isnan` (see `isMissing(double)`).
+#   finite-math-isnan  same as above but forcing `std::isnan`, which is expected to fail.
+#   native             the default options with `-march=native`.
+#   lto                the default options with link-time optimization.
+#   pgo                the default options with profile-guided optimization, trained with the benchmark.
+#
+cmake_minimum_required(VERSION 3.19)
+
+if (NOT DEFINED REPETITIONS)
+    set(REPETITIONS 20)
+endif()
+set(DEFAULT_OPTIONS "-ffast-math;-fno-finite-math-only")
+set(CONFIGURATIONS strict fast-math finite-math finite-math-isnan native lto pgo)
+set(OPTIONS_strict              "-ffp-contract=off")
+set(OPTIONS_fast-math           "${DEFAULT_OPTIONS}")
+set(OPTIONS_finite-math         "-ffast-math")
+set(OPTIONS_finite-math-isnan   "-ffast-math;-DNAN_FORCE_ISNAN")
+set(OPTIONS_native              "${DEFAULT_OPTIONS};-march=native")
+set(OPTIONS_lto                 "${DEFAULT_OPTIONS}")
+set(OPTIONS_pgo                 "${DEFAULT_OPTIONS}")
+set(ARGUMENTS_lto -DCMAKE_POLICY_DEFAULT_CMP0069=NEW -DCMAKE_INTERPROCEDURAL_OPTIMIZATION=ON)
+
+#
+# Configures and builds the test and the benchmark in the given directory. Sets `success` to false on failure.
+#
+function(build directory options)
+    execute_process(COMMAND ${CMAKE_COMMAND} -S ${SOURCE_DIR} -B ${directory} "-DNAN_COMPILE_OPTIONS=${options}" ${ARGN}
+                    RESULT_VARIABLE status OUTPUT_QUIET)
+    if (status EQUAL 0)
+        execute_process(COMMAND ${CMAKE_COMMAND} --build ${directory} --target NaN-test NaN-benchmark --parallel
+                        RESULT_VARIABLE status OUTPUT_QUIET)
+    endif()
+    if (status EQUAL 0)
+        set(success TRUE PARENT_SCOPE)
+    else()
+        set(success FALSE PARENT_SCOPE)
+    endif()
+endfunction()
+
+#
+# Runs the benchmark of the given build with the given number of repetitions, writing the results in `results.json`.
+# Sets `success` to false if a run failed.
+#
+function(benchmark directory repetitions)
+    execute_process(COMMAND ${directory}/NaN-benchmark --data=${DATA_DIR} --filter=${FILTER}
+                            --repetitions=${repetitions} --json=${directory}/results.json
+                    RESULT_VARIABLE status OUTPUT_QUIET)
+    if (status EQUAL 0)
+        set(success TRUE PARENT_SCOPE)
+    else()
+        set(success FALSE PARENT_SCOPE)
+    endif()
+endfunction()
+
+#
+# Appends the given text to the variable `row`, padded with spaces to the given width.
+#
+macro(append_column text width)
+    set(column "${text}")
+    string(LENGTH "${column}" length)
+    while (length LESS ${width})
+        string(APPEND column " ")
+        math(EXPR length "${length} + 1")
+    endwhile()
+    string(APPEND row "${column} ")
+endmacro()
+
+set(names "")
+foreach (configuration IN LISTS CONFIGURATIONS)
+    set(directory ${BINARY_DIR}/${configuration})
+    set(options "${OPTIONS_${configuration}}")
+    message(STATUS "Building and running ${configuration}")
+    if (configuration STREQUAL "pgo")
+        #
+        # First build instrumented for collecting a profile with a short run of the benchmark,
+        # then the same build directory is rebuilt with the profile (the profile files are named
+        # after the object files, so the directory shall be the same).
+        #
+        file(REMOVE_RECURSE ${directory}/profile)
+        build(${directory} "${options}" "-DCMAKE_CXX_FLAGS=-fprofile-generate=${directory}/profile")
+        if (success)
+            benchmark(${directory} 3)
+        endif()
+        if (success)
+            build(${directory} "${options}"
+                  "-DCMAKE_CXX_FLAGS=-fprofile-use=${directory}/profile -fprofile-partial-training -Wno-missing-profile")
+        endif()
+    else()
+        build(${directory} "${options}" ${ARGUMENTS_${configuration}})
+    endif()
+    set(RESULT_${configuration} "build failed")
+    if (success)
+        execute_process(COMMAND ${directory}/NaN-test --data=${DATA_DIR} RESULT_VARIABLE status OUTPUT_QUIET)
+        if (status EQUAL 0)
+            set(RESULT_${configuration} "success")
+            benchmark(${directory} ${REPETITIONS})
+            if (success)
+                file(READ ${directory}/results.json json)
+                string(JSON count LENGTH "${json}" benchmarks)
+                math(EXPR last "${count} - 1")
+                foreach (i RANGE ${last})
+                    string(JSON name GET "${json}" benchmarks ${i} run_name)
+                    string(JSON time GET "${json}" benchmarks ${i} ns_per_point)
+                    string(REGEX REPLACE "^([0-9]+\\.[0-9][0-9]).*" "\\1" time "${time}")
+                    list(APPEND names ${name})
+                    set(TIME_${configuration}_${name} ${time})
+                endforeach()
+            else()
+                set(RESULT_${configuration} "benchmark failed")
+            endif()
+        else()
+            set(RESULT_${configuration} "FAILURE")
+        endif()
+    endif()
+endforeach()
+
+#
+# The table, with one row per build and one column per benchmark (nanoseconds per interpolation).
+#
+list(REMOVE_DUPLICATES names)
+set(row "")
+append_column("Build" 18)
+append_column("Options" 50)
+append_column("NaN-test" 16)
+foreach (name IN LISTS names)
+    append_column("${name}" 24)
+endforeach()
+message("\nNanoseconds per interpolation (median) of each benchmark:\n${row}")
+foreach (configuration IN LISTS CONFIGURATIONS)
+    set(row "")
+    string(REPLACE ";" " " options "${OPTIONS_${configuration}}")
+    if (configuration STREQUAL "lto")
+        string(APPEND options " -flto")
+    elseif (configuration STREQUAL "pgo")
+        string(APPEND options " -fprofile-use")
+    endif()
+    append_column("${configuration}" 18)
+    append_column("${options}" 50)
+    append_column("${RESULT_${configuration}}" 16)
+    foreach (name IN LISTS names)
+        if (DEFINED TIME_${configuration}_${name})
+            append_column("${TIME_${configuration}_${name}}" 24)
+        else()
+            append_column("-" 24)
+        endif()
+    endforeach()
+    message("${row}")
+endforeach()
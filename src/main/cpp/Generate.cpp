@@ -0,0 +1,636 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <bit>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include "TestCase.hpp"
+#include "ByteOrder.hpp"
+#include "SensorTest.hpp"
+
+/*
+ * Inverse of the proportion of "no data" values, and the seed of the random numbers.
+ * Those values shall be the same as in the Java `DataGenerator`.
+ */
+#define NODATA_INVERSE_PROPORTION 8
+#define RANDOM_SEED 2082799447325596418LL
+
+/*
+ * Number of values converted in a buffer before each write, and number of points
+ * of the expected results computed by a thread in a single task.
+ */
+#define WRITE_CHUNK_SIZE (1024 * 1024)
+#define POINTS_PER_TASK  (64 * 1024)
+
+/*
+ * Maximal number of components of an `Expansion`. After compression, an expansion has at most one component
+ * for each 53 bits between its smallest and largest bits, and the operations of this file double that number
+ * in the worst case. The values of the generator have far fewer components, typically 2 to 4.
+ */
+#define MAX_COMPONENTS 96
+
+/*
+ * Options of the generator, in addition to the options of the tests described in `Configuration`.
+ */
+struct GeneratorOptions {
+    /*
+     * Number of threads computing the expected results.
+     */
+    int numThreads = std::max((int) std::thread::hardware_concurrency(), 1);
+
+    bool parse(int&, char**);
+};
+
+/*
+ * Parses the generator options and removes them from the command line, leaving the other options for
+ * `Configuration::parse(…)`. The only recognized option is `--threads=…`. Returns `false` if an option
+ * has an invalid value.
+ */
+bool GeneratorOptions::parse(int& argc, char** argv) {
+    int remaining = 1;
+    for (int i=1; i<argc; i++) {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--threads=", 10) == 0) {
+            char* end;
+            long n = strtol(arg + 10, &end, 10);
+            if (*end != 0 || n < 1 || n > 1024) {
+                std::cout << "Invalid option: " << arg << '\n'
+                          << "Generator options: [--threads=N]\n";
+                return false;
+            }
+            numThreads = (int) n;
+            continue;
+        }
+        argv[remaining++] = argv[i];
+    }
+    argc = remaining;
+    return true;
+}
+
+
+
+/*
+ * The random number generator of Java (`java.util.Random`), reproduced bit for bit including the methods
+ * inherited from `java.util.random.RandomGenerator` with the implementation of Java 17 and later.
+ * This is a linear congruential generator on 48 bits. The floating-point operations shall be done
+ * with IEEE 754 semantics, which is why this file is compiled without `-ffast-math`.
+ */
+class JavaRandom {
+    /*
+     * The 48 bits of the internal state.
+     */
+    uint64_t seed;
+
+    int32_t next(int bits);
+
+    public:
+        JavaRandom(int64_t seed);
+        int32_t nextInt();
+        int32_t nextInt(int32_t bound);
+        int32_t nextInt(int32_t origin, int32_t bound);
+        float   nextFloat();
+        float   nextFloat(float origin, float bound);
+        double  nextDouble();
+        double  nextDouble(double bound);
+};
+
+/*
+ * Creates a generator with the given seed, scrambled as in `Random(long)`.
+ */
+JavaRandom::JavaRandom(int64_t initial) {
+    seed = ((uint64_t) initial ^ 0x5DEECE66DULL) & ((1ULL << 48) - 1);
+}
+
+/*
+ * Advances the state and returns its given number of most significant bits, as in `Random.next(int)`.
+ */
+int32_t JavaRandom::next(int bits) {
+    seed = (seed * 0x5DEECE66DULL + 0xBULL) & ((1ULL << 48) - 1);
+    return (int32_t) (seed >> (48 - bits));
+}
+
+/*
+ * Returns a random integer of 32 bits, as in `Random.nextInt()`.
+ */
+int32_t JavaRandom::nextInt() {
+    return next(32);
+}
+
+/*
+ * Returns a random integer from 0 inclusive to `bound` exclusive, as in `Random.nextInt(int)`.
+ * The overflow of the rejection test on 32 bits is intentional, as in Java.
+ */
+int32_t JavaRandom::nextInt(int32_t bound) {
+    if ((bound & -bound) == bound) {
+        return (int32_t) ((bound * (int64_t) next(31)) >> 31);
+    }
+    int32_t bits, value;
+    do {
+        bits  = next(31);
+        value = bits % bound;
+    } while ((int32_t) ((uint32_t) bits - (uint32_t) value + (uint32_t) (bound - 1)) < 0);
+    return value;
+}
+
+/*
+ * Returns a random integer from `origin` inclusive to `bound` exclusive, as in `RandomGenerator.nextInt(int, int)`,
+ * which is not the same algorithm as `nextInt(int)`.
+ */
+int32_t JavaRandom::nextInt(int32_t origin, int32_t bound) {
+    int32_t r = nextInt();
+    const int32_t n = bound - origin;
+    const int32_t m = n - 1;
+    if ((n & m) == 0) {
+        return (r & m) + origin;
+    }
+    for (int32_t u = (int32_t) ((uint32_t) r >> 1);
+         (int32_t) ((uint32_t) u + (uint32_t) m - (uint32_t) (r = u % n)) < 0;
+         u = (int32_t) ((uint32_t) nextInt() >> 1));
+    return r + origin;
+}
+
+/*
+ * Returns a random value from 0 inclusive to 1 exclusive, as in `Random.nextFloat()`.
+ */
+float JavaRandom::nextFloat() {
+    return next(24) / ((float) (1 << 24));
+}
+
+/*
+ * Returns a random value from `origin` inclusive to `bound` exclusive, as in `RandomGenerator.nextFloat(float, float)`.
+ */
+float JavaRandom::nextFloat(float origin, float bound) {
+    float r = nextFloat();
+    r = r * (bound - origin) + origin;
+    if (r >= bound) {
+        r = std::nextafter(bound, origin);
+    }
+    return r;
+}
+
+/*
+ * Returns a random value from 0 inclusive to 1 exclusive, as in `Random.nextDouble()`.
+ */
+double JavaRandom::nextDouble() {
+    return (double) (((int64_t) next(26) << 27) + next(27)) * 0x1.0p-53;
+}
+
+/*
+ * Returns a random value from 0 inclusive to `bound` exclusive, as in `RandomGenerator.nextDouble(double)`.
+ */
+double JavaRandom::nextDouble(double bound) {
+    double r = nextDouble() * bound;
+    if (r >= bound) {
+        r = std::nextafter(bound, -INFINITY);
+    }
+    return r;
+}
+
+
+
+/*
+ * A number represented exactly by a sum of `double` values, in the way of the "expansions" of Shewchuk
+ * ("Adaptive Precision Floating-Point Arithmetic and Fast Robust Geometric Predicates", 1997). The components
+ * are non-overlapping and sorted in increasing order of magnitude, without zeros. The additions and products
+ * are computed exactly with error-free transformations (the error of a sum or product is itself a `double`),
+ * provided that no intermediate value is subnormal. This is sufficient for reproducing the `BigDecimal`
+ * calculation of the Java `DataGenerator`, which is exact except for the final conversions to `double`,
+ * about 100 times faster than an arbitrary precision library.
+ */
+struct Expansion {
+    int    length;
+    double components[MAX_COMPONENTS];
+
+    Expansion();
+    Expansion(double);
+    void   add(double);
+    void   add(const Expansion&);
+    void   multiply(double);
+    void   negate();
+    void   compress();
+    int    sign() const;
+    double toDouble() const;
+};
+
+/*
+ * Creates an expansion of value zero.
+ */
+Expansion::Expansion() {
+    length = 0;
+}
+
+/*
+ * Creates an expansion of the given value.
+ */
+Expansion::Expansion(double value) {
+    length = 0;
+    if (value != 0) {
+        components[length++] = value;
+    }
+}
+
+/*
+ * Adds exactly the given value. This is the "grow expansion" algorithm with elimination of zero components.
+ * The components are overwritten in place, which is safe because the number of components written never
+ * exceeds the number of components read.
+ */
+void Expansion::add(double value) {
+    double sum = value;
+    int n = 0;
+    for (int i=0; i<length; i++) {
+        double component = components[i];
+        double total = sum + component;
+        double bv    = total - sum;
+        double error = (sum - (total - bv)) + (component - bv);
+        if (error != 0) {
+            components[n++] = error;
+        }
+        sum = total;
+    }
+    if (sum != 0) {
+        components[n++] = sum;
+    }
+    length = n;
+}
+
+/*
+ * Adds exactly all components of the given expansion.
+ */
+void Expansion::add(const Expansion& other) {
+    for (int i=0; i<other.length; i++) {
+        add(other.components[i]);
+    }
+    compress();
+}
+
+/*
+ * Multiplies exactly by the given value. The rounding error of each product
+ * is computed with a fused multiply-add, and added as an additional component.
+ */
+void Expansion::multiply(double factor) {
+    Expansion product;
+    for (int i=0; i<length; i++) {
+        double p = components[i] * factor;
+        product.add(std::fma(components[i], factor, -p));
+        product.add(p);
+    }
+    product.compress();
+    *this = product;
+}
+
+/*
+ * Changes the sign of this number.
+ */
+void Expansion::negate() {
+    for (int i=0; i<length; i++) {
+        components[i] = -components[i];
+    }
+}
+
+/*
+ * Reduces the number of components without changing the value, with the "compress" algorithm of Shewchuk.
+ * The largest component is then an approximation of the value with an error smaller than its last bit.
+ */
+void Expansion::compress() {
+    if (length <= 1) {
+        return;
+    }
+    double h[MAX_COMPONENTS];
+    int bottom = length - 1;
+    double q = components[bottom];
+    for (int i = length - 2; i >= 0; i--) {
+        double sum   = q + components[i];
+        double error = components[i] - (sum - q);
+        if (error != 0) {
+            h[bottom--] = sum;
+            q = error;
+        } else {
+            q = sum;
+        }
+    }
+    int top = 0;
+    for (int i = bottom + 1; i < length; i++) {
+        double sum   = h[i] + q;
+        double error = q - (sum - h[i]);
+        if (error != 0) {
+            components[top++] = error;
+        }
+        q = sum;
+    }
+    components[top++] = q;
+    length = top;
+}
+
+/*
+ * Returns -1, 0 or +1 depending on whether this number is negative, zero or positive.
+ * This is the sign of the largest component, because the components do not overlap.
+ */
+int Expansion::sign() const {
+    return (length == 0) ? 0 : (components[length - 1] > 0) ? 1 : -1;
+}
+
+/*
+ * Returns this number rounded to the nearest `double`, with ties rounded to even as `BigDecimal.doubleValue()`.
+ * The largest component after compression is the candidate, which is moved to the next or previous `double`
+ * while the exact difference with this number exceeds half of the spacing to that neighbour.
+ */
+double Expansion::toDouble() const {
+    Expansion value = *this;
+    value.compress();
+    if (value.length == 0) {
+        return 0;
+    }
+    double candidate = value.components[value.length - 1];
+    for (;;) {
+        Expansion difference = value;
+        difference.add(-candidate);
+        double above = std::nextafter(candidate,  INFINITY);
+        double below = std::nextafter(candidate, -INFINITY);
+        const double neighbours[2] = {above, below};
+        int moved = 0;
+        for (double neighbour : neighbours) {
+            Expansion excess = difference;
+            excess.add((candidate - neighbour) / 2);        // Exact because neighbours are one bit apart.
+            int s = excess.sign() * ((neighbour > candidate) ? 1 : -1);
+            if (s == 0) {
+                return (std::bit_cast<uint64_t>(candidate) & 1) ? neighbour : candidate;
+            }
+            if (s > 0) {
+                candidate = neighbour;
+                moved = 1;
+                break;
+            }
+        }
+        if (!moved) {
+            return candidate;
+        }
+    }
+}
+
+
+
+/*
+ * Performs one iteration on the point at (x,y). This is the calculation of the Java `DataGenerator`:
+ * the bilinear interpolation is exact, the result is rounded to `double` only for being stored in the file,
+ * and the new coordinates are computed from the exact result before being rounded to `double`.
+ * Returns the expected result, which is the "no data" value having precedence if a pixel is missing.
+ */
+static double iterate(const float* raster, double& x, double& y) {
+    const int width  = config.width;
+    const int height = config.height;
+    double xb = std::floor(x);
+    double yb = std::floor(y);
+    size_t offset = (size_t) width * (size_t) yb + (size_t) xb;
+    float v00 = raster[offset];
+    float v01 = raster[offset + 1];
+    float v10 = raster[offset += width];
+    float v11 = raster[offset + 1];
+    float maximum = std::max(std::max(v00, v01), std::max(v10, v11));
+    double result;
+    Expansion value;
+    if (maximum >= MISSING_VALUE_THRESHOLD) {
+        result = maximum;
+        value  = Expansion(1.0);        // For moving to another position.
+    } else {
+        double xf = x - xb;             // Exact because `xb` is the integer part of `x`.
+        double yf = y - yb;
+        Expansion v0(v01); v0.add(-(double) v00); v0.multiply(xf); v0.add((double) v00);
+        Expansion v1(v11); v1.add(-(double) v10); v1.multiply(xf); v1.add((double) v10);
+        v0.negate();
+        v1.add(v0);
+        v1.multiply(yf);
+        v0.negate();
+        v1.add(v0);
+        value  = v1;
+        result = value.toDouble();
+    }
+    /*
+     * Compute |x + value| mod (width - 1). The quotient is estimated from the largest component,
+     * then corrected by one if needed, so that the remainder computed with that quotient is exact.
+     */
+    const double limits[2] = {(double) (width - 1), (double) (height - 1)};
+    double* coordinates[2] = {&x, &y};
+    for (int dim=0; dim<2; dim++) {
+        const double limit = limits[dim];
+        Expansion r = value;
+        r.add(*coordinates[dim]);
+        r.compress();
+        if (r.sign() < 0) {
+            r.negate();
+        }
+        double q = (r.length != 0) ? std::floor(r.components[r.length - 1] / limit) : 0;
+        double p = q * limit;
+        r.add(-std::fma(q, limit, -p));
+        r.add(-p);
+        while (r.sign() < 0) {
+            r.add(limit);
+        }
+        for (;;) {
+            Expansion next = r;
+            next.add(-limit);
+            if (next.sign() < 0) break;
+            r = next;
+        }
+        *coordinates[dim] = r.toDouble();
+    }
+    return result;
+}
+
+/*
+ * Writes `count` values in the given file, in big-endian or little-endian byte order. The values are produced
+ * by the given function by chunks of `WRITE_CHUNK_SIZE`, and each chunk is written in a single call.
+ * Returns whether the file has been written.
+ */
+template<typename T, typename Producer>
+static bool writeValues(const std::filesystem::path& file, size_t count, std::endian byteOrder, Producer value) {
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    std::vector<T> buffer(std::min(count, (size_t) WRITE_CHUNK_SIZE));
+    for (size_t start = 0; start < count && out; start += buffer.size()) {
+        size_t length = std::min(buffer.size(), count - start);
+        for (size_t i=0; i<length; i++) {
+            T bits = value(start + i);
+            buffer[i] = (byteOrder == std::endian::native) ? bits : byteswap(bits);
+        }
+        out.write(reinterpret_cast<const char*>(buffer.data()), length * sizeof(T));
+    }
+    out.close();
+    return out.good();
+}
+
+/*
+ * Computes the expected results of all points and all iterations, and writes them in the given file
+ * in big-endian byte order. The points are split in tasks of `POINTS_PER_TASK` points, which are
+ * taken by the threads in any order. Each thread performs all iterations on the points of its task,
+ * then writes the results of each iteration at their position in the file.
+ * Returns whether the file has been written.
+ */
+static bool writeExpectedResults(const std::filesystem::path& file, const float* raster,
+                                 const std::vector<double>& coordinates, int numThreads)
+{
+    const int numPoints     = config.numInterpolationPoints;
+    const int numIterations = config.numVerifiedIterations;
+    const int numTasks      = (numPoints + POINTS_PER_TASK - 1) / POINTS_PER_TASK;
+    std::fstream out(file, std::ios::binary | std::ios::out | std::ios::trunc);
+    std::atomic<int> nextTask(0);
+    std::mutex lock;
+    bool success = out.is_open();
+    auto worker = [&]() {
+        std::vector<uint64_t> results((size_t) POINTS_PER_TASK * numIterations);
+        for (int task; (task = nextTask++) < numTasks;) {
+            const int first = task * POINTS_PER_TASK;
+            const int count = std::min(POINTS_PER_TASK, numPoints - first);
+            for (int i=0; i<count; i++) {
+                double x = coordinates[2 * (size_t) (first + i)];
+                double y = coordinates[2 * (size_t) (first + i) + 1];
+                for (int it=0; it<numIterations; it++) {
+                    uint64_t bits = std::bit_cast<uint64_t>(iterate(raster, x, y));
+                    results[(size_t) it * count + i] = (std::endian::native == std::endian::big) ? bits : byteswap(bits);
+                }
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            for (int it=0; it<numIterations; it++) {
+                out.seekp(((size_t) it * numPoints + first) * sizeof(double));
+                out.write(reinterpret_cast<const char*>(&results[(size_t) it * count]), count * sizeof(double));
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int t=1; t<numThreads; t++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+    out.close();
+    return success && out.good();
+}
+
+/*
+ * Replaces the given file by a hard link to the other file, or by a copy if hard links are not supported.
+ */
+static bool link(const std::filesystem::path& target, const std::filesystem::path& link) {
+    std::error_code error;
+    std::filesystem::remove(link, error);
+    std::filesystem::create_hard_link(target, link, error);
+    if (error) {
+        std::filesystem::copy_file(target, link, std::filesystem::copy_options::overwrite_existing, error);
+    }
+    return !error;
+}
+
+/*
+ * Returns the milliseconds elapsed since the given time.
+ */
+static double millis(std::chrono::high_resolution_clock::time_point start) {
+    return duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count() / 1E6;
+}
+
+/*
+ * Generates the data files of the tests in the "nan" and "nodata" sub-directories of the data directory, with the
+ * same content as the files generated by the Java `DataGenerator` for the same raster size, number of points and
+ * number of iterations. The random numbers are generated in a single thread because they are a single sequence,
+ * then the rasters are written in parallel and the expected results are computed by all threads.
+ * See `Configuration::parse(…)` for the command-line options, in addition to `--threads=…`.
+ */
+int main(int argc, char** argv) {
+    GeneratorOptions options;
+    if (!options.parse(argc, argv) || !config.parse(argc, argv)) {
+        return 1;
+    }
+    const size_t numValues = (size_t) config.width * config.height;
+    const size_t numCoordinates = 2 * (size_t) config.numInterpolationPoints;
+    const std::filesystem::path nodata = config.dataDirectory / "nodata";
+    const std::filesystem::path nan    = config.dataDirectory / "nan";
+    std::error_code error;
+    std::filesystem::create_directories(nodata, error);
+    std::filesystem::create_directories(nan, error);
+    /*
+     * Generate the raster and the coordinates in the order of the Java code,
+     * which consumes the random numbers in a single sequence.
+     */
+    auto startTime = std::chrono::high_resolution_clock::now();
+    JavaRandom random(RANDOM_SEED);
+    std::vector<float> raster(numValues);
+    for (float& value : raster) {
+        value = (random.nextInt(NODATA_INVERSE_PROPORTION) == 0)
+                ? (float) random.nextInt(MISSING_VALUE_THRESHOLD + 1, MISSING_VALUE_THRESHOLD + 4)    // CLOUD to NO_PASS.
+                : random.nextFloat(-100, 100);
+    }
+    std::vector<double> coordinates(numCoordinates);
+    for (size_t i=0; i<numCoordinates;) {
+        coordinates[i++] = random.nextDouble(config.width  - 1);
+        coordinates[i++] = random.nextDouble(config.height - 1);
+    }
+    printf("Random values generated in %.1f ms.\n", millis(startTime));
+    /*
+     * Write the four rasters in parallel, with NaN payloads computed as in `DataGenerator.reformat(…)`,
+     * together with the sensor rasters (which are not generated by Java) encoded as in `DataCache::sensorRaster(…)`.
+     * The coordinates are written in the current thread.
+     */
+    startTime = std::chrono::high_resolution_clock::now();
+    bool written[5 + NUM_SENSOR_FORMATS] = {};
+    std::vector<std::thread> writers;
+    for (int useNaN = 0; useNaN <= 1; useNaN++) {
+        for (std::endian byteOrder : {std::endian::big, std::endian::little}) {
+            writers.emplace_back([&, useNaN, byteOrder, index = writers.size()]() {
+                written[index] = writeValues<uint32_t>((useNaN ? nan : nodata) /
+                        ((byteOrder == std::endian::big) ? "big-endian.raw" : "little-endian.raw"),
+                        numValues, byteOrder, [&](size_t i) {
+                            float value = raster[i];
+                            if (useNaN && value >= MISSING_VALUE_THRESHOLD) {
+                                return (uint32_t) (std::lround(value - MISSING_VALUE_THRESHOLD) + 0x7FC00000);
+                            }
+                            return std::bit_cast<uint32_t>(value);
+                        });
+            });
+        }
+    }
+    for (int format = 0; format < NUM_SENSOR_FORMATS; format++) {
+        writers.emplace_back([&, format]() {
+            // The codes are already in the byte order of the format, so they are written without swapping.
+            written[5 + format] = writeValues<uint16_t>(nodata / SENSOR_FILES[format], numValues, std::endian::native,
+                    [&](size_t i) {return encodeSensorValue(SENSOR_FORMATS[format], raster[i]);});
+        });
+    }
+    written[4] = writeValues<uint64_t>(nodata / "coordinates.raw", numCoordinates, std::endian::big,
+                                       [&](size_t i) {return std::bit_cast<uint64_t>(coordinates[i]);});
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    if (!std::all_of(std::begin(written), std::end(written), [](bool w) {return w;})) {
+        std::cout << "Cannot write the rasters or the coordinates in " << config.dataDirectory << ".\n";
+        return 1;
+    }
+    printf("Rasters and coordinates written in %.1f ms.\n", millis(startTime));
+    /*
+     * Compute the expected results with all threads, then share the files with the NaN directory.
+     */
+    startTime = std::chrono::high_resolution_clock::now();
+    if (!writeExpectedResults(nodata / "expected-results.raw", raster.data(), coordinates, options.numThreads)) {
+        std::cout << "Cannot write the expected results in " << nodata << ".\n";
+        return 1;
+    }
+    printf("Expected results computed and written in %.1f ms with %d thread%s.\n", millis(startTime),
+           options.numThreads, (options.numThreads == 1) ? "" : "s");
+    if (!link(nodata / "coordinates.raw", nan / "coordinates.raw") ||
+        !link(nodata / "expected-results.raw", nan / "expected-results.raw"))
+    {
+        std::cout << "Cannot link the coordinates and expected results in " << nan << ".\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include "TestCase.hpp"
+#include "IncrementalInterpolation.hpp"
+
+/*
+ * Bit pattern written in the regions updated by this demo, as if a new pass of the sensor saw clouds.
+ */
+#define CLOUD_BITS 0x7FC00001
+
+/*
+ * Compares the results of the incremental interpolation with the expected values of the first iteration.
+ * Returns the number of "missing value" mismatches and stores the maximal error in `maxError`.
+ */
+static int compare(const IncrementalInterpolation& incremental, const double* expected, double& maxError) {
+    int mismatches = 0;
+    maxError = 0;
+    for (size_t i=0; i < incremental.results.size(); i++) {
+        double result = incremental.results[i];
+        double nodata = incremental.reasons[i] - ElementType<float>::FIRST_QUIET_NAN + MISSING_VALUE_THRESHOLD;
+        verifyResult(isMissing(result), nodata, result, expected[i], mismatches, maxError);
+    }
+    return mismatches;
+}
+
+/*
+ * Returns whether the results and reasons of two passes have identical bit patterns.
+ */
+static bool sameBits(const std::vector<double>& results, const std::vector<int32_t>& reasons,
+                     const std::vector<double>& otherResults, const std::vector<int32_t>& otherReasons)
+{
+    return memcmp(results.data(), otherResults.data(), results.size() * sizeof(double)) == 0
+        && memcmp(reasons.data(), otherReasons.data(), reasons.size() * sizeof(int32_t)) == 0;
+}
+
+/*
+ * Demonstrates the incremental re-evaluation of the interpolations after updates of square regions of the raster.
+ * This is the first iteration of the NaN test, which is verified against the expected results. Then, regions of
+ * increasing sizes are covered by clouds and restored. After each change, the incrementally updated results are
+ * compared with a full pass on the modified raster, and must be identical to it. After the restoration, they must
+ * be identical to the results before the change. The points are indexed by tiles of `config.tileSize` pixels.
+ * See `Configuration::parse(…)` for the command-line options.
+ */
+int main(int argc, char** argv) {
+    if (!config.parse(argc, argv)) {
+        return 1;
+    }
+    const int width  = config.width;
+    const int height = config.height;
+    const int numPoints = config.numInterpolationPoints;
+    Arena arena;
+    DataCache cache;
+    const float*  original    = cache.raster(true, std::endian::native, RasterLayout(width, height, 0));
+    const double* coordinates = cache.coordinates(true);
+    ExpectedResults expectedResults;
+    const double* allExpected = cache.expectedResults(true);
+    bool opened = allExpected ? expectedResults.open(allExpected, 0, numPoints)
+                              : expectedResults.open(cache.file(true, "expected-results.raw"), 0, numPoints, arena);
+    const double* expected = opened ? expectedResults.next() : NULL;
+    if (!original || !coordinates || !expected) {
+        std::cout << "Cannot read the data in " << config.dataDirectory << ".\n";
+        return 1;
+    }
+    std::vector<float> values(original, original + (size_t) width * height);
+    Raster raster(values.data(), width, height);
+    IncrementalInterpolation incremental(raster, std::span(coordinates, 2 * (size_t) numPoints),
+                                         RasterLayout(width, height, config.tileSize).tileShift);
+    /*
+     * The initial full pass, verified against the expected results of the first iteration.
+     */
+    auto startTime = std::chrono::high_resolution_clock::now();
+    if (incremental.evaluate() != numPoints) {
+        std::cout << "Coordinates out of bounds.\n";
+        return 1;
+    }
+    auto endTime = std::chrono::high_resolution_clock::now();
+    const double fullTime = duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+    double maxError;
+    int mismatches = compare(incremental, expected, maxError);
+    printf("Full pass: %.3f ms, maximal error: %.4f, mismatches: %d\n\n", fullTime / 1E6, maxError, mismatches);
+    if (mismatches != 0 || maxError > 0.001) {
+        std::cout << "TEST FAILURE: the first iteration does not match the expected results.\n";
+        return 1;
+    }
+    const std::vector<double>  initialResults = incremental.results;
+    const std::vector<int32_t> initialReasons = incremental.reasons;
+    std::vector<double>  fullResults(numPoints);
+    std::vector<int32_t> fullReasons(numPoints);
+    /*
+     * Updates of square regions at random positions, with a fixed seed for reproducible runs.
+     */
+    std::minstd_rand random(42);
+    printf("%-12s %12s %12s %12s\n", "Region", "Points", "Update (ms)", "Restore (ms)");
+    for (int size : {1, 8, 32, 128, 512}) {
+        const int numColumns = std::min(size, width);
+        const int numRows    = std::min(size, height);
+        const int x = (int) (random() % (width  - numColumns + 1));
+        const int y = (int) (random() % (height - numRows    + 1));
+        for (int r=0; r<numRows; r++) {
+            std::fill_n(values.data() + (size_t) (y + r) * width + x, numColumns, std::bit_cast<float>(CLOUD_BITS));
+        }
+        startTime = std::chrono::high_resolution_clock::now();
+        int count = incremental.update(x, y, numColumns, numRows);
+        endTime = std::chrono::high_resolution_clock::now();
+        const double updateTime = duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+        interpolate(raster, std::span(coordinates, 2 * (size_t) numPoints), std::span(fullResults), std::span(fullReasons));
+        if (!sameBits(incremental.results, incremental.reasons, fullResults, fullReasons)) {
+            std::cout << "TEST FAILURE: the incremental update differs from a full pass.\n";
+            return 1;
+        }
+        for (int r=0; r<numRows; r++) {
+            size_t offset = (size_t) (y + r) * width + x;
+            std::copy_n(original + offset, numColumns, values.data() + offset);
+        }
+        startTime = std::chrono::high_resolution_clock::now();
+        incremental.update(x, y, numColumns, numRows);
+        endTime = std::chrono::high_resolution_clock::now();
+        const double restoreTime = duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+        if (!sameBits(incremental.results, incremental.reasons, initialResults, initialReasons)) {
+            std::cout << "TEST FAILURE: the results after restoration differ from the initial results.\n";
+            return 1;
+        }
+        char region[32];
+        snprintf(region, sizeof(region), "%d × %d", numColumns, numRows);
+        printf("%-13s %12d %12.3f %12.3f\n", region, count, updateTime / 1E6, restoreTime / 1E6);
+    }
+    std::cout << "\nSuccess: the incremental updates are identical to full passes.\n";
+    return 0;
+}
@@ -0,0 +1,118 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <algorithm>
+#include "IncrementalInterpolation.hpp"
+
+/*
+ * Creates the index of the given points by tiles of `1 << tileShift` pixels. The results are not computed
+ * before the call to `evaluate()`. The index is built with a counting sort, in a time proportional to the
+ * number of points plus the number of tiles.
+ */
+IncrementalInterpolation::IncrementalInterpolation(const Raster& source, std::span<const double> xy, int shift)
+        : raster(source), coordinates(xy.begin(), xy.end())
+{
+    const int numPoints = (int) (xy.size() / 2);
+    tileShift   = shift;
+    tilesPerRow = (raster.width + (1 << shift) - 1) >> shift;
+    const int numTiles = tilesPerRow * ((raster.height + (1 << shift) - 1) >> shift);
+    results.resize(numPoints);
+    reasons.resize(numPoints);
+    std::vector<int> tileOfPoint(numPoints);
+    firstOfTile.assign(numTiles + 1, 0);
+    for (int i=0; i<numPoints; i++) {
+        double x = coordinates[2*i];
+        double y = coordinates[2*i + 1];
+        int tile = -1;
+        if (x >= 0 && y >= 0 && x < raster.width - 1 && y < raster.height - 1) {
+            tile = (((int) y) >> shift) * tilesPerRow + (((int) x) >> shift);
+            firstOfTile[tile + 1]++;
+        }
+        tileOfPoint[i] = tile;
+    }
+    for (int t=0; t<numTiles; t++) {
+        firstOfTile[t + 1] += firstOfTile[t];
+    }
+    pointsByTile.resize(firstOfTile[numTiles]);
+    std::vector<int> next(firstOfTile.begin(), firstOfTile.end() - 1);
+    for (int i=0; i<numPoints; i++) {
+        if (tileOfPoint[i] >= 0) {
+            pointsByTile[next[tileOfPoint[i]]++] = i;
+        }
+    }
+}
+
+/*
+ * Interpolates all points. This is the full pass to execute once before the first update.
+ * Returns the number of points that have been interpolated, with the same meaning as `interpolate(…)`.
+ */
+int IncrementalInterpolation::evaluate() {
+    const int numPoints = (int) results.size();
+    for (int start=0; start < numPoints; start += SIMD_BATCH_SIZE) {
+        int length = std::min(SIMD_BATCH_SIZE, numPoints - start);
+        int valid  = raster.kernel(raster.values, raster.width, raster.height, coordinates.data() + 2*start,
+                                   length, results.data() + start, reasons.data() + start);
+        if (valid != length) {
+            return start + valid;
+        }
+    }
+    return numPoints;
+}
+
+/*
+ * Interpolates a batch of `count` points gathered by `update(…)`, and stores the results at the given indices.
+ */
+void IncrementalInterpolation::recompute(const double* xy, const int* indices, int count) {
+    double  values [SIMD_BATCH_SIZE];
+    int32_t missing[SIMD_BATCH_SIZE];
+    raster.kernel(raster.values, raster.width, raster.height, xy, count, values, missing);
+    for (int i=0; i<count; i++) {
+        results[indices[i]] = values [i];
+        reasons[indices[i]] = missing[i];
+    }
+}
+
+/*
+ * Recomputes the points which use at least one of the raster pixels in the region starting at (x,y)
+ * with the given number of columns and rows. The caller shall have modified the raster values before
+ * to invoke this method. A point at (px,py) uses the pixels from floor(px) to floor(px) + 1 inclusive,
+ * so the points affected by the region are those starting one pixel before the region. The points
+ * are gathered in batches of `SIMD_BATCH_SIZE` for the vectorized kernel.
+ *
+ * Returns the number of points that have been recomputed.
+ */
+int IncrementalInterpolation::update(int x, int y, int numColumns, int numRows) {
+    const int xmin = std::max(x - 1, 0), xmax = std::min(x + numColumns, raster.width  - 1) - 1;     // Inclusive.
+    const int ymin = std::max(y - 1, 0), ymax = std::min(y + numRows,    raster.height - 1) - 1;
+    if (xmin > xmax || ymin > ymax) {
+        return 0;
+    }
+    double xy[2 * SIMD_BATCH_SIZE];
+    int indices[SIMD_BATCH_SIZE];
+    int count = 0, total = 0;
+    for (int ty = ymin >> tileShift; ty <= (ymax >> tileShift); ty++) {
+        for (int tx = xmin >> tileShift; tx <= (xmax >> tileShift); tx++) {
+            const int tile = ty * tilesPerRow + tx;
+            for (int k = firstOfTile[tile]; k < firstOfTile[tile + 1]; k++) {
+                const int i = pointsByTile[k];
+                const double px = coordinates[2*i];
+                const double py = coordinates[2*i + 1];
+                if ((int) px >= xmin && (int) px <= xmax && (int) py >= ymin && (int) py <= ymax) {
+                    xy[2*count]     = px;
+                    xy[2*count + 1] = py;
+                    indices[count]  = i;
+                    if (++count == SIMD_BATCH_SIZE) {
+                        recompute(xy, indices, count);
+                        total += count;
+                        count  = 0;
+                    }
+                }
+            }
+        }
+    }
+    if (count != 0) {
+        recompute(xy, indices, count);
+    }
+    return total + count;
+}
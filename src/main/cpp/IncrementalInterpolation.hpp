@@ -0,0 +1,64 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#ifndef INCREMENTAL_INTERPOLATION_HPP
+#define INCREMENTAL_INTERPOLATION_HPP
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Interpolation.hpp"
+
+/*
+ * Results of a single pass of interpolations at fixed points, kept up to date when regions of the raster change.
+ * The points are indexed by the tile of `1 << tileShift` pixels containing the upper-left pixel of their bilinear
+ * interpolation. After values have been modified in a region of the raster, `update(…)` recomputes only the points
+ * that use at least one pixel of that region. The cost of an update is therefore proportional to the number of
+ * points in the region (plus the points in the same tiles, which are tested but not recomputed), not to the raster.
+ *
+ * The raster values are not copied: the caller modifies the array given to the `Raster` directly, then invokes
+ * `update(…)` with the bounds of the modified pixels. The summary of tiles of the raster, if any, is not used
+ * because it would be invalidated by the changes. The coordinates are copied and never change, contrarily to
+ * the chained iterations of the tests: a result is a function of the raster only, which is what makes the
+ * incremental update exact.
+ */
+class IncrementalInterpolation {
+    /*
+     * The raster to interpolate, which shall stay valid as long as this object is used.
+     */
+    const Raster& raster;
+
+    /*
+     * The (x,y) coordinates of all points, in pixel units.
+     */
+    std::vector<double> coordinates;
+
+    /*
+     * Logarithm in base 2 of the tile size, and number of tiles in a row of tiles.
+     */
+    int tileShift, tilesPerRow;
+
+    /*
+     * Indices of the points sorted by tile. The points of tile `t` are in `pointsByTile` from index
+     * `firstOfTile[t]` inclusive to `firstOfTile[t + 1]` exclusive. Points outside the raster are not indexed.
+     */
+    std::vector<int> firstOfTile;
+    std::vector<int> pointsByTile;
+
+    void recompute(const double* xy, const int* indices, int count);
+
+    public:
+        /*
+         * The interpolated values and the missing value reasons of all points, as computed by `interpolate(…)`.
+         * Valid after `evaluate()` and updated by `update(…)`.
+         */
+        std::vector<double>  results;
+        std::vector<int32_t> reasons;
+
+        IncrementalInterpolation(const Raster& raster, std::span<const double> xy, int tileShift);
+        int evaluate();
+        int update(int x, int y, int numColumns, int numRows);
+};
+
+#endif
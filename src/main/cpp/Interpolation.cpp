@@ -0,0 +1,719 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cstdint>
+#include <cmath>
+#include <bit>
+#include <span>
+#include <algorithm>
+#include <stdexcept>
+#include "Interpolation.hpp"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/*
+ * Largest offset (exclusive) in the raster where a bilinear interpolation can be applied.
+ * This is the same bound check as the one done in `TestNaN` and `TestNodata` of the test cases.
+ */
+#define OFFSET_LIMIT ((height - 1) * width + (width - 1))
+
+/*
+ * Interpolates one point at a time. Used when no vector instruction set is available,
+ * and for the last points of a batch when their number is not a multiple of the vector length.
+ * The formulas are the same as in `TestNaN::computeAndCompare` of the test cases.
+ */
+template<int FIXED_WIDTH>
+int interpolateScalar(const float* raster, int width, int height, const double* coordinates, int count, double* results, int32_t* reasons) {
+    if (FIXED_WIDTH != 0) width = FIXED_WIDTH;
+    for (int i=0; i<count; i++) {
+        double x  = coordinates[i << 1];
+        double y  = coordinates[(i << 1) | 1];
+        double xb = std::floor(x);
+        double yb = std::floor(y);
+        int offset = width * ((int) yb) + ((int) xb);
+        if (offset < 0 || offset >= OFFSET_LIMIT) {
+            return i;
+        }
+        float v00 = raster[offset];
+        float v01 = raster[offset + 1];
+        float v10 = raster[offset += width];
+        float v11 = raster[offset + 1];
+        double xf = x - xb;
+        double yf = y - yb;
+        double v0 = std::fma(v01 - (double) v00, xf, v00);
+        double v1 = std::fma(v11 - (double) v10, xf, v10);
+        results[i] = std::fma(v1 - v0, yf, v0);
+        reasons[i] = std::max(
+                std::max(std::bit_cast<int32_t>(v00), std::bit_cast<int32_t>(v01)),
+                std::max(std::bit_cast<int32_t>(v10), std::bit_cast<int32_t>(v11)));
+    }
+    return count;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/*
+ * Interpolates 8 points per step with AVX2 instructions. The raster values are fetched with
+ * gather instructions, and the missing value reason is the maximum of the bit patterns
+ * compared as signed integers, which is the same trick as in the scalar code.
+ *
+ * The offset is computed as `yb * width + xb` in double-precision before the conversion
+ * to integers. This is exact because all terms are integers smaller than 2^31, and it
+ * saves the conversion of `yb` and an integer multiplication.
+ */
+template<int FIXED_WIDTH>
+__attribute__((target("avx2,fma")))
+int interpolateAVX2(const float* raster, int width, int height, const double* coordinates, int count, double* results, int32_t* reasons) {
+    if (FIXED_WIDTH != 0) width = FIXED_WIDTH;
+    const __m256d widths = _mm256_set1_pd(width);
+    const __m256i limit = _mm256_set1_epi32(OFFSET_LIMIT - 1);
+    int i = 0;
+    for (; i <= count - 8; i += 8) {
+        /*
+         * Separate the (x,y) tuples in a vector of x values and a vector of y values,
+         * for two groups of four points. The permutation below gives x0 x1 x2 x3.
+         */
+        __m256d x[2], y[2], xf[2], yf[2];
+        __m128i offsets[2];
+        for (int h=0; h<2; h++) {
+            const double* p = coordinates + 2*(i + 4*h);
+            __m256d p0 = _mm256_loadu_pd(p);                    // x0 y0 x1 y1
+            __m256d p1 = _mm256_loadu_pd(p + 4);                // x2 y2 x3 y3
+            __m256d lo = _mm256_permute2f128_pd(p0, p1, 0x20);  // x0 y0 x2 y2
+            __m256d hi = _mm256_permute2f128_pd(p0, p1, 0x31);  // x1 y1 x3 y3
+            x[h] = _mm256_unpacklo_pd(lo, hi);
+            y[h] = _mm256_unpackhi_pd(lo, hi);
+            __m256d xb = _mm256_floor_pd(x[h]);
+            __m256d yb = _mm256_floor_pd(y[h]);
+            xf[h] = _mm256_sub_pd(x[h], xb);
+            yf[h] = _mm256_sub_pd(y[h], yb);
+            offsets[h] = _mm256_cvttpd_epi32(_mm256_fmadd_pd(yb, widths, xb));
+        }
+        __m256i offset = _mm256_set_m128i(offsets[1], offsets[0]);
+        int outside = ~_mm256_movemask_ps(_mm256_castsi256_ps(
+                _mm256_cmpeq_epi32(_mm256_min_epu32(offset, limit), offset)));
+        if (outside & 0xFF) {
+            return i + __builtin_ctz(outside);
+        }
+        __m256 v00 = _mm256_i32gather_ps(raster,             offset, 4);
+        __m256 v01 = _mm256_i32gather_ps(raster + 1,         offset, 4);
+        __m256 v10 = _mm256_i32gather_ps(raster + width,     offset, 4);
+        __m256 v11 = _mm256_i32gather_ps(raster + width + 1, offset, 4);
+        __m256i reason = _mm256_max_epi32(
+                _mm256_max_epi32(_mm256_castps_si256(v00), _mm256_castps_si256(v01)),
+                _mm256_max_epi32(_mm256_castps_si256(v10), _mm256_castps_si256(v11)));
+        _mm256_storeu_si256((__m256i*) (reasons + i), reason);
+        __m256d d00[2] = {_mm256_cvtps_pd(_mm256_castps256_ps128(v00)), _mm256_cvtps_pd(_mm256_extractf128_ps(v00, 1))};
+        __m256d d01[2] = {_mm256_cvtps_pd(_mm256_castps256_ps128(v01)), _mm256_cvtps_pd(_mm256_extractf128_ps(v01, 1))};
+        __m256d d10[2] = {_mm256_cvtps_pd(_mm256_castps256_ps128(v10)), _mm256_cvtps_pd(_mm256_extractf128_ps(v10, 1))};
+        __m256d d11[2] = {_mm256_cvtps_pd(_mm256_castps256_ps128(v11)), _mm256_cvtps_pd(_mm256_extractf128_ps(v11, 1))};
+        for (int h=0; h<2; h++) {
+            __m256d v0 = _mm256_fmadd_pd(_mm256_sub_pd(d01[h], d00[h]), xf[h], d00[h]);
+            __m256d v1 = _mm256_fmadd_pd(_mm256_sub_pd(d11[h], d10[h]), xf[h], d10[h]);
+            _mm256_storeu_pd(results + i + 4*h, _mm256_fmadd_pd(_mm256_sub_pd(v1, v0), yf[h], v0));
+        }
+    }
+    return i + interpolateScalar<FIXED_WIDTH>(raster, width, height, coordinates + 2*i, count - i, results + i, reasons + i);
+}
+
+/*
+ * Returns the 8 floats in the upper half of the given AVX-512 vector.
+ * AVX-512F has no instruction for extracting 256 bits of floats, so we extract them as doubles.
+ */
+__attribute__((target("avx512f")))
+inline __m256 upperHalf(__m512 v) {
+    return _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1));
+}
+
+/*
+ * Interpolates 16 points per step with AVX-512 instructions.
+ * This is the same algorithm as `interpolateAVX2`, but the 16 raster values
+ * needed for each corner are fetched with a single gather instruction.
+ */
+template<int FIXED_WIDTH>
+__attribute__((target("avx512f")))
+int interpolateAVX512(const float* raster, int width, int height, const double* coordinates, int count, double* results, int32_t* reasons) {
+    if (FIXED_WIDTH != 0) width = FIXED_WIDTH;
+    const __m512d widths = _mm512_set1_pd(width);
+    const __m512i evens = _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0);
+    const __m512i odds  = _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1);
+    const __m512i limit = _mm512_set1_epi32(OFFSET_LIMIT);
+    int i = 0;
+    for (; i <= count - 16; i += 16) {
+        __m512d xf[2], yf[2];
+        __m256i offsets[2];
+        for (int h=0; h<2; h++) {
+            const double* p = coordinates + 2*(i + 8*h);
+            __m512d p0 = _mm512_loadu_pd(p);
+            __m512d p1 = _mm512_loadu_pd(p + 8);
+            __m512d x  = _mm512_permutex2var_pd(p0, evens, p1);
+            __m512d y  = _mm512_permutex2var_pd(p0, odds,  p1);
+            __m512d xb = _mm512_roundscale_pd(x, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+            __m512d yb = _mm512_roundscale_pd(y, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+            xf[h] = _mm512_sub_pd(x, xb);
+            yf[h] = _mm512_sub_pd(y, yb);
+            offsets[h] = _mm512_cvttpd_epi32(_mm512_fmadd_pd(yb, widths, xb));
+        }
+        __m512i offset = _mm512_inserti64x4(_mm512_castsi256_si512(offsets[0]), offsets[1], 1);
+        __mmask16 outside = _mm512_cmpge_epu32_mask(offset, limit);
+        if (outside) {
+            return i + __builtin_ctz(outside);
+        }
+        __m512 v00 = _mm512_i32gather_ps(offset, raster,             4);
+        __m512 v01 = _mm512_i32gather_ps(offset, raster + 1,         4);
+        __m512 v10 = _mm512_i32gather_ps(offset, raster + width,     4);
+        __m512 v11 = _mm512_i32gather_ps(offset, raster + width + 1, 4);
+        __m512i reason = _mm512_max_epi32(
+                _mm512_max_epi32(_mm512_castps_si512(v00), _mm512_castps_si512(v01)),
+                _mm512_max_epi32(_mm512_castps_si512(v10), _mm512_castps_si512(v11)));
+        _mm512_storeu_si512(reasons + i, reason);
+        __m512d d00[2] = {_mm512_cvtps_pd(_mm512_castps512_ps256(v00)), _mm512_cvtps_pd(upperHalf(v00))};
+        __m512d d01[2] = {_mm512_cvtps_pd(_mm512_castps512_ps256(v01)), _mm512_cvtps_pd(upperHalf(v01))};
+        __m512d d10[2] = {_mm512_cvtps_pd(_mm512_castps512_ps256(v10)), _mm512_cvtps_pd(upperHalf(v10))};
+        __m512d d11[2] = {_mm512_cvtps_pd(_mm512_castps512_ps256(v11)), _mm512_cvtps_pd(upperHalf(v11))};
+        for (int h=0; h<2; h++) {
+            __m512d v0 = _mm512_fmadd_pd(_mm512_sub_pd(d01[h], d00[h]), xf[h], d00[h]);
+            __m512d v1 = _mm512_fmadd_pd(_mm512_sub_pd(d11[h], d10[h]), xf[h], d10[h]);
+            _mm512_storeu_pd(results + i + 8*h, _mm512_fmadd_pd(_mm512_sub_pd(v1, v0), yf[h], v0));
+        }
+    }
+    return i + interpolateAVX2<FIXED_WIDTH>(raster, width, height, coordinates + 2*i, count - i, results + i, reasons + i);
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+/*
+ * Interpolates 4 points per step with NEON instructions. NEON has no gather instruction,
+ * so the raster values are loaded lane by lane. The arithmetic, the missing value reason
+ * and the bound check are vectorized as in the x86 kernels.
+ */
+template<int FIXED_WIDTH>
+int interpolateNEON(const float* raster, int width, int height, const double* coordinates, int count, double* results, int32_t* reasons) {
+    if (FIXED_WIDTH != 0) width = FIXED_WIDTH;
+    const float64x2_t widths = vdupq_n_f64(width);
+    const uint32x4_t  limit = vdupq_n_u32(OFFSET_LIMIT);
+    int i = 0;
+    for (; i <= count - 4; i += 4) {
+        float64x2_t xf[2], yf[2];
+        int64x2_t offsets[2];
+        for (int h=0; h<2; h++) {
+            float64x2x2_t p  = vld2q_f64(coordinates + 2*(i + 2*h));    // Deinterleaves x and y.
+            float64x2_t   xb = vrndmq_f64(p.val[0]);
+            float64x2_t   yb = vrndmq_f64(p.val[1]);
+            xf[h] = vsubq_f64(p.val[0], xb);
+            yf[h] = vsubq_f64(p.val[1], yb);
+            offsets[h] = vcvtq_s64_f64(vfmaq_f64(xb, yb, widths));
+        }
+        int32x4_t offset = vcombine_s32(vqmovn_s64(offsets[0]), vqmovn_s64(offsets[1]));     // Saturated, not truncated.
+        if (vminvq_u32(vcltq_u32(vreinterpretq_u32_s32(offset), limit)) == 0) {
+            for (int j=0; ; j++) {
+                int32_t o = offset[j];
+                if (o < 0 || o >= OFFSET_LIMIT) return i + j;
+            }
+        }
+        float32x4_t v00 = vdupq_n_f32(0), v01 = v00, v10 = v00, v11 = v00;
+        #define NEON_GATHER(lane) {                                             \
+            int32_t o = vgetq_lane_s32(offset, lane);                           \
+            v00 = vld1q_lane_f32(raster + o,             v00, lane);            \
+            v01 = vld1q_lane_f32(raster + o + 1,         v01, lane);            \
+            v10 = vld1q_lane_f32(raster + o + width,     v10, lane);            \
+            v11 = vld1q_lane_f32(raster + o + width + 1, v11, lane);            \
+        }
+        NEON_GATHER(0) NEON_GATHER(1) NEON_GATHER(2) NEON_GATHER(3)
+        #undef NEON_GATHER
+        int32x4_t reason = vmaxq_s32(
+                vmaxq_s32(vreinterpretq_s32_f32(v00), vreinterpretq_s32_f32(v01)),
+                vmaxq_s32(vreinterpretq_s32_f32(v10), vreinterpretq_s32_f32(v11)));
+        vst1q_s32(reasons + i, reason);
+        float64x2_t d00[2] = {vcvt_f64_f32(vget_low_f32(v00)), vcvt_high_f64_f32(v00)};
+        float64x2_t d01[2] = {vcvt_f64_f32(vget_low_f32(v01)), vcvt_high_f64_f32(v01)};
+        float64x2_t d10[2] = {vcvt_f64_f32(vget_low_f32(v10)), vcvt_high_f64_f32(v10)};
+        float64x2_t d11[2] = {vcvt_f64_f32(vget_low_f32(v11)), vcvt_high_f64_f32(v11)};
+        for (int h=0; h<2; h++) {
+            float64x2_t v0 = vfmaq_f64(d00[h], vsubq_f64(d01[h], d00[h]), xf[h]);
+            float64x2_t v1 = vfmaq_f64(d10[h], vsubq_f64(d11[h], d10[h]), xf[h]);
+            vst1q_f64(results + i + 2*h, vfmaq_f64(v0, vsubq_f64(v1, v0), yf[h]));
+        }
+    }
+    return i + interpolateScalar<FIXED_WIDTH>(raster, width, height, coordinates + 2*i, count - i, results + i, reasons + i);
+}
+#endif
+
+/*
+ * Returns the specialization of the given kernel template for the given raster width.
+ * The specialized widths are arbitrary choices of common tile sizes, in addition to
+ * the width of the rasters generated by the Java code. Other widths use the generic kernel.
+ */
+#define SPECIALIZE_WIDTH(kernel, width) (        \
+    (width) ==  256 ? kernel<256>  :             \
+    (width) ==  512 ? kernel<512>  :             \
+    (width) ==  800 ? kernel<800>  :             \
+    (width) == 1024 ? kernel<1024> :             \
+    (width) == 2048 ? kernel<2048> :             \
+    (width) == 4096 ? kernel<4096> : kernel<0>)
+
+/*
+ * Returns the fastest interpolation kernel supported by the processor on which this code is running,
+ * specialized for the given raster width if possible. The name of the selected instruction set is
+ * stored in `name` for information purpose.
+ */
+InterpolationKernel selectInterpolationKernel(int width, const char** name) {
+    #if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx512f")) {
+        *name = "AVX-512 (16 points per step)";
+        return SPECIALIZE_WIDTH(interpolateAVX512, width);
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        *name = "AVX2 (8 points per step)";
+        return SPECIALIZE_WIDTH(interpolateAVX2, width);
+    }
+    #elif defined(__ARM_NEON) && defined(__aarch64__)
+    *name = "NEON (4 points per step)";
+    return SPECIALIZE_WIDTH(interpolateNEON, width);
+    #endif
+    *name = "scalar (1 point per step)";
+    return SPECIALIZE_WIDTH(interpolateScalar, width);
+}
+
+/*
+ * Signature of the functions packing the missing value reasons computed by a kernel on 2 bits per point.
+ * The `reasons` array contains `count` values as computed by `InterpolationKernel`, where `count` is a
+ * multiple of `REASONS_PER_BYTE` except for the last batch. The function writes `(count + 3) / 4` bytes
+ * in `packed`, and returns the number of reasons which are quiet NaNs (i.e., of missing values).
+ */
+typedef int (*ReasonPacker)(const int32_t* reasons, int count, uint8_t* packed);
+
+/*
+ * Value of the first positive quiet NaN, which is also the reason of a missing value with a payload of 0.
+ */
+#define FIRST_QUIET_NAN 0x7FC00000
+
+/*
+ * Packs the reasons one point at a time. Used when no vector instruction set is available,
+ * and for the last points when their number is not a multiple of the vector length.
+ */
+int packReasonsScalar(const int32_t* reasons, int count, uint8_t* packed) {
+    int numMissing = 0;
+    for (int i=0; i<count; i += REASONS_PER_BYTE) {
+        uint8_t codes = 0;
+        for (int j=0; j < REASONS_PER_BYTE && i + j < count; j++) {
+            int32_t reason  = reasons[i + j];
+            bool    missing = (reason >= FIRST_QUIET_NAN);
+            codes      |= (missing ? std::min(reason - FIRST_QUIET_NAN, 3) : 0) << (2*j);
+            numMissing += missing;
+        }
+        packed[i / REASONS_PER_BYTE] = codes;
+    }
+    return numMissing;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/*
+ * Packs 8 reasons per step with AVX2 instructions. The codes are shifted to their bit position, then the
+ * four codes of each byte are merged by two horizontal additions, which are equivalent to OR because the
+ * codes do not overlap. The subtraction may overflow for negative reasons, but those are not NaN.
+ */
+__attribute__((target("avx2")))
+int packReasonsAVX2(const int32_t* reasons, int count, uint8_t* packed) {
+    const __m256i first  = _mm256_set1_epi32(FIRST_QUIET_NAN);
+    const __m256i last   = _mm256_set1_epi32(FIRST_QUIET_NAN - 1);
+    const __m256i three  = _mm256_set1_epi32(3);
+    const __m256i shifts = _mm256_set_epi32(6, 4, 2, 0, 6, 4, 2, 0);
+    int numMissing = 0;
+    int i = 0;
+    for (; i <= count - 8; i += 8) {
+        __m256i reason  = _mm256_loadu_si256((const __m256i*) (reasons + i));
+        __m256i missing = _mm256_cmpgt_epi32(reason, last);
+        __m256i code    = _mm256_and_si256(missing, _mm256_min_epu32(_mm256_sub_epi32(reason, first), three));
+        code = _mm256_sllv_epi32(code, shifts);
+        code = _mm256_hadd_epi32(code, code);
+        code = _mm256_hadd_epi32(code, code);
+        packed[i / REASONS_PER_BYTE]     = (uint8_t) _mm256_extract_epi32(code, 0);
+        packed[i / REASONS_PER_BYTE + 1] = (uint8_t) _mm256_extract_epi32(code, 4);
+        numMissing += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(missing)));
+    }
+    return numMissing + packReasonsScalar(reasons + i, count - i, packed + i / REASONS_PER_BYTE);
+}
+
+/*
+ * Packs 16 reasons per step with AVX-512 instructions. The codes are computed as in `packReasonsAVX2`,
+ * then narrowed to bytes, and the four bytes of each group are merged by a multiplication which moves
+ * each code to its position in the most significant byte of a 32 bits integer. The other products
+ * of that multiplication fall in distinct bits of the lower bytes, so they do not carry.
+ */
+__attribute__((target("avx512f")))
+int packReasonsAVX512(const int32_t* reasons, int count, uint8_t* packed) {
+    const __m512i first = _mm512_set1_epi32(FIRST_QUIET_NAN);
+    const __m512i three = _mm512_set1_epi32(3);
+    int numMissing = 0;
+    int i = 0;
+    for (; i <= count - 16; i += 16) {
+        __m512i   reason  = _mm512_loadu_si512(reasons + i);
+        __mmask16 missing = _mm512_cmpge_epi32_mask(reason, first);
+        __m512i   code    = _mm512_maskz_min_epu32(missing, _mm512_sub_epi32(reason, first), three);
+        __m128i   bytes   = _mm512_cvtepi32_epi8(code);                     // 16 codes of 8 bits.
+        __m128i   merged  = _mm_mullo_epi32(bytes, _mm_set1_epi32(0x01041040));
+        merged = _mm_srli_epi32(merged, 24);                                // 4 codes of 2 bits per integer.
+        uint32_t words[4];
+        _mm_storeu_si128((__m128i*) words, merged);
+        for (int j=0; j<4; j++) {
+            packed[i / REASONS_PER_BYTE + j] = (uint8_t) words[j];
+        }
+        numMissing += __builtin_popcount(missing);
+    }
+    return numMissing + packReasonsAVX2(reasons + i, count - i, packed + i / REASONS_PER_BYTE);
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+/*
+ * Packs 4 reasons per step with NEON instructions. The codes are shifted to their bit position,
+ * then merged by a horizontal addition, which is equivalent to OR because the codes do not overlap.
+ */
+int packReasonsNEON(const int32_t* reasons, int count, uint8_t* packed) {
+    const int32x4_t first  = vdupq_n_s32(FIRST_QUIET_NAN);
+    const uint32x4_t three = vdupq_n_u32(3);
+    const int32_t   shiftValues[4] = {0, 2, 4, 6};
+    const int32x4_t shifts = vld1q_s32(shiftValues);
+    int numMissing = 0;
+    int i = 0;
+    for (; i <= count - 4; i += 4) {
+        int32x4_t  reason  = vld1q_s32(reasons + i);
+        uint32x4_t missing = vcgeq_s32(reason, first);
+        uint32x4_t code    = vandq_u32(missing, vminq_u32(vreinterpretq_u32_s32(vsubq_s32(reason, first)), three));
+        packed[i / REASONS_PER_BYTE] = (uint8_t) vaddvq_u32(vshlq_u32(code, shifts));
+        numMissing -= vaddvq_s32(vreinterpretq_s32_u32(missing));         // Each `missing` lane is 0 or -1.
+    }
+    return numMissing + packReasonsScalar(reasons + i, count - i, packed + i / REASONS_PER_BYTE);
+}
+#endif
+
+/*
+ * Returns the fastest function for packing the reasons on the processor on which this code is running.
+ */
+static ReasonPacker selectReasonPacker() {
+    #if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx512f")) {
+        return packReasonsAVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return packReasonsAVX2;
+    }
+    #elif defined(__ARM_NEON) && defined(__aarch64__)
+    return packReasonsNEON;
+    #endif
+    return packReasonsScalar;
+}
+
+/*
+ * Creates a description of the given raster and selects the fastest kernel for its width.
+ * The values are not copied: the array shall stay valid as long as this raster is used.
+ */
+Raster::Raster(const float* data, int numColumns, int numRows) {
+    const char* name;
+    values      = data;
+    width       = numColumns;
+    height      = numRows;
+    kernel      = selectInterpolationKernel(width, &name);
+    tileShift   = 0;
+    tilesPerRow = 0;
+}
+
+/*
+ * Signature of the functions updating the minimum and maximum bit patterns of `length` raster values,
+ * compared as signed integers. Used for computing the summary of tiles one row at a time.
+ */
+typedef void (*RangeFunction)(const float* values, int length, int32_t& min, int32_t& max);
+
+/*
+ * Computes the range of bit patterns one value at a time. Used when no vector instruction set
+ * is available, and for the last values of a row when their number is not a multiple of the vector length.
+ */
+void rangeOfBitsScalar(const float* values, int length, int32_t& min, int32_t& max) {
+    for (int i=0; i<length; i++) {
+        int32_t bits = std::bit_cast<int32_t>(values[i]);
+        min = std::min(min, bits);
+        max = std::max(max, bits);
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/*
+ * Computes the range of bit patterns 8 values per step with AVX2 instructions.
+ */
+__attribute__((target("avx2")))
+void rangeOfBitsAVX2(const float* values, int length, int32_t& min, int32_t& max) {
+    __m256i vmin = _mm256_set1_epi32(min);
+    __m256i vmax = _mm256_set1_epi32(max);
+    int i = 0;
+    for (; i <= length - 8; i += 8) {
+        __m256i bits = _mm256_loadu_si256((const __m256i*) (values + i));
+        vmin = _mm256_min_epi32(vmin, bits);
+        vmax = _mm256_max_epi32(vmax, bits);
+    }
+    int32_t lanes[8];
+    _mm256_storeu_si256((__m256i*) lanes, vmin);
+    min = *std::min_element(lanes, lanes + 8);
+    _mm256_storeu_si256((__m256i*) lanes, vmax);
+    max = *std::max_element(lanes, lanes + 8);
+    rangeOfBitsScalar(values + i, length - i, min, max);
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+/*
+ * Computes the range of bit patterns 4 values per step with NEON instructions.
+ */
+void rangeOfBitsNEON(const float* values, int length, int32_t& min, int32_t& max) {
+    int32x4_t vmin = vdupq_n_s32(min);
+    int32x4_t vmax = vdupq_n_s32(max);
+    int i = 0;
+    for (; i <= length - 4; i += 4) {
+        int32x4_t bits = vreinterpretq_s32_f32(vld1q_f32(values + i));
+        vmin = vminq_s32(vmin, bits);
+        vmax = vmaxq_s32(vmax, bits);
+    }
+    min = vminvq_s32(vmin);
+    max = vmaxvq_s32(vmax);
+    rangeOfBitsScalar(values + i, length - i, min, max);
+}
+#endif
+
+/*
+ * Computes the summary of the tiles of `1 << shift` pixels. This is a single pass over the raster,
+ * which pays for itself when the raster is used for at least one batch covering most of the tiles.
+ * A tile is fully valid if no bit pattern is a quiet NaN, which is the same "positive NaN" assumption
+ * as the kernels. A tile is fully missing if all bit patterns are the same NaN.
+ */
+void Raster::summarize(int shift) {
+    RangeFunction range = rangeOfBitsScalar;
+    #if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) {
+        range = rangeOfBitsAVX2;
+    }
+    #elif defined(__ARM_NEON) && defined(__aarch64__)
+    range = rangeOfBitsNEON;
+    #endif
+    const int tileSize = 1 << shift;
+    tileShift   = shift;
+    tilesPerRow = (width + tileSize - 1) >> shift;
+    int tilesPerColumn = (height + tileSize - 1) >> shift;
+    tiles.resize((size_t) tilesPerRow * tilesPerColumn);
+    for (int ty=0; ty<tilesPerColumn; ty++) {
+        int y0 = ty << shift;
+        int y1 = std::min(y0 + tileSize, height - 1);       // Inclusive.
+        for (int tx=0; tx<tilesPerRow; tx++) {
+            int x0 = tx << shift;
+            int x1 = std::min(x0 + tileSize, width - 1);    // Inclusive.
+            int32_t min = INT32_MAX;
+            int32_t max = INT32_MIN;
+            for (int y=y0; y<=y1; y++) {
+                range(values + (size_t) y * width + x0, x1 - x0 + 1, min, max);
+            }
+            int32_t summary = TILE_MIXED;
+            if (max < FIRST_QUIET_NAN) {
+                summary = TILE_ALL_VALID;
+            } else if (min == max) {
+                summary = max;
+            }
+            tiles[(size_t) ty * tilesPerRow + tx] = summary;
+        }
+    }
+}
+
+/*
+ * Computes the minimal and maximal (x,y) coordinates of `length` points, which shall be at least 1.
+ * With vector instructions, each (x,y) tuple is a vector and 4 accumulators break the dependency chains.
+ * SSE2 is always available on x86-64, so no runtime dispatch is needed.
+ */
+static void boundingBox(const double* coordinates, int length, double* lower, double* upper) {
+    int i = 0;
+    #if defined(__SSE2__)
+    __m128d lo[4], hi[4];
+    for (int k=0; k<4; k++) {
+        lo[k] = hi[k] = _mm_loadu_pd(coordinates);
+    }
+    for (; i <= length - 4; i += 4) {
+        for (int k=0; k<4; k++) {
+            __m128d p = _mm_loadu_pd(coordinates + 2*(i + k));
+            lo[k] = _mm_min_pd(lo[k], p);
+            hi[k] = _mm_max_pd(hi[k], p);
+        }
+    }
+    _mm_storeu_pd(lower, _mm_min_pd(_mm_min_pd(lo[0], lo[1]), _mm_min_pd(lo[2], lo[3])));
+    _mm_storeu_pd(upper, _mm_max_pd(_mm_max_pd(hi[0], hi[1]), _mm_max_pd(hi[2], hi[3])));
+    #elif defined(__ARM_NEON) && defined(__aarch64__)
+    float64x2_t lo[4], hi[4];
+    for (int k=0; k<4; k++) {
+        lo[k] = hi[k] = vld1q_f64(coordinates);
+    }
+    for (; i <= length - 4; i += 4) {
+        for (int k=0; k<4; k++) {
+            float64x2_t p = vld1q_f64(coordinates + 2*(i + k));
+            lo[k] = vminq_f64(lo[k], p);
+            hi[k] = vmaxq_f64(hi[k], p);
+        }
+    }
+    vst1q_f64(lower, vminq_f64(vminq_f64(lo[0], lo[1]), vminq_f64(lo[2], lo[3])));
+    vst1q_f64(upper, vmaxq_f64(vmaxq_f64(hi[0], hi[1]), vmaxq_f64(hi[2], hi[3])));
+    #else
+    lower[0] = upper[0] = coordinates[0];
+    lower[1] = upper[1] = coordinates[1];
+    #endif
+    for (; i < length; i++) {
+        for (int k=0; k<2; k++) {
+            lower[k] = std::min(lower[k], coordinates[2*i + k]);
+            upper[k] = std::max(upper[k], coordinates[2*i + k]);
+        }
+    }
+}
+
+/*
+ * Interpolates a batch of points with the kernel of the raster, using the summary of tiles if available.
+ * The summary is used by sub-batches of `SIMD_BATCH_SIZE` points: if all tiles intersecting the bounding
+ * box of the points of a sub-batch are fully missing for the same reason, the results and reasons are set
+ * to that reason without any access to the raster and without arithmetic. Otherwise, the kernel is invoked
+ * on the whole sub-batch. A test per point would cost as much as the kernel when the raster is in the cache,
+ * while the bounding box is computed with a few vector instructions per point. The sub-batches are in a single tile when
+ * the points are sorted by tiles, as done by the binning option of the tests.
+ * The return value has the same meaning as for `InterpolationKernel`.
+ */
+static int interpolateBatch(const Raster& raster, const double* xy, int count, double* results, int32_t* reasons) {
+    if (raster.tiles.empty()) {
+        return raster.kernel(raster.values, raster.width, raster.height, xy, count, results, reasons);
+    }
+    for (int start=0; start < count; start += SIMD_BATCH_SIZE) {
+        const int length = std::min(SIMD_BATCH_SIZE, count - start);
+        const double* p  = xy + 2*start;
+        /*
+         * Look first at the tile of the first point, which avoids the computation of the bounding box for
+         * the sub-batches in valid or mixed tiles. Points outside the raster are not resolved here: they will
+         * be reported by the kernel. If the first tile is fully missing, verify that all tiles intersecting
+         * the bounding box are missing for the same reason.
+         */
+        int32_t summary = TILE_MIXED;
+        if (p[0] >= 0 && p[1] >= 0 && p[0] < raster.width && p[1] < raster.height) {
+            summary = raster.tiles[(((int) p[1]) >> raster.tileShift) * raster.tilesPerRow + (((int) p[0]) >> raster.tileShift)];
+        }
+        if (summary > TILE_MIXED) {
+            double lower[2], upper[2];
+            boundingBox(p, length, lower, upper);
+            if (lower[0] >= 0 && lower[1] >= 0 && upper[0] < raster.width && upper[1] < raster.height) {
+                const int tx0 = ((int) lower[0]) >> raster.tileShift, tx1 = ((int) upper[0]) >> raster.tileShift;
+                const int ty0 = ((int) lower[1]) >> raster.tileShift, ty1 = ((int) upper[1]) >> raster.tileShift;
+                for (int ty=ty0; ty<=ty1 && summary > TILE_MIXED; ty++) {
+                    for (int tx=tx0; tx<=tx1; tx++) {
+                        if (raster.tiles[ty * raster.tilesPerRow + tx] != summary) {
+                            summary = TILE_MIXED;
+                            break;
+                        }
+                    }
+                }
+            } else {
+                summary = TILE_MIXED;
+            }
+        }
+        if (summary > TILE_MIXED) {
+            std::fill(results + start, results + start + length, (double) std::bit_cast<float>(summary));
+            std::fill(reasons + start, reasons + start + length, summary);
+        } else {
+            int valid = raster.kernel(raster.values, raster.width, raster.height, p, length, results + start, reasons + start);
+            if (valid != length) {
+                return start + valid;
+            }
+        }
+    }
+    return count;
+}
+
+/*
+ * Verifies that the output arrays have room for all points, and returns the number of points.
+ */
+static int numPoints(std::span<const double> xy, size_t numResults, size_t numReasons) {
+    size_t count = xy.size() / 2;
+    if (numResults < count || numReasons < count) {
+        throw std::length_error("The output arrays are shorter than the number of points.");
+    }
+    return (int) count;
+}
+
+/*
+ * Interpolates the raster at all points given as (x,y) tuples in the `xy` array, in pixel units.
+ * The results are stored in `out` and the missing value reasons in `reasons`, both with one value per point.
+ * A reason is the maximal bit pattern of the four pixels used by the interpolation, compared as signed integers.
+ * If the reason is a quiet NaN (0x7FC00000 or greater), the result is missing and the reason has the payload of
+ * the NaN having precedence. Otherwise the result is valid. The points are given to the kernel in a single call.
+ *
+ * Returns the number of points that have been interpolated. This is the number of points in `xy`, unless
+ * a point is outside the raster, in which case the value is the index of that point and the following
+ * points are not interpolated. Throws `std::length_error` if an output array is too short.
+ */
+int interpolate(const Raster& raster, std::span<const double> xy, std::span<double> out, std::span<int32_t> reasons) {
+    int count = numPoints(xy, out.size(), reasons.size());
+    return interpolateBatch(raster, xy.data(), count, out.data(), reasons.data());
+}
+
+/*
+ * Same as above, but with the results stored as single-precision values. The points are interpolated by
+ * batches of `SIMD_BATCH_SIZE` points in double-precision, then converted. Missing results stay NaN.
+ */
+int interpolate(const Raster& raster, std::span<const double> xy, std::span<float> out, std::span<int32_t> reasons) {
+    double results[SIMD_BATCH_SIZE];
+    int count = numPoints(xy, out.size(), reasons.size());
+    for (int start=0; start < count; start += SIMD_BATCH_SIZE) {
+        int length = std::min(SIMD_BATCH_SIZE, count - start);
+        int valid  = interpolateBatch(raster, xy.data() + 2*start, length, results, reasons.data() + start);
+        std::copy(results, results + valid, out.data() + start);
+        if (valid != length) {
+            return start + valid;
+        }
+    }
+    return count;
+}
+
+/*
+ * Implementation of `interpolatePacked(…)` for both types of results. The points are interpolated by batches
+ * of `SIMD_BATCH_SIZE` points, which is a multiple of `REASONS_PER_BYTE`, so each batch starts at a byte
+ * boundary of the packed reasons. The full reasons are kept only for the current batch.
+ */
+template<typename T>
+static int interpolatePacked(const Raster& raster, std::span<const double> xy, std::span<T> out, std::span<uint8_t> reasons, int* numMissing) {
+    static const ReasonPacker packer = selectReasonPacker();
+    double  results[SIMD_BATCH_SIZE];
+    int32_t unpacked[SIMD_BATCH_SIZE];
+    int count = numPoints(xy, out.size(), reasons.size() * REASONS_PER_BYTE);
+    int missing = 0;
+    int start = 0;
+    for (; start < count; start += SIMD_BATCH_SIZE) {
+        int length = std::min(SIMD_BATCH_SIZE, count - start);
+        int valid  = interpolateBatch(raster, xy.data() + 2*start, length, results, unpacked);
+        std::copy(results, results + valid, out.data() + start);
+        missing += packer(unpacked, valid, reasons.data() + start / REASONS_PER_BYTE);
+        if (valid != length) {
+            start += valid;
+            break;
+        }
+    }
+    if (numMissing) {
+        *numMissing = missing;
+    }
+    return std::min(start, count);
+}
+
+/*
+ * Interpolates the raster at all points given as (x,y) tuples in the `xy` array, in pixel units.
+ * This is the same as `interpolate(…)` except that the missing value reasons are packed on 2 bits per point,
+ * as described in `Interpolation.hpp`. The reasons of missing values are usually needed for only a few points,
+ * while the reduced memory bandwidth benefits to all points. If `numMissing` is non-null, it receives the
+ * number of missing results, which allows the caller to skip the check of NaN values if that number is zero.
+ *
+ * Returns the number of points that have been interpolated, as `interpolate(…)`. Throws `std::length_error`
+ * if `out` is shorter than the number of points or if `reasons` is shorter than a quarter of that number.
+ */
+int interpolatePacked(const Raster& raster, std::span<const double> xy, std::span<double> out, std::span<uint8_t> reasons, int* numMissing) {
+    return interpolatePacked<double>(raster, xy, out, reasons, numMissing);
+}
+
+/*
+ * Same as above, but with the results stored as single-precision values. Missing results stay NaN.
+ */
+int interpolatePacked(const Raster& raster, std::span<const double> xy, std::span<float> out, std::span<uint8_t> reasons, int* numMissing) {
+    return interpolatePacked<float>(raster, xy, out, reasons, numMissing);
+}
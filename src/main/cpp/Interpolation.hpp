@@ -0,0 +1,112 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#ifndef INTERPOLATION_HPP
+#define INTERPOLATION_HPP
+
+#include <cstdint>
+#include <cmath>
+#include <bit>
+#include <span>
+#include <vector>
+
+/*
+ * Number of points given to the vectorized interpolation kernels in a single call.
+ * The results of a batch are verified against the expected values before the next
+ * batch is interpolated, for keeping the temporary arrays small enough for the L1 cache.
+ */
+#define SIMD_BATCH_SIZE 256
+
+/*
+ * Signature of the kernels performing bilinear interpolations on a batch of points.
+ * The raster has `width` × `height` pixels. The `coordinates` array contains (x,y) tuples for `count` points. For each point,
+ * the kernel stores the interpolated value in `results` and the maximal bit pattern
+ * of the four raster values in `reasons`. The latter is meaningful only if the result
+ * is NaN, but is computed unconditionally for keeping the kernel free of branches.
+ *
+ * The kernel returns the number of points that have been interpolated. This is `count`,
+ * unless a point is out of bounds, in which case the value is the index of that point.
+ *
+ * Each kernel is a template where `FIXED_WIDTH` is either 0 for a raster of any width,
+ * or a constant which overwrites the `width` argument. The latter allows the compiler
+ * to fold the width in the computation of offsets, as when the width was a macro.
+ */
+typedef int (*InterpolationKernel)(const float*, int, int, const double*, int, double*, int32_t*);
+
+InterpolationKernel selectInterpolationKernel(int, const char**);
+
+/*
+ * Returns whether an interpolation result is missing. This is `std::isnan`, except when the compiler assumes
+ * that there is no NaN (GCC `-ffinite-math-only`, included in `-ffast-math`), in which case `std::isnan` may be
+ * optimized to `false`. The result is then compared as an integer: the results of the kernels are "positive" quiet
+ * NaNs when missing, which are greater than all other values when compared as signed integers. This is the same
+ * trick as `missingValueReason >= FIRST_QUIET_NAN` in `TestNaN`. Defining `NAN_FORCE_ISNAN` keeps `std::isnan`
+ * in all cases, for demonstrating the failure.
+ */
+inline bool isMissing(double result) {
+    #if __FINITE_MATH_ONLY__ && !defined(NAN_FORCE_ISNAN)
+    return std::bit_cast<int64_t>(result) >= 0x7FF8000000000000;
+    #else
+    return std::isnan(result);
+    #endif
+}
+
+/*
+ * Values of `Raster::tiles` for the tiles where all pixels are valid, and for the tiles having a mix
+ * of pixel values. Other values are the bit pattern of the NaN of tiles where all pixels are missing
+ * for the same reason, which is always greater than those two values.
+ */
+#define TILE_ALL_VALID 0
+#define TILE_MIXED     1
+
+/*
+ * A raster of `float` values in row-major order, with missing values identified by NaN payloads.
+ * The fastest kernel for the raster width is selected once at construction time, so the raster
+ * can be given to `interpolate(…)` for many batches of points without dispatch cost.
+ *
+ * Optionally, `summarize(…)` computes whether each tile of the raster is fully valid, fully missing
+ * for a single reason, or mixed. With that summary, the points in fully missing tiles get their
+ * result and reason without any memory access to the raster and without arithmetic.
+ */
+struct Raster {
+    const float* values;
+    int width;
+    int height;
+    InterpolationKernel kernel;
+
+    /*
+     * The summary of tiles of `1 << tileShift` pixels, or an empty vector if none.
+     * Each tile includes the first row and column of the next tiles, because those
+     * pixels are used by the interpolations of points at the right and bottom edges.
+     */
+    int tileShift;
+    int tilesPerRow;
+    std::vector<int32_t> tiles;
+
+    Raster(const float* values, int width, int height);
+    void summarize(int tileShift);
+};
+
+/*
+ * Bilinear interpolations of a batch of points. This is the entry point of the `naninterp` library,
+ * independent of the test harness. See `Interpolation.cpp` for the semantics of the arguments.
+ */
+int interpolate(const Raster&, std::span<const double> xy, std::span<double> out, std::span<int32_t> reasons);
+int interpolate(const Raster&, std::span<const double> xy, std::span<float>  out, std::span<int32_t> reasons);
+
+/*
+ * Number of missing value reasons packed in each byte by `interpolatePacked(…)`.
+ * The reason of point `i` is in bits `2*(i % 4)` and `2*(i % 4) + 1` of byte `i / 4`.
+ */
+#define REASONS_PER_BYTE 4
+
+/*
+ * Bilinear interpolations of a batch of points with the missing value reasons packed on 2 bits per point.
+ * The 2 bits are the payload of the NaN having precedence (0 for the default NaN), saturated to 3.
+ * They are meaningful only for the points where the result is NaN, and are zero for the other points.
+ */
+int interpolatePacked(const Raster&, std::span<const double> xy, std::span<double> out, std::span<uint8_t> reasons, int* numMissing = NULL);
+int interpolatePacked(const Raster&, std::span<const double> xy, std::span<float>  out, std::span<uint8_t> reasons, int* numMissing = NULL);
+
+#endif
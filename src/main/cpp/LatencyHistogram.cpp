@@ -0,0 +1,155 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cmath>
+#include <bit>
+#include <limits>
+#include <algorithm>
+#include "LatencyHistogram.hpp"
+
+/*
+ * The percentiles reported by the benchmark: median, 90th, 99th and 99.9th percentiles.
+ */
+const double LATENCY_PERCENTILES[NUM_LATENCY_PERCENTILES] = {0.5, 0.9, 0.99, 0.999};
+const char*  LATENCY_PERCENTILE_NAMES[NUM_LATENCY_PERCENTILES] = {"p50", "p90", "p99", "p999"};
+
+/*
+ * Number of buckets of values recorded exactly, and number of buckets for each power of 2 above.
+ */
+#define LINEAR_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)
+#define SUB_BUCKETS    (1 << (LATENCY_SUB_BUCKET_BITS - 1))
+
+/*
+ * Creates an empty histogram. The buckets cover all 64 bits values.
+ */
+LatencyHistogram::LatencyHistogram()
+        : counts(LINEAR_BUCKETS + (64 - LATENCY_SUB_BUCKET_BITS) * SUB_BUCKETS, 0)
+{
+    total   = 0;
+    minimum = std::numeric_limits<uint64_t>::max();
+    maximum = 0;
+    sum     = 0;
+}
+
+/*
+ * Returns the index of the bucket of the given value. Above the linear buckets, the position of the highest bit
+ * gives the power of 2, and the `LATENCY_SUB_BUCKET_BITS - 1` bits after it give the bucket in that power of 2.
+ */
+int LatencyHistogram::indexOf(uint64_t value) {
+    if (value < LINEAR_BUCKETS) {
+        return (int) value;
+    }
+    int power = 63 - std::countl_zero(value);
+    int shift = power - (LATENCY_SUB_BUCKET_BITS - 1);
+    return LINEAR_BUCKETS + (power - LATENCY_SUB_BUCKET_BITS) * SUB_BUCKETS + (int) ((value >> shift) - SUB_BUCKETS);
+}
+
+/*
+ * Returns the smallest value recorded in the bucket at the given index.
+ */
+uint64_t LatencyHistogram::lowerBound(int index) {
+    if (index < LINEAR_BUCKETS) {
+        return index;
+    }
+    index -= LINEAR_BUCKETS;
+    int power = LATENCY_SUB_BUCKET_BITS + index / SUB_BUCKETS;
+    return (uint64_t) (SUB_BUCKETS + index % SUB_BUCKETS) << (power - (LATENCY_SUB_BUCKET_BITS - 1));
+}
+
+/*
+ * Returns the largest value recorded in the bucket at the given index.
+ */
+uint64_t LatencyHistogram::upperBound(int index) {
+    if (index < LINEAR_BUCKETS) {
+        return index;
+    }
+    return lowerBound(index + 1) - 1;
+}
+
+/*
+ * Adds the given duration to the histogram.
+ */
+void LatencyHistogram::record(uint64_t nanos) {
+    counts[indexOf(nanos)]++;
+    total++;
+    sum    += nanos;
+    minimum = std::min(minimum, nanos);
+    maximum = std::max(maximum, nanos);
+}
+
+/*
+ * Adds all values recorded in the given histogram to this histogram.
+ */
+void LatencyHistogram::add(const LatencyHistogram& other) {
+    for (size_t i=0; i<counts.size(); i++) {
+        counts[i] += other.counts[i];
+    }
+    total  += other.total;
+    sum    += other.sum;
+    minimum = std::min(minimum, other.minimum);
+    maximum = std::max(maximum, other.maximum);
+}
+
+/*
+ * Returns the number of recorded values.
+ */
+uint64_t LatencyHistogram::count() const {
+    return total;
+}
+
+/*
+ * Returns the smallest recorded value, or 0 if the histogram is empty.
+ */
+uint64_t LatencyHistogram::min() const {
+    return (total != 0) ? minimum : 0;
+}
+
+/*
+ * Returns the largest recorded value, or 0 if the histogram is empty.
+ */
+uint64_t LatencyHistogram::max() const {
+    return maximum;
+}
+
+/*
+ * Returns the mean of the recorded values, or 0 if the histogram is empty.
+ */
+double LatencyHistogram::mean() const {
+    return (total != 0) ? sum / total : 0;
+}
+
+/*
+ * Returns the value below or equal to which the given fraction of the recorded values are. This is the largest
+ * value of the bucket containing the value of that rank, as in HdrHistogram, but not greater than the maximum.
+ * Returns 0 if the histogram is empty.
+ */
+uint64_t LatencyHistogram::percentile(double fraction) const {
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = std::clamp((uint64_t) std::ceil(fraction * total), (uint64_t) 1, total);
+    uint64_t cumulative = 0;
+    for (size_t i=0; i<counts.size(); i++) {
+        cumulative += counts[i];
+        if (cumulative >= rank) {
+            return std::min(upperBound((int) i), maximum);
+        }
+    }
+    return maximum;
+}
+
+/*
+ * Writes the non-empty buckets as a JSON array of [lower bound, upper bound, count] arrays, in nanoseconds.
+ */
+void LatencyHistogram::writeBuckets(std::ostream& out) const {
+    const char* separator = "";
+    out << '[';
+    for (size_t i=0; i<counts.size(); i++) {
+        if (counts[i] != 0) {
+            out << separator << '[' << lowerBound((int) i) << ", " << upperBound((int) i) << ", " << counts[i] << ']';
+            separator = ", ";
+        }
+    }
+    out << ']';
+}
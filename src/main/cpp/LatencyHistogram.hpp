@@ -0,0 +1,62 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <cstdint>
+#include <vector>
+#include <ostream>
+
+/*
+ * Number of bits of the values recorded exactly by `LatencyHistogram`. Larger values are recorded with
+ * `LATENCY_SUB_BUCKET_BITS - 1` significant bits, which is a relative precision better than 2%.
+ */
+#define LATENCY_SUB_BUCKET_BITS 7
+
+/*
+ * Number of percentiles reported by `LatencyHistogram`, and their values as fractions.
+ */
+#define NUM_LATENCY_PERCENTILES 4
+extern const double LATENCY_PERCENTILES[NUM_LATENCY_PERCENTILES];
+extern const char*  LATENCY_PERCENTILE_NAMES[NUM_LATENCY_PERCENTILES];
+
+/*
+ * Histogram of durations in nanoseconds with buckets of logarithmic sizes, in the way of HdrHistogram.
+ * The values below 2^`LATENCY_SUB_BUCKET_BITS` have one bucket each. Above, each range from a power of 2
+ * to the next one is divided in 2^(`LATENCY_SUB_BUCKET_BITS` - 1) buckets of equal size. The memory and
+ * the cost of recording a value are therefore constant, while the tail of the distribution, which is
+ * hidden by the mean and the standard deviation, keeps the same relative precision as the median.
+ *
+ * This class is not thread-safe. Threads shall record in their own histograms, merged with `add(…)`.
+ */
+class LatencyHistogram {
+    /*
+     * Number of values recorded in each bucket.
+     */
+    std::vector<uint64_t> counts;
+
+    /*
+     * Number of values, their sum, and the smallest and largest values recorded.
+     */
+    uint64_t total, minimum, maximum;
+    double sum;
+
+    static int      indexOf(uint64_t);
+    static uint64_t lowerBound(int);
+    static uint64_t upperBound(int);
+
+    public:
+        LatencyHistogram();
+        void     record(uint64_t nanos);
+        void     add(const LatencyHistogram&);
+        uint64_t count() const;
+        uint64_t min() const;
+        uint64_t max() const;
+        double   mean() const;
+        uint64_t percentile(double) const;
+        void     writeBuckets(std::ostream&) const;
+};
+
+#endif
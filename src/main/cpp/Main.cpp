@@ -0,0 +1,106 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <memory>
+#include "TestCase.hpp"
+#include "ResamplingTest.hpp"
+
+/*
+ * Helper method for diagnostic before test in the main method.
+ */
+void printNaNSupport(const char* functionName, double result) {
+    printf("Test support in %-6s %f\n", functionName, result);
+}
+
+/*
+ * Helper method for testing `std::nanf(const char*)` in the main method.
+ */
+void testDistinctNaN(const char* tagp) {
+    float value = std::nanf(tagp);
+    printf("%-8s isNaN=%s, bits=%8x\n", tagp, std::isnan(value) ? "true" : "false", floatToRawIntBits(value));
+}
+
+/*
+ * Test the support of NaN in a few mathematical functions, then run the test.
+ * See `Configuration::parse(…)` for the command-line options.
+ */
+int main(int argc, char** argv) {
+    if (!config.parse(argc, argv)) {
+        return 1;
+    }
+    float n = rand();
+    printNaNSupport("+:",     n + NAN);
+    printNaNSupport("-:",     n - NAN);
+    printNaNSupport("*:",     n * NAN);
+    printNaNSupport("/:",     n / NAN);
+    printNaNSupport("sin:",   std::sin  (NAN));
+    printNaNSupport("cos:",   std::cos  (NAN));
+    printNaNSupport("tan:",   std::tan  (NAN));
+    printNaNSupport("asin:",  std::asin (NAN));
+    printNaNSupport("acos:",  std::acos (NAN));
+    printNaNSupport("atan:",  std::atan (NAN));
+    printNaNSupport("atan2:", std::atan2(NAN, 1));
+    printNaNSupport("floor:", std::floor(NAN));
+    printNaNSupport("ceil:",  std::ceil (NAN));
+    printNaNSupport("trunc:", std::trunc(NAN));
+    printNaNSupport("pow:",   std::pow  (NAN, 2));
+    printNaNSupport("sqrt:",  std::sqrt (NAN));
+    printNaNSupport("hypot:", std::hypot(NAN, 3));
+    printf("Test support in %-6s %s\n", "isnan:", std::isnan(n + NAN) ? "ok" : "FAIL");
+    #ifdef __FAST_MATH__
+    std::cout << "Fast math option detected.\n";
+    #endif
+    /*
+     * Bonus: the C++ 11 standard has methods for creating distincts quiet NaN values,
+     * and even for parsing them from character strings.
+     */
+    std::cout << '\n';
+    std::cout << "Test the std::nanf(char*) function from C++ 11 standard:\n";
+    testDistinctNaN("cloud");
+    testDistinctNaN("land");
+    testDistinctNaN("no_pass");
+    testDistinctNaN("1");
+    testDistinctNaN("2");
+    testDistinctNaN("35");
+    testDistinctNaN("400");
+    printf("%s bits=%8x\n", "strtof(\"NAN(cloud)\"):", floatToRawIntBits(std::strtof("NAN(cloud)", NULL)));
+    printf("%s bits=%8x\n", "strtof(\"NAN(2)\"):",     floatToRawIntBits(std::strtof("NAN(2)", NULL)));
+    std::cout << '\n';
+    const char* kernelName;
+    selectInterpolationKernel(config.width, &kernelName);
+    std::cout << "Vectorized interpolation kernel: " << kernelName << '\n'
+              << "Number of threads in parallel mode: " << std::max(std::thread::hardware_concurrency(), 1u) << '\n'
+              << '\n';
+    /*
+     * The test loading a RAW file. Each variant is executed once and its results
+     * compared against the reference. Execution times are measured by the
+     * `NaN-benchmark` executable instead, with warmup and outlier rejection.
+     */
+    if (!verifyResamplingMethods()) {
+        std::cout << "TEST FAILURE in the weights of the interpolation methods.\n";
+        return 1;
+    }
+    if (!isVariantEnabled(FIRST_RESAMPLING_VARIANT)) {
+        std::cout << "Variants of the other interpolation methods skipped: too many expected results to keep in memory.\n\n";
+    }
+    Arena arena;
+    DataCache cache;
+    std::unique_ptr<PerfCounters> counters;
+    if (config.perfCounters) {
+        counters = std::make_unique<PerfCounters>();
+    }
+    TestNodata test(arena, cache, std::endian::big, 0);
+    if (!test.testAndCompare(true, counters.get())) {
+        std::cout << "TEST FAILURE.\n";
+        return 1;
+    }
+    std::cout << "Success (mismatches in the last iterations are normal).\n";
+    return 0;
+}
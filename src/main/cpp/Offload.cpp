@@ -0,0 +1,180 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cstdio>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include <omp.h>
+#include "Offload.hpp"
+
+/*
+ * Creates a new test which will compute the interpolations on the default OpenMP target device.
+ * The raster is in native byte order and in the row-major layout, as expected by the device code.
+ */
+TestNaNOffload::TestNaNOffload(Arena& arena, DataCache& cache)
+        : TestNaN(arena, cache, std::endian::native, 0)
+{
+    std::fill(reasonCounts, reasonCounts + NUM_REASONS, 0);
+    onHost = true;
+}
+
+/*
+ * Reads the raster, performs interpolations on the device and compares against the expected values.
+ * The expected values of all iterations are needed at once, so they must fit in `EXPECTED_RESULTS_CACHE_LIMIT`.
+ * The returned execution time includes the copies between the host and the device.
+ */
+double TestNaNOffload::computeAndCompare() {
+    std::chrono::time_point<std::chrono::high_resolution_clock> startTime, endTime;
+    const float* raster = loadRaster();
+    if (raster) {
+        const double* coordinates = loadCoordinates();
+        const double* expected    = cache.expectedResults(true);
+        if (!expected) {
+            std::cout << "The expected results are too large for being copied to the device.\n";
+        } else if (coordinates) {
+            const int    width         = config.width;
+            const int    height        = config.height;
+            const int    numPoints     = config.numInterpolationPoints;
+            const int    numIterations = config.numVerifiedIterations;
+            const size_t numValues     = layout.length();
+            const size_t numExpected   = (size_t) numIterations * numPoints;
+            double*  stats      = errorStatistics;      // Local variables because OpenMP cannot map class members.
+            int*     mismatches = nodataMismatches;
+            int64_t* counts     = reasonCounts;
+            const int32_t firstQuietNaN = FIRST_QUIET_NAN;
+            int      outOfBounds = 0;
+            int      initial     = 1;
+            startTime = std::chrono::high_resolution_clock::now();
+            #pragma omp target teams distribute parallel for \
+                    map(to: raster[0:numValues], coordinates[0:2*numPoints], expected[0:numExpected]) \
+                    map(tofrom: stats[0:numIterations], mismatches[0:numIterations], counts[0:NUM_REASONS], outOfBounds) \
+                    map(from: initial) \
+                    reduction(max: stats[0:numIterations], outOfBounds) \
+                    reduction(+: mismatches[0:numIterations], counts[0:NUM_REASONS])
+            for (int i=0; i<numPoints; i++) {
+                if (i == 0) {
+                    initial = omp_is_initial_device();
+                }
+                double xy[2] = {coordinates[i << 1], coordinates[(i << 1) | 1]};
+                for (int it=0; it<numIterations; it++) {
+                    const double x = xy[0];
+                    const double y = xy[1];
+                    double xb = std::floor(x);
+                    double yb = std::floor(y);
+                    int offset = width * (int) yb + (int) xb;
+                    if (offset < 0 || offset >= (height - 1) * width + (width - 1)) {
+                        outOfBounds = 1;        // Same check as `RasterLayout::offset(…)`.
+                        break;
+                    }
+                    float v00 = raster[offset];
+                    float v01 = raster[offset + 1];
+                    float v10 = raster[offset + width];
+                    float v11 = raster[offset + width + 1];
+                    double xf = x - xb;
+                    double yf = y - yb;
+                    double v0 = std::fma(v01 - (double) v00, xf, v00);
+                    double v1 = std::fma(v11 - (double) v10, xf, v10);
+                    double result = std::fma(v1 - v0, yf, v0);
+                    double value  = expected[(size_t) it * numPoints + i];
+                    int32_t missingValueReason = std::max(
+                            std::max(floatToRawIntBits(v00), floatToRawIntBits(v01)),
+                            std::max(floatToRawIntBits(v10), floatToRawIntBits(v11)));
+                    #if __FINITE_MATH_ONLY__ && !defined(NAN_FORCE_ISNAN)
+                    const bool missing = (missingValueReason >= firstQuietNaN);     // See `isMissing(double)`.
+                    #else
+                    const bool missing = std::isnan(result);
+                    #endif
+                    int32_t payload = missingValueReason - firstQuietNaN;
+                    if (missing) {
+                        counts[std::clamp(payload, 0, NUM_REASONS - 1)]++;
+                    }
+                    result = verifyResult(missing, payload + MISSING_VALUE_THRESHOLD, result, value, mismatches[it], stats[it]);
+                    movePoint(xy, result, width, height);
+                }
+            }
+            endTime = std::chrono::high_resolution_clock::now();
+            onHost = (initial != 0);
+            if (outOfBounds) {
+                std::cout << "Coordinates out of bounds.\n";
+                exit(1);
+            }
+        }
+    }
+    return duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+/*
+ * Returns whether the last computation has been executed on the host because no device is available.
+ */
+bool TestNaNOffload::executedOnHost() const {
+    return onHost;
+}
+
+/*
+ * Prints the number of missing results for each reason, in all iterations.
+ */
+void TestNaNOffload::printReasonCounts() const {
+    printf("Missing results: UNKNOWN=%lld, CLOUD=%lld, LAND=%lld, NO_PASS=%lld\n",
+           (long long) reasonCounts[0], (long long) reasonCounts[1],
+           (long long) reasonCounts[2], (long long) reasonCounts[3]);
+}
+
+/*
+ * Returns whether the statistics of this test are identical to the statistics of the given test.
+ * This is expected on the host, but the last iterations may differ on a device because
+ * of the different rounding of `std::fmod` or of the conversions between `float` and `double`.
+ */
+bool TestNaNOffload::sameResults(TestCase* other) {
+    return resultEquals(other);
+}
+
+/*
+ * The operations verified by `checkNaNPropagation(…)`, with their operands given by arrays
+ * for preventing the compiler to compute them at compile time. Results of `float` operations
+ * are stored in the low 32 bits.
+ */
+#pragma omp declare target
+static void propagateNaN(const float* operands, uint64_t* results) {
+    float  cloud = operands[0];             // NaN with the CLOUD payload.
+    float  land  = operands[1];             // NaN with the LAND payload.
+    float  value = operands[2];
+    float  xf    = operands[3];
+    results[0] = std::bit_cast<uint32_t>(cloud + value);
+    results[1] = std::bit_cast<uint32_t>(std::fma(cloud, xf, value));
+    results[2] = std::bit_cast<uint64_t>((double) cloud);
+    results[3] = std::bit_cast<uint64_t>(std::fma(value - (double) land, (double) xf, (double) land));
+    results[4] = std::bit_cast<uint32_t>(cloud + land);
+    results[5] = std::bit_cast<uint32_t>(land * cloud);
+}
+#pragma omp end declare target
+
+/*
+ * Computes a few operations on NaN operands on the host and on the default OpenMP target device,
+ * for verifying whether the payloads survive the arithmetic units of the device (in particular the FMA units).
+ * The array shall have a length of `NUM_NAN_PROPAGATION_CHECKS`. The last two operations have two NaN operands
+ * with different payloads: IEEE 754 does not specify which one is propagated, and the compiler may swap the operands
+ * of commutative operations, so the result may differ between two calls even when both are executed on the host.
+ */
+void checkNaNPropagation(NaNPropagation* checks) {
+    const float operands[4] = {
+        std::bit_cast<float>(0x7FC00001), std::bit_cast<float>(0x7FC00002), 2.5f, 0.25f
+    };
+    uint64_t host[NUM_NAN_PROPAGATION_CHECKS], device[NUM_NAN_PROPAGATION_CHECKS];
+    propagateNaN(operands, host);
+    #pragma omp target map(to: operands[0:4]) map(from: device[0:NUM_NAN_PROPAGATION_CHECKS])
+    propagateNaN(operands, device);
+    const char* names[NUM_NAN_PROPAGATION_CHECKS] = {
+        "NaN(CLOUD) + 2.5",
+        "fma(NaN(CLOUD), 0.25, 2.5)",
+        "(double) NaN(CLOUD)",
+        "fma(2.5 - (double) NaN(LAND), 0.25, NaN(LAND))",
+        "NaN(CLOUD) + NaN(LAND)",
+        "NaN(LAND) * NaN(CLOUD)"
+    };
+    for (int i=0; i<NUM_NAN_PROPAGATION_CHECKS; i++) {
+        checks[i] = {names[i], host[i], device[i]};
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#ifndef OFFLOAD_HPP
+#define OFFLOAD_HPP
+
+#include <cstdint>
+#include "TestCase.hpp"
+
+/*
+ * Number of missing value reasons counted by `TestNaNOffload`: UNKNOWN, CLOUD, LAND and NO_PASS.
+ */
+#define NUM_REASONS 4
+
+/*
+ * Same calculation as `TestNaN` but with the points distributed over the teams of an OpenMP target device,
+ * which is a GPU if the compiler has been configured for offloading (e.g. GCC with `-foffload=nvptx-none`),
+ * or the host otherwise. Each point executes the chain of all iterations on the device, because that chain
+ * does not depend on other points. The raster, the coordinates and the expected results are copied to the
+ * device once, and only the statistics and the number of results for each missing value reason are copied
+ * back. The coordinates modified by the iterations stay on the device.
+ *
+ * The reasons are determined from the four raster values as in `TestNaN`, not from the payload of the result,
+ * because some devices replace the NaN produced by arithmetic operations by a canonical NaN.
+ * See `checkNaNPropagation(…)` for verifying the behavior of a device.
+ */
+class TestNaNOffload : public TestNaN {
+    /*
+     * Number of missing results for each reason, in all iterations.
+     */
+    int64_t reasonCounts[NUM_REASONS];
+
+    /*
+     * Whether the computation has been executed on the host because no device is available.
+     */
+    bool onHost;
+
+    public:
+        TestNaNOffload(Arena& arena, DataCache& cache);
+        double computeAndCompare();
+        bool   executedOnHost() const;
+        void   printReasonCounts() const;
+        bool   sameResults(TestCase*);
+};
+
+/*
+ * Result of an arithmetic operation on NaN operands, on the host and on the device.
+ */
+struct NaNPropagation {
+    const char* operation;
+    uint64_t    host;
+    uint64_t    device;
+};
+
+/*
+ * Number of operations tested by `checkNaNPropagation(…)`.
+ */
+#define NUM_NAN_PROPAGATION_CHECKS 6
+
+void checkNaNPropagation(NaNPropagation* checks);
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cstdio>
+#include <iostream>
+#include <omp.h>
+#include "Offload.hpp"
+
+/*
+ * Verifies the propagation of NaN payloads on the OpenMP target device, then runs the test on the device
+ * and compares the statistics with the same test executed on the host. See `Configuration::parse(…)`
+ * for the command-line options.
+ */
+int main(int argc, char** argv) {
+    if (!config.parse(argc, argv)) {
+        return 1;
+    }
+    std::cout << "Number of OpenMP target devices: " << omp_get_num_devices() << "\n\n";
+    NaNPropagation checks[NUM_NAN_PROPAGATION_CHECKS];
+    checkNaNPropagation(checks);
+    printf("%-48s %18s %18s\n", "Operation", "Host", "Device");
+    for (const NaNPropagation& check : checks) {
+        printf("%-48s %18llx %18llx%s\n", check.operation, (unsigned long long) check.host,
+               (unsigned long long) check.device, (check.host == check.device) ? "" : "  (differ)");
+    }
+    std::cout << '\n';
+
+    Arena arena;
+    DataCache cache;
+    TestNaN reference(arena, cache, std::endian::native, 0);
+    TestNaNOffload test(arena, cache);
+    double hostTime   = reference.computeAndCompare();
+    double deviceTime = test.computeAndCompare();
+    if (hostTime <= 0 || deviceTime <= 0) {
+        std::cout << "TEST FAILURE (are the data files present and matching the options?)\n";
+        return 1;
+    }
+    test.printStatistics();
+    test.printReasonCounts();
+    printf("Executed on: %s, time: %.3f ms (including copies), host time: %.3f ms\n",
+           test.executedOnHost() ? "host (no device available)" : "device", deviceTime / 1E6, hostTime / 1E6);
+    std::cout << "Same statistics as on the host: " << (test.sameResults(&reference) ? "yes" : "no") << '\n';
+    if (!test.success()) {
+        std::cout << "TEST FAILURE.\n";
+        return 1;
+    }
+    std::cout << "Success (mismatches in the last iterations are normal).\n";
+    return 0;
+}
@@ -0,0 +1,311 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cstdio>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include "PagedRaster.hpp"
+#include "ByteOrder.hpp"
+#ifdef USE_PREAD
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Opens the given RAW file of `config.width` × `config.height` values, with a cache of `capacity` tiles
+ * of `tileSize` pixels. No tile is read before the first request. The `tileSize` shall be a power of 2.
+ */
+PagedRaster::PagedRaster(const std::filesystem::path& path, std::endian fileByteOrder, int tileSize, int cacheCapacity)
+        : layout(config.width, config.height, std::max(tileSize, 2))
+{
+    #ifdef USE_PREAD
+    descriptor = open(path.c_str(), O_RDONLY);
+    #else
+    file.open(path, std::ios::binary);
+    #endif
+    byteOrder  = fileByteOrder;
+    capacity   = std::max(cacheCapacity, 1);
+    slots.resize((size_t) capacity * layout.rowStride * layout.rowStride);
+    slotOfTile.assign(numTiles(), -1);
+    tileOfSlot.assign(capacity, -1);
+    previous.resize(capacity);
+    next.resize(capacity);
+    for (int slot=0; slot<capacity; slot++) {
+        previous[slot] = slot - 1;
+        next[slot]     = (slot + 1 < capacity) ? slot + 1 : -1;
+    }
+    head       = 0;
+    tail       = capacity - 1;
+    lastTile   = -1;
+    lastValues = NULL;
+    hits       = 0;
+    misses     = 0;
+    evictions  = 0;
+}
+
+/*
+ * Closes the file.
+ */
+PagedRaster::~PagedRaster() {
+    #ifdef USE_PREAD
+    if (descriptor >= 0) {
+        close(descriptor);
+    }
+    #endif
+}
+
+/*
+ * Returns whether the file has been opened.
+ */
+bool PagedRaster::isOpen() const {
+    #ifdef USE_PREAD
+    return descriptor >= 0;
+    #else
+    return file.is_open();
+    #endif
+}
+
+/*
+ * Returns the number of tiles in the raster.
+ */
+int PagedRaster::numTiles() const {
+    return (int) (layout.length() / ((size_t) layout.rowStride * layout.rowStride));
+}
+
+/*
+ * Reads the given tile from the file, with the bytes swapped to the native byte order. Pixels on the right
+ * and bottom of the tiles at the raster edges are duplicated from the last column and row, as in the copies
+ * made by `DataCache`. Values are copied as integers for making clear that no FPU is involved.
+ * Returns false if an error occurred while reading the file.
+ */
+bool PagedRaster::load(int tile, float* target) {
+    const int rowStride = layout.rowStride;
+    const int x0 = (tile % layout.tilesPerRow) << layout.tileShift;
+    const int y0 = (tile / layout.tilesPerRow) << layout.tileShift;
+    const int n  = std::min(rowStride, layout.width - x0);
+    for (int dy=0; dy<rowStride; dy++) {
+        int y = std::min(y0 + dy, layout.height - 1);
+        int32_t* row = reinterpret_cast<int32_t*>(target + dy * rowStride);
+        const size_t numBytes = n * sizeof(float);
+        #ifdef USE_PREAD
+        if (pread(descriptor, row, numBytes, ((off_t) y * layout.width + x0) * sizeof(float)) != (ssize_t) numBytes) {
+            return false;
+        }
+        #else
+        file.seekg(((std::streamoff) y * layout.width + x0) * sizeof(float));
+        if (!file.read(reinterpret_cast<char*>(row), numBytes)) {
+            file.clear();
+            return false;
+        }
+        #endif
+        if (byteOrder != std::endian::native) {
+            swapBytes(row, row, numBytes, sizeof(float));
+        }
+        std::fill(row + n, row + rowStride, row[n - 1]);
+    }
+    return true;
+}
+
+/*
+ * Moves the given slot at the beginning of the list of recently used slots.
+ */
+void PagedRaster::moveToFront(int slot) {
+    if (slot == head) {
+        return;
+    }
+    int before = previous[slot];
+    int after  = next[slot];
+    next[before] = after;
+    if (after >= 0) previous[after] = before;
+    else tail = before;
+    previous[slot] = -1;
+    next[slot]     = head;
+    previous[head] = slot;
+    head = slot;
+}
+
+/*
+ * Returns the values of the given tile, reading it from the file if it is not in the cache.
+ * The array has `layout.rowStride` × `layout.rowStride` values, and is valid until the next call
+ * to this method with a different tile. Returns NULL if the tile cannot be read.
+ */
+const float* PagedRaster::tile(int tile) {
+    if (tile == lastTile) {
+        hits++;
+        return lastValues;
+    }
+    int slot = slotOfTile[tile];
+    float* values;
+    if (slot >= 0) {
+        hits++;
+        values = &slots[(size_t) slot * layout.rowStride * layout.rowStride];
+    } else {
+        misses++;
+        slot = tail;                    // The least recently used slot, or a free slot.
+        int evicted = tileOfSlot[slot];
+        if (evicted >= 0) {
+            slotOfTile[evicted] = -1;
+            evictions++;
+        }
+        values = &slots[(size_t) slot * layout.rowStride * layout.rowStride];
+        if (!load(tile, values)) {
+            tileOfSlot[slot] = -1;
+            lastTile = -1;
+            return NULL;
+        }
+        tileOfSlot[slot] = tile;
+        slotOfTile[tile] = slot;
+    }
+    moveToFront(slot);
+    lastTile   = tile;
+    lastValues = values;
+    return values;
+}
+
+/*
+ * Prints the number of cache hits, misses and evictions, and the hit rate.
+ */
+void PagedRaster::printStatistics() const {
+    uint64_t requests = hits + misses;
+    printf("Tile cache: %d of %d tiles, %llu hits, %llu misses, %llu evictions, hit rate %.2f%%\n",
+           capacity, numTiles(), (unsigned long long) hits, (unsigned long long) misses,
+           (unsigned long long) evictions, requests ? 100.0 * hits / requests : 0.0);
+}
+
+/*
+ * Creates a new test which will read the raster in the given byte order by tiles of `config.tileSize` pixels.
+ */
+TestNaNPaged::TestNaNPaged(Arena& arena, DataCache& cache, std::endian testByteOrder, bool sortPointsByTile)
+        : TestNaN(arena, cache, testByteOrder, 0)
+{
+    fileByteOrder = testByteOrder;
+    sortByTile    = sortPointsByTile;
+}
+
+/*
+ * Stores in `order` the indices of all points sorted by the tile containing the pixels used by their interpolation.
+ * This is a counting sort, where `counts` is a work array of `raster->numTiles() + 1` elements. Points out of bounds
+ * are put with the first tile, and will be reported by the interpolation loop.
+ */
+void TestNaNPaged::sortPoints(const double* coordinates, int* order, int* counts) const {
+    const RasterLayout& layout = raster->layout;
+    const int numPoints = config.numInterpolationPoints;
+    const int numTiles  = raster->numTiles();
+    std::fill(counts, counts + numTiles + 1, 0);
+    auto tileOf = [&](int i) {
+        int x = (int) coordinates[i << 1];
+        int y = (int) coordinates[(i << 1) | 1];
+        int tile = (y >> layout.tileShift) * layout.tilesPerRow + (x >> layout.tileShift);
+        return (tile >= 0 && tile < numTiles) ? tile : 0;
+    };
+    for (int i=0; i<numPoints; i++) {
+        counts[tileOf(i) + 1]++;
+    }
+    for (int t=0; t<numTiles; t++) {
+        counts[t + 1] += counts[t];
+    }
+    for (int i=0; i<numPoints; i++) {
+        order[counts[tileOf(i)]++] = i;
+    }
+}
+
+/*
+ * Performs interpolations with the raster read by tiles, and compares against the expected values.
+ * The time spent in reading the tiles is included in the returned execution time.
+ */
+double TestNaNPaged::computeAndCompare() {
+    std::chrono::time_point<std::chrono::high_resolution_clock> startTime, endTime;
+    raster = std::make_unique<PagedRaster>(cache.file(true, (fileByteOrder == std::endian::little) ? "little-endian.raw" : "big-endian.raw"),
+                                           fileByteOrder, config.tileSize, config.cacheTiles);
+    if (raster->isOpen()) {
+        double* coordinates = loadCoordinates();
+        if (coordinates) {
+            ExpectedResults expectedResults;
+            if (openExpectedResults(expectedResults, 0, config.numInterpolationPoints)) {
+                const RasterLayout& layout = raster->layout;
+                const int width     = config.width;
+                const int height    = config.height;
+                const int numPoints = config.numInterpolationPoints;
+                const int mask      = (1 << layout.tileShift) - 1;
+                const int rowStride = layout.rowStride;
+                int* order  = arena.allocate<int>(numPoints);
+                int* counts = arena.allocate<int>(raster->numTiles() + 1);
+                for (int i=0; i<numPoints; i++) {
+                    order[i] = i;
+                }
+                uint64_t total[NUM_PERF_COUNTERS], snapshot[NUM_PERF_COUNTERS];
+                startTime = std::chrono::high_resolution_clock::now();
+                startCounters(total);
+                for (int it=0; it<config.numVerifiedIterations; it++) {
+                    startCounters(snapshot);
+                    const double* expectedResultCursor = expectedResults.next();
+                    if (!expectedResultCursor) {
+                        std::cout << "Cannot read the expected results of iteration " << it << ".\n";
+                        exit(1);
+                    }
+                    if (sortByTile) {
+                        sortPoints(coordinates, order, counts);
+                    }
+                    double stats = errorStatistics[it];
+                    for (int k=0; k<numPoints; k++) {
+                        int i  = order[k];
+                        int ix = i << 1;
+                        int iy = ix | 1;
+                        double x  = coordinates[ix];
+                        double y  = coordinates[iy];
+                        double xb = std::floor(x);
+                        double yb = std::floor(y);
+                        int px = (int) xb;
+                        int py = (int) yb;
+                        if ((unsigned) px >= (unsigned) (width - 1) || (unsigned) py >= (unsigned) (height - 1)) {
+                            printf("Coordinates out of bounds: (%g, %g) for point %d.\n", xb, yb, i);
+                            exit(1);
+                        }
+                        const float* tile = raster->tile((py >> layout.tileShift) * layout.tilesPerRow + (px >> layout.tileShift));
+                        if (!tile) {
+                            std::cout << "Cannot read a tile of the raster.\n";
+                            exit(1);
+                        }
+                        int offset = (py & mask) * rowStride + (px & mask);
+                        float v00 = tile[offset];
+                        float v01 = tile[offset + 1];
+                        float v10 = tile[offset += rowStride];
+                        float v11 = tile[offset + 1];
+                        double xf = x - xb;
+                        double yf = y - yb;
+                        double v0 = std::fma(v01 - (double) v00, xf, v00);
+                        double v1 = std::fma(v11 - (double) v10, xf, v10);
+                        double result = std::fma(v1 - v0, yf, v0);
+                        const bool missing = isMissing(result);
+                        double nodata = 0;
+                        if (missing) {
+                            int32_t missingValueReason = std::max(
+                                    std::max(floatToRawIntBits(v00), floatToRawIntBits(v01)),
+                                    std::max(floatToRawIntBits(v10), floatToRawIntBits(v11)));
+                            nodata = (missingValueReason - FIRST_QUIET_NAN) + MISSING_VALUE_THRESHOLD;
+                        }
+                        result = verifyResult(missing, nodata, result, expectedResultCursor[i], nodataMismatches[it], stats);
+                        movePoint(coordinates + ix, result, width, height);
+                    }
+                    errorStatistics[it] = stats;
+                    stopCounters(snapshot, it);
+                }
+                stopCounters(total, config.numVerifiedIterations);
+                endTime = std::chrono::high_resolution_clock::now();
+            }
+        }
+    }
+    return duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+/*
+ * Prints the statistics of the tile cache of the last execution.
+ */
+void TestNaNPaged::printDetails() const {
+    if (raster) {
+        raster->printStatistics();
+    }
+}
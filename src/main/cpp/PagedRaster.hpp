@@ -0,0 +1,123 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#ifndef PAGED_RASTER_HPP
+#define PAGED_RASTER_HPP
+
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include "TestCase.hpp"
+#if defined(__unix__) || defined(__APPLE__)
+#define USE_PREAD
+#endif
+
+/*
+ * A raster read from a RAW file one tile at a time, with a cache of a fixed number of tiles.
+ * The tiles have the layout described in `RasterLayout`, including the duplicated column and row
+ * of the neighbor tiles, so the four pixels of a bilinear interpolation are always in the same tile.
+ * A tile is read from the file when first requested, and the least recently used tile is evicted
+ * when the cache is full. Consequently, the memory used by this raster is independent of the raster size.
+ *
+ * The efficiency depends on the order of the requests: points sorted by tiles (see `TestNaNSIMD` binning)
+ * read each tile at most once per iteration, while random points cause an eviction on most requests
+ * if the cache is much smaller than the raster.
+ *
+ * This class is not thread-safe.
+ */
+class PagedRaster {
+    /*
+     * The file from which to read the tiles, and the byte order of the values in that file.
+     * On platforms supporting `pread`, the file descriptor is used instead of a stream,
+     * for reading each row of a tile with a single system call without seek and buffering.
+     */
+    #ifdef USE_PREAD
+    int descriptor;
+    #else
+    std::ifstream file;
+    #endif
+    std::endian byteOrder;
+
+    /*
+     * The cached tiles, as `capacity` slots of `rowStride` × `rowStride` values.
+     * `slotOfTile[tile]` is the slot of a tile, or -1 if the tile is not in the cache.
+     * `tileOfSlot[slot]` is the tile in a slot, or -1 if the slot is free.
+     */
+    int capacity;
+    std::vector<float> slots;
+    std::vector<int> slotOfTile;
+    std::vector<int> tileOfSlot;
+
+    /*
+     * Doubly-linked list of slots from the most recently used (`head`) to the least recently used (`tail`).
+     */
+    std::vector<int> previous, next;
+    int head, tail;
+
+    /*
+     * The tile returned by the last call to `tile(…)`, for skipping the update of the list
+     * when consecutive requests are for the same tile.
+     */
+    int lastTile;
+    const float* lastValues;
+
+    bool load(int tile, float* target);
+    void moveToFront(int slot);
+
+    public:
+        /*
+         * Mapping from pixel coordinates to tiles, with `tileShift` never 0.
+         */
+        const RasterLayout layout;
+
+        /*
+         * Number of requests for a tile which was in the cache, requests for a tile which had to be read,
+         * and tiles removed from the cache for making room for another tile.
+         */
+        uint64_t hits, misses, evictions;
+
+        PagedRaster(const std::filesystem::path& file, std::endian byteOrder, int tileSize, int capacity);
+        ~PagedRaster();
+        PagedRaster(const PagedRaster&) = delete;
+        PagedRaster& operator=(const PagedRaster&) = delete;
+        bool isOpen() const;
+        const float* tile(int tile);
+        int  numTiles() const;
+        void printStatistics() const;
+};
+
+/*
+ * Same calculation as `TestNaN` but with the raster read from the file by tiles when first needed,
+ * using a cache of `config.cacheTiles` tiles. Optionally, the points are sorted by tile before each
+ * iteration, which reduces the number of tiles read. Sorting does not change the results, because
+ * the chain of iterations of a point does not depend on other points.
+ */
+class TestNaNPaged : public TestNaN {
+    /*
+     * The byte order of the file to read.
+     */
+    std::endian fileByteOrder;
+
+    /*
+     * Whether to process the points in the order of the tiles that they use.
+     */
+    bool sortByTile;
+
+    /*
+     * The raster of the last execution, kept for printing the statistics of the cache.
+     */
+    std::unique_ptr<PagedRaster> raster;
+
+    void sortPoints(const double*, int*, int*) const;
+
+    public:
+        TestNaNPaged(Arena& arena, DataCache& cache, std::endian testByteOrder, bool sortByTile);
+        double computeAndCompare();
+        void   printDetails() const;
+};
+
+#endif
@@ -0,0 +1,99 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cstring>
+#include "PerfCounters.hpp"
+#ifdef __linux__
+#define USE_PERF_EVENT
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+/*
+ * Names of the counted events, in the same order as the values.
+ */
+const char* PERF_COUNTER_NAMES[NUM_PERF_COUNTERS] = {
+    "Cycles", "Instructions", "Branch-misses", "L1D-misses", "LLC-misses"
+};
+
+/*
+ * Opens the counters of all events. The events that cannot be counted are silently ignored.
+ */
+PerfCounters::PerfCounters() {
+    #ifdef USE_PERF_EVENT
+    const uint32_t types[NUM_PERF_COUNTERS] = {
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE
+    };
+    const uint64_t configs[NUM_PERF_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_BRANCH_MISSES,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_CACHE_LL  | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+    };
+    for (int i=0; i<NUM_PERF_COUNTERS; i++) {
+        perf_event_attr attributes;
+        memset(&attributes, 0, sizeof(attributes));
+        attributes.size           = sizeof(attributes);
+        attributes.type           = types[i];
+        attributes.config         = configs[i];
+        attributes.exclude_kernel = 1;      // Allowed for unprivileged users by the default kernel settings.
+        attributes.exclude_hv     = 1;
+        attributes.inherit        = 1;      // Include the worker threads of the parallel variant.
+        fds[i] = (int) syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+    }
+    #else
+    for (int i=0; i<NUM_PERF_COUNTERS; i++) {
+        fds[i] = -1;
+    }
+    #endif
+}
+
+/*
+ * Closes all counters.
+ */
+PerfCounters::~PerfCounters() {
+    #ifdef USE_PERF_EVENT
+    for (int i=0; i<NUM_PERF_COUNTERS; i++) {
+        if (fds[i] >= 0) {
+            close(fds[i]);
+        }
+    }
+    #endif
+}
+
+/*
+ * Returns whether the event at the given index can be counted.
+ */
+bool PerfCounters::available(int counter) const {
+    return fds[counter] >= 0;
+}
+
+/*
+ * Stores the current values of all counters in the given array, which shall have a length of `NUM_PERF_COUNTERS`.
+ * The values of the events that are not available are set to 0.
+ */
+void PerfCounters::read(uint64_t* values) const {
+    for (int i=0; i<NUM_PERF_COUNTERS; i++) {
+        values[i] = 0;
+        #ifdef USE_PERF_EVENT
+        if (fds[i] >= 0 && ::read(fds[i], &values[i], sizeof(uint64_t)) != sizeof(uint64_t)) {
+            values[i] = 0;
+        }
+        #endif
+    }
+}
+
+/*
+ * Adds to `totals` the differences between the current values of all counters and the given snapshot.
+ * The `snapshot` array shall have been filled by `read(…)`, and both arrays have a length of `NUM_PERF_COUNTERS`.
+ */
+void PerfCounters::accumulate(const uint64_t* snapshot, uint64_t* totals) const {
+    uint64_t values[NUM_PERF_COUNTERS];
+    read(values);
+    for (int i=0; i<NUM_PERF_COUNTERS; i++) {
+        totals[i] += values[i] - snapshot[i];
+    }
+}
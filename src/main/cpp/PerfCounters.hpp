@@ -0,0 +1,44 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+#include <cstdint>
+
+/*
+ * Number of hardware events counted by `PerfCounters`, and their names in the order of the arrays of values.
+ */
+#define NUM_PERF_COUNTERS 5
+extern const char* PERF_COUNTER_NAMES[NUM_PERF_COUNTERS];
+
+/*
+ * Hardware performance counters of the calling thread and of the threads that it creates after this object.
+ * The counted events are the processor cycles, the instructions, the branch mispredictions, the L1 data cache
+ * read misses and the last level cache read misses, in user space only. On Linux, the counters are read with
+ * `perf_event_open`. An event may be unavailable, for example in a virtual machine or if the kernel setting
+ * `perf_event_paranoid` forbids it. In such case, the value of that event is always 0. On other platforms,
+ * no event is available.
+ *
+ * The counters are always running: measurements are done by taking a snapshot before the code to measure,
+ * then adding the difference with the values after the code. The counts of the threads created by the calling
+ * thread are included only after those threads have terminated.
+ */
+class PerfCounters {
+    /*
+     * File descriptors of the counters, or -1 for the events that are not available.
+     */
+    int fds[NUM_PERF_COUNTERS];
+
+    public:
+        PerfCounters();
+        ~PerfCounters();
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+        bool available(int) const;
+        void read(uint64_t*) const;
+        void accumulate(const uint64_t*, uint64_t*) const;
+};
+
+#endif
@@ -0,0 +1,225 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include "TestCase.hpp"
+#include "ByteOrder.hpp"
+#include "AsyncReader.hpp"
+
+/*
+ * Options of the pipeline, in addition to the options of the tests described in `Configuration`.
+ */
+struct PipelineOptions {
+    /*
+     * Directory of the rasters to process. All files with the ".raw" extension and a size
+     * of `config.width` × `config.height` `float` values are processed in alphabetical order.
+     */
+    std::filesystem::path rasterDirectory;
+
+    /*
+     * Number of raster buffers, which is also the maximal number of rasters loaded in advance.
+     * A depth of 1 disables the overlapping: each raster is read after the previous one has been processed.
+     */
+    int depth = 2;
+
+    bool parse(int&, char**);
+};
+
+/*
+ * Parses the pipeline options and removes them from the command line, leaving the other options for
+ * `Configuration::parse(…)`. Recognized options are `--rasters=…` (default to the directory of NaN data)
+ * and `--depth=…`. Returns `false` if an option has an invalid value.
+ */
+bool PipelineOptions::parse(int& argc, char** argv) {
+    int remaining = 1;
+    for (int i=1; i<argc; i++) {
+        const char* arg = argv[i];
+        const char* value = strchr(arg, '=');
+        if (value) {
+            std::string name(arg, value++ - arg);
+            if (name == "--rasters") {
+                rasterDirectory = value;
+                continue;
+            }
+            if (name == "--depth") {
+                char* end;
+                long n = strtol(value, &end, 10);
+                if (*end != 0 || n < 1 || n > 64) {
+                    std::cout << "Invalid option: " << arg << '\n'
+                              << "Pipeline options: [--rasters=directory] [--depth=2]\n";
+                    return false;
+                }
+                depth = (int) n;
+                continue;
+            }
+        }
+        argv[remaining++] = argv[i];
+    }
+    argc = remaining;
+    return true;
+}
+
+/*
+ * Returns the rasters to process, sorted by file name. Files of other sizes
+ * (e.g. the coordinates and the expected results) are ignored.
+ */
+static std::vector<std::filesystem::path> listRasters(const std::filesystem::path& directory, size_t numBytes) {
+    std::vector<std::filesystem::path> files;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.path().extension() == ".raw" && entry.is_regular_file(error) && entry.file_size(error) == numBytes) {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+/*
+ * Statistics of the processing of one raster. Times are in nanoseconds.
+ */
+struct RasterStatistics {
+    double waitTime;            // Time spent waiting for the raster to be loaded.
+    double computeTime;         // Time spent in interpolations and verifications.
+    double maxError;            // Maximal difference with the expected values, in the strict iterations.
+    int    mismatches;          // Number of "missing value" mismatches, in the strict iterations.
+    int    missing;             // Number of NaN results in all iterations.
+};
+
+/*
+ * Performs the interpolations of all iterations on the given raster, with the same chaotic displacement
+ * of points as the tests. The coordinates are modified in place. If `expected` is non-null, the results
+ * are compared with the expected values of the first `config.numStrictIterations` iterations, which are
+ * the iterations where the tests do not tolerate the drift (see `TestCase::success()`).
+ */
+static void interpolateAll(const Raster& raster, double* coordinates, const double* expected, RasterStatistics& stats) {
+    double  results[SIMD_BATCH_SIZE];
+    int32_t reasons[SIMD_BATCH_SIZE];
+    const int numPoints = config.numInterpolationPoints;
+    const int width     = config.width;
+    const int height    = config.height;
+    for (int it=0; it<config.numVerifiedIterations; it++) {
+        const bool verify = (expected != NULL && it < config.numStrictIterations);
+        for (int start=0; start < numPoints; start += SIMD_BATCH_SIZE) {
+            int count = std::min(SIMD_BATCH_SIZE, numPoints - start);
+            double* batch = coordinates + 2*start;
+            if (interpolate(raster, std::span<const double>(batch, 2*count), std::span(results, count), std::span(reasons, count)) != count) {
+                std::cout << "Coordinates out of bounds in iteration " << it << ".\n";
+                exit(1);
+            }
+            for (int i=0; i<count; i++) {
+                const bool missing = isMissing(results[i]);
+                double result = missing ? 1.0 : results[i];        // 1 for moving to another position.
+                stats.missing += missing;
+                if (verify) {
+                    double nodata = reasons[i] - ElementType<float>::FIRST_QUIET_NAN + MISSING_VALUE_THRESHOLD;
+                    result = verifyResult(missing, nodata, results[i], expected[(size_t) it * numPoints + start + i],
+                                          stats.mismatches, stats.maxError);
+                }
+                movePoint(batch + 2*i, result, width, height);
+            }
+        }
+    }
+}
+
+/*
+ * Processes all rasters of a directory with the loading of the next rasters overlapped with the computation
+ * on the current raster. The raster buffers are allocated once, and each buffer is given to the reader again
+ * as soon as the computation on its raster is finished. The files having "big-endian" in their name have
+ * their bytes swapped after loading. Every raster is processed with the same points as the tests, and the
+ * results are compared with the expected values of the NaN data, and the exit code is non-zero if a "missing value"
+ * mismatch is found in the strict iterations. Consequently, the rasters shall be the generated rasters with NaN
+ * values: rasters with "no data" sentinel values or other rasters are reported as failures.
+ */
+int main(int argc, char** argv) {
+    PipelineOptions options;
+    if (!options.parse(argc, argv) || !config.parse(argc, argv)) {
+        return 1;
+    }
+    if (options.rasterDirectory.empty()) {
+        options.rasterDirectory = config.dataDirectory / "nan";
+    }
+    const size_t numValues = (size_t) config.width * config.height;
+    const size_t numBytes  = numValues * sizeof(float);
+    std::vector<std::filesystem::path> files = listRasters(options.rasterDirectory, numBytes);
+    if (files.empty()) {
+        std::cout << "No raster of " << config.width << " × " << config.height << " pixels in "
+                  << options.rasterDirectory << ".\n";
+        return 1;
+    }
+    Arena arena;
+    DataCache cache;
+    const double* original = cache.coordinates(true);
+    if (!original) {
+        std::cout << "Cannot read the coordinates in " << config.dataDirectory << ".\n";
+        return 1;
+    }
+    const double* expected = cache.expectedResults(true);
+    double* coordinates = arena.allocate<double>(2 * (size_t) config.numInterpolationPoints);
+    std::vector<float*> buffers(options.depth);
+    for (float*& buffer : buffers) {
+        buffer = arena.allocate<float>(numValues);
+    }
+    /*
+     * Start to load the first rasters before any computation. Then, each iteration of the loop
+     * waits for a raster, processes it, and reuses its buffer for the raster `depth` positions later.
+     */
+    AsyncReader reader(options.depth);
+    std::cout << "Reader: " << reader.backend() << ", depth: " << options.depth << ", rasters: " << files.size() << "\n\n";
+    printf("%-40s %10s %12s %11s %10s %10s\n", "Raster", "Wait (ms)", "Compute (ms)", "Max error", "Mismatches", "Missing");
+    auto startTime = std::chrono::high_resolution_clock::now();
+    for (size_t i=0; i < files.size() && i < buffers.size(); i++) {
+        reader.start((int) i, files[i], reinterpret_cast<char*>(buffers[i]), numBytes);
+    }
+    RasterStatistics total = {};
+    for (size_t i=0; i < files.size(); i++) {
+        const int slot = (int) (i % buffers.size());
+        RasterStatistics stats = {};
+        auto t0 = std::chrono::high_resolution_clock::now();
+        if (!reader.wait(slot)) {
+            std::cout << "Cannot read " << files[i] << ".\n";
+            return 1;
+        }
+        auto t1 = std::chrono::high_resolution_clock::now();
+        if (files[i].filename().string().find("big-endian") != std::string::npos) {
+            swapBytes(buffers[slot], buffers[slot], numBytes, sizeof(float));
+        }
+        std::copy(original, original + 2 * (size_t) config.numInterpolationPoints, coordinates);
+        interpolateAll(Raster(buffers[slot], config.width, config.height), coordinates, expected, stats);
+        if (i + buffers.size() < files.size()) {
+            reader.start(slot, files[i + buffers.size()], reinterpret_cast<char*>(buffers[slot]), numBytes);
+        }
+        auto t2 = std::chrono::high_resolution_clock::now();
+        stats.waitTime    = duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+        stats.computeTime = duration_cast<std::chrono::nanoseconds>(t2 - t1).count();
+        printf("%-40s %10.3f %12.3f %11.4f %10d %10d\n", files[i].filename().c_str(), stats.waitTime / 1E6,
+               stats.computeTime / 1E6, stats.maxError, stats.mismatches, stats.missing);
+        total.waitTime    += stats.waitTime;
+        total.computeTime += stats.computeTime;
+        total.maxError     = std::max(total.maxError, stats.maxError);
+        total.mismatches  += stats.mismatches;
+        total.missing     += stats.missing;
+    }
+    double elapsed = duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - startTime).count();
+    printf("%-40s %10.3f %12.3f %11.4f %10d %10d\n", "Total", total.waitTime / 1E6,
+           total.computeTime / 1E6, total.maxError, total.mismatches, total.missing);
+    printf("\nElapsed time: %.3f ms (%.1f%% of the time waiting for data)\n", elapsed / 1E6, 100 * total.waitTime / elapsed);
+    if (!expected) {
+        std::cout << "The expected results are too large for being cached. The results have not been verified.\n";
+    } else if (total.mismatches != 0) {
+        std::cout << "TEST FAILURE: \"missing value\" mismatches in the first " << config.numStrictIterations
+                  << " iterations (are the rasters the generated rasters with NaN values?)\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,314 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cstdint>
+#include <cmath>
+#include <bit>
+#include <span>
+#include <limits>
+#include <numbers>
+#include <algorithm>
+#include <stdexcept>
+#include "Resampling.hpp"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/*
+ * Names of the interpolation methods, in the order of the `InterpolationMethod` values.
+ */
+const char* INTERPOLATION_METHOD_NAMES[NUM_INTERPOLATION_METHODS] = {
+    "nearest", "bicubic", "lanczos"
+};
+
+/*
+ * Largest offset (exclusive) of the pixel at floor(x), floor(y). This is the same bound check as in
+ * `Interpolation.cpp`, so that all methods accept the same points.
+ */
+#define OFFSET_LIMIT ((height - 1) * width + (width - 1))
+
+/*
+ * Weights of the cubic convolution with a = -½ (Catmull-Rom spline), evaluated by Horner's method.
+ * All additions are explicit fused multiply-add operations, which the compiler cannot reassociate.
+ */
+__attribute__((noinline))
+void bicubicWeights(double t, double* weights) {
+    weights[0] = t * std::fma(t, std::fma(-0.5, t,  1.0), -0.5);
+    weights[1] = std::fma(std::fma(1.5, t, -2.5), t * t, 1.0);
+    weights[2] = t * std::fma(t, std::fma(-1.5, t,  2.0),  0.5);
+    weights[3] = std::fma(0.5, t, -0.5) * (t * t);
+}
+
+/*
+ * Weights of the Lanczos filter with a = 2, which is sinc(d) × sinc(d/2) for a distance d to the pixel.
+ * The sines at the distances 1+t, t, 1-t and 2-t are all ± sin(πt), sin(πt/2) or cos(πt/2), so only three
+ * trigonometric functions are evaluated. The common factor 2/π² is omitted because the weights are divided
+ * by their sum, as the Lanczos weights do not sum to 1. The point is exactly on a pixel if `t` is zero.
+ */
+__attribute__((noinline))
+void lanczosWeights(double t, double* weights) {
+    if (t == 0) {
+        weights[0] = 0;
+        weights[1] = 1;
+        weights[2] = 0;
+        weights[3] = 0;
+        return;
+    }
+    const double s = std::sin(std::numbers::pi * t);
+    const double h = std::sin(std::numbers::pi * t / 2);
+    const double c = std::cos(std::numbers::pi * t / 2);
+    const double w0 = -s * c / ((1 + t) * (1 + t));
+    const double w1 = (s / t) * (h / t);
+    const double w2 =  s * c / ((1 - t) * (1 - t));
+    const double w3 = -s * h / ((2 - t) * (2 - t));
+    const double sum = (w0 + w1) + (w2 + w3);
+    weights[0] = w0 / sum;
+    weights[1] = w1 / sum;
+    weights[2] = w2 / sum;
+    weights[3] = w3 / sum;
+}
+
+/*
+ * Computes the weights of the given method for the given fractional position.
+ */
+template<InterpolationMethod METHOD>
+inline void weightsOf(double t, double* weights) {
+    if (METHOD == InterpolationMethod::LANCZOS) {
+        lanczosWeights(t, weights);
+    } else {
+        bicubicWeights(t, weights);
+    }
+}
+
+/*
+ * Interpolates one point with the 4 × 4 pixels starting at (xb-1, yb-1), with the coordinates of pixels outside
+ * the raster clamped to the border. The rows are combined first: the sum of each column is accumulated with the
+ * weights `wy`, then the 4 sums are combined with the weights `wx`, always in the same order. The vectorized
+ * kernel uses the same order of operations, which is why both kernels produce identical results.
+ */
+static double convolve(const float* raster, int width, int height, int xb, int yb,
+                       const double* wx, const double* wy, int32_t* reason)
+{
+    int columns[RESAMPLING_FOOTPRINT];
+    for (int i=0; i<RESAMPLING_FOOTPRINT; i++) {
+        columns[i] = std::clamp(xb - 1 + i, 0, width - 1);
+    }
+    double sums[RESAMPLING_FOOTPRINT];
+    int32_t missing = std::numeric_limits<int32_t>::min();
+    for (int j=0; j<RESAMPLING_FOOTPRINT; j++) {
+        const float* row = raster + (size_t) std::clamp(yb - 1 + j, 0, height - 1) * width;
+        for (int i=0; i<RESAMPLING_FOOTPRINT; i++) {
+            float v = row[columns[i]];
+            missing = std::max(missing, std::bit_cast<int32_t>(v));
+            sums[i] = (j == 0) ? wy[0] * v : std::fma(wy[j], (double) v, sums[i]);
+        }
+    }
+    double result = wx[0] * sums[0];
+    for (int i=1; i<RESAMPLING_FOOTPRINT; i++) {
+        result = std::fma(wx[i], sums[i], result);
+    }
+    *reason = missing;
+    return result;
+}
+
+/*
+ * Interpolates one point at a time with the value of the nearest pixel. Used when no vector instruction set is
+ * available, and for the last points of a batch when their number is not a multiple of the vector length.
+ * The result is the pixel value converted to double-precision, which preserves the NaN payload.
+ */
+int nearestScalar(const float* raster, int width, int height, const double* coordinates, int count, double* results, int32_t* reasons) {
+    for (int i=0; i<count; i++) {
+        double x = coordinates[i << 1];
+        double y = coordinates[(i << 1) | 1];
+        int offset = width * ((int) std::floor(y)) + ((int) std::floor(x));
+        if (offset < 0 || offset >= OFFSET_LIMIT) {
+            return i;
+        }
+        int xr = std::min((int) std::floor(x + 0.5), width  - 1);
+        int yr = std::min((int) std::floor(y + 0.5), height - 1);
+        float v = raster[width * yr + xr];
+        results[i] = v;
+        reasons[i] = std::bit_cast<int32_t>(v);
+    }
+    return count;
+}
+
+/*
+ * Interpolates one point at a time with the bicubic or Lanczos method. Used when no vector instruction set
+ * is available. The weights are computed for each point because they depend on the fractional position.
+ */
+template<InterpolationMethod METHOD>
+int convolveScalar(const float* raster, int width, int height, const double* coordinates, int count, double* results, int32_t* reasons) {
+    for (int i=0; i<count; i++) {
+        double x  = coordinates[i << 1];
+        double y  = coordinates[(i << 1) | 1];
+        double xb = std::floor(x);
+        double yb = std::floor(y);
+        int offset = width * ((int) yb) + ((int) xb);
+        if (offset < 0 || offset >= OFFSET_LIMIT) {
+            return i;
+        }
+        double wx[RESAMPLING_FOOTPRINT], wy[RESAMPLING_FOOTPRINT];
+        weightsOf<METHOD>(x - xb, wx);
+        weightsOf<METHOD>(y - yb, wy);
+        results[i] = convolve(raster, width, height, (int) xb, (int) yb, wx, wy, &reasons[i]);
+    }
+    return count;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/*
+ * Interpolates 8 points per step with the value of the nearest pixel, using AVX2 instructions.
+ * This is the structure of `interpolateAVX2` with a single gather instead of four. The bound
+ * check is done on floor(x), floor(y) as in the bilinear kernel, then the rounded coordinates
+ * are clamped to the last column and row.
+ */
+__attribute__((target("avx2,fma")))
+int nearestAVX2(const float* raster, int width, int height, const double* coordinates, int count, double* results, int32_t* reasons) {
+    const __m256d widths = _mm256_set1_pd(width);
+    const __m256d half   = _mm256_set1_pd(0.5);
+    const __m256d xmax   = _mm256_set1_pd(width  - 1);
+    const __m256d ymax   = _mm256_set1_pd(height - 1);
+    const __m256i limit  = _mm256_set1_epi32(OFFSET_LIMIT - 1);
+    int i = 0;
+    for (; i <= count - 8; i += 8) {
+        __m128i offsets[2], nearest[2];
+        for (int h=0; h<2; h++) {
+            const double* p = coordinates + 2*(i + 4*h);
+            __m256d p0 = _mm256_loadu_pd(p);                    // x0 y0 x1 y1
+            __m256d p1 = _mm256_loadu_pd(p + 4);                // x2 y2 x3 y3
+            __m256d lo = _mm256_permute2f128_pd(p0, p1, 0x20);  // x0 y0 x2 y2
+            __m256d hi = _mm256_permute2f128_pd(p0, p1, 0x31);  // x1 y1 x3 y3
+            __m256d x  = _mm256_unpacklo_pd(lo, hi);
+            __m256d y  = _mm256_unpackhi_pd(lo, hi);
+            __m256d xr = _mm256_min_pd(_mm256_floor_pd(_mm256_add_pd(x, half)), xmax);
+            __m256d yr = _mm256_min_pd(_mm256_floor_pd(_mm256_add_pd(y, half)), ymax);
+            offsets[h] = _mm256_cvttpd_epi32(_mm256_fmadd_pd(_mm256_floor_pd(y), widths, _mm256_floor_pd(x)));
+            nearest[h] = _mm256_cvttpd_epi32(_mm256_fmadd_pd(yr, widths, xr));
+        }
+        __m256i offset = _mm256_set_m128i(offsets[1], offsets[0]);
+        int outside = ~_mm256_movemask_ps(_mm256_castsi256_ps(
+                _mm256_cmpeq_epi32(_mm256_min_epu32(offset, limit), offset)));
+        if (outside & 0xFF) {
+            return i + __builtin_ctz(outside);
+        }
+        __m256 v = _mm256_i32gather_ps(raster, _mm256_set_m128i(nearest[1], nearest[0]), 4);
+        _mm256_storeu_si256((__m256i*) (reasons + i), _mm256_castps_si256(v));
+        _mm256_storeu_pd(results + i,     _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+        _mm256_storeu_pd(results + i + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+    }
+    /*
+     * GCC does not always insert `vzeroupper` on this path. Without it, the upper halves of the registers
+     * stay dirty after the return, and all SSE instructions executed later by the caller were observed to be
+     * more than 20 times slower (for example the scalar bicubic test executed after this kernel).
+     */
+    _mm256_zeroupper();
+    return i + nearestScalar(raster, width, height, coordinates + 2*i, count - i, results + i, reasons + i);
+}
+
+/*
+ * Interpolates one point at a time with the bicubic or Lanczos method, using AVX2 instructions for the footprint.
+ * The 4 pixels of each row of the footprint are contiguous in memory, so each row is fetched with a single load
+ * and the 4 column sums are accumulated in a single vector. The missing value reason is the maximum of the four
+ * rows compared as signed integers, reduced to one value by two shuffles. The sums are combined with the weights
+ * `wx` in the same order as in `convolve(…)`, so the results are identical to the results of the scalar kernel.
+ *
+ * Points having a footprint which crosses the raster border need clamped coordinates, and are delegated to
+ * `convolve(…)`. Vectorizing over the footprint instead of over the points avoids 16 gathers per point,
+ * but the weights are still computed for each point.
+ */
+template<InterpolationMethod METHOD>
+__attribute__((target("avx2,fma")))
+int convolveAVX2(const float* raster, int width, int height, const double* coordinates, int count, double* results, int32_t* reasons) {
+    for (int i=0; i<count; i++) {
+        double x  = coordinates[i << 1];
+        double y  = coordinates[(i << 1) | 1];
+        double xb = std::floor(x);
+        double yb = std::floor(y);
+        int offset = width * ((int) yb) + ((int) xb);
+        if (offset < 0 || offset >= OFFSET_LIMIT) {
+            return i;
+        }
+        double wx[RESAMPLING_FOOTPRINT], wy[RESAMPLING_FOOTPRINT];
+        weightsOf<METHOD>(x - xb, wx);
+        weightsOf<METHOD>(y - yb, wy);
+        const int ix = (int) xb;
+        const int iy = (int) yb;
+        if (ix < 1 || iy < 1 || ix > width - 3 || iy > height - 3) {
+            results[i] = convolve(raster, width, height, ix, iy, wx, wy, &reasons[i]);
+            continue;
+        }
+        const float* row = raster + (offset - width - 1);
+        __m128 r0 = _mm_loadu_ps(row);
+        __m128 r1 = _mm_loadu_ps(row += width);
+        __m128 r2 = _mm_loadu_ps(row += width);
+        __m128 r3 = _mm_loadu_ps(row += width);
+        __m128i reason = _mm_max_epi32(
+                _mm_max_epi32(_mm_castps_si128(r0), _mm_castps_si128(r1)),
+                _mm_max_epi32(_mm_castps_si128(r2), _mm_castps_si128(r3)));
+        reason = _mm_max_epi32(reason, _mm_shuffle_epi32(reason, 0x4E));
+        reason = _mm_max_epi32(reason, _mm_shuffle_epi32(reason, 0xB1));
+        reasons[i] = _mm_cvtsi128_si32(reason);
+        __m256d sums = _mm256_mul_pd(_mm256_set1_pd(wy[0]), _mm256_cvtps_pd(r0));
+        sums = _mm256_fmadd_pd(_mm256_set1_pd(wy[1]), _mm256_cvtps_pd(r1), sums);
+        sums = _mm256_fmadd_pd(_mm256_set1_pd(wy[2]), _mm256_cvtps_pd(r2), sums);
+        sums = _mm256_fmadd_pd(_mm256_set1_pd(wy[3]), _mm256_cvtps_pd(r3), sums);
+        double s[RESAMPLING_FOOTPRINT];
+        _mm256_storeu_pd(s, sums);
+        double result = wx[0] * s[0];
+        result = std::fma(wx[1], s[1], result);
+        result = std::fma(wx[2], s[2], result);
+        results[i] = std::fma(wx[3], s[3], result);
+    }
+    return count;
+}
+#endif
+
+/*
+ * Returns the fastest kernel of the given method supported by the processor on which this code is running.
+ * The name of the selected instruction set is stored in `name` for information purpose. There is no NEON
+ * variant yet: the scalar kernels are used on ARM.
+ */
+InterpolationKernel selectResamplingKernel(InterpolationMethod method, const char** name) {
+    #if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        switch (method) {
+            case InterpolationMethod::NEAREST: *name = "AVX2 (8 points per step)"; return nearestAVX2;
+            case InterpolationMethod::BICUBIC: *name = "AVX2 (4 pixels per load)"; return convolveAVX2<InterpolationMethod::BICUBIC>;
+            case InterpolationMethod::LANCZOS: *name = "AVX2 (4 pixels per load)"; return convolveAVX2<InterpolationMethod::LANCZOS>;
+        }
+    }
+    #endif
+    *name = "scalar (1 point per step)";
+    switch (method) {
+        case InterpolationMethod::BICUBIC: return convolveScalar<InterpolationMethod::BICUBIC>;
+        case InterpolationMethod::LANCZOS: return convolveScalar<InterpolationMethod::LANCZOS>;
+        default: return nearestScalar;
+    }
+}
+
+/*
+ * Interpolates the raster at all points given as (x,y) tuples in the `xy` array, in pixel units, with the given
+ * method. The results and the missing value reasons are stored as by `interpolate(…)`, except that the reason is
+ * the maximal bit pattern of all pixels of the footprint of the method (see `InterpolationMethod`). The kernel of
+ * each method is selected once, on the first call. The points are given to the kernel in a single call.
+ *
+ * Returns the number of points that have been interpolated, with the same meaning as `interpolate(…)`.
+ * Throws `std::length_error` if an output array is too short.
+ */
+int resample(const Raster& raster, InterpolationMethod method, std::span<const double> xy, std::span<double> out, std::span<int32_t> reasons) {
+    static const InterpolationKernel* kernels = [] {
+        static InterpolationKernel selected[NUM_INTERPOLATION_METHODS];
+        const char* name;
+        for (int m=0; m<NUM_INTERPOLATION_METHODS; m++) {
+            selected[m] = selectResamplingKernel((InterpolationMethod) m, &name);
+        }
+        return selected;
+    }();
+    size_t count = xy.size() / 2;
+    if (out.size() < count || reasons.size() < count) {
+        throw std::length_error("The output arrays are shorter than the number of points.");
+    }
+    return kernels[(int) method](raster.values, raster.width, raster.height, xy.data(), (int) count, out.data(), reasons.data());
+}
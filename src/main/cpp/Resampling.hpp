@@ -0,0 +1,59 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#ifndef RESAMPLING_HPP
+#define RESAMPLING_HPP
+
+#include <cstdint>
+#include <span>
+#include "Interpolation.hpp"
+
+/*
+ * Interpolation methods other than the bilinear one of `interpolate(…)`.
+ *
+ *   - `NEAREST`: the value of the nearest pixel, which is the pixel at floor(x + ½), floor(y + ½).
+ *   - `BICUBIC`: cubic convolution (Catmull-Rom spline) on the 4 × 4 pixels around the point.
+ *   - `LANCZOS`: Lanczos filter with a = 2, also on the 4 × 4 pixels around the point.
+ *
+ * The 4 × 4 footprint starts one pixel before the pixel at floor(x), floor(y). Pixels outside the raster
+ * are replaced by the nearest pixel on the raster border. The missing value reason of a result is the
+ * maximal bit pattern of all pixels of the footprint, compared as signed integers as in the bilinear case,
+ * including the pixels having a weight of zero. Consequently, the payload of the NaN having precedence is
+ * propagated from any contributing pixel, and a result is missing if any pixel of the footprint is missing.
+ */
+enum class InterpolationMethod {
+    NEAREST,
+    BICUBIC,
+    LANCZOS
+};
+
+/*
+ * Number of interpolation methods, and their names in the order of the enumeration values.
+ */
+#define NUM_INTERPOLATION_METHODS 3
+extern const char* INTERPOLATION_METHOD_NAMES[NUM_INTERPOLATION_METHODS];
+
+/*
+ * Number of pixels along each axis of the footprint of the bicubic and Lanczos methods.
+ */
+#define RESAMPLING_FOOTPRINT 4
+
+/*
+ * Computes the weights of the 4 pixels of a row or column for the given fractional position, from 0 inclusive
+ * to 1 exclusive. The weights of the pixels before, at, after and two pixels after floor(x) are stored in that
+ * order in `weights`. The functions are never inlined, so that a caller reproducing the kernel computation
+ * one point at a time (for example as a reference) gets the same weights to the last bit.
+ */
+void bicubicWeights(double t, double* weights);
+void lanczosWeights(double t, double* weights);
+
+InterpolationKernel selectResamplingKernel(InterpolationMethod, const char**);
+
+/*
+ * Interpolations of a batch of points with the given method. The arguments and the returned value have the same
+ * meaning as for `interpolate(…)`, including the bound check. See `Resampling.cpp` for the computation.
+ */
+int resample(const Raster&, InterpolationMethod, std::span<const double> xy, std::span<double> out, std::span<int32_t> reasons);
+
+#endif
@@ -0,0 +1,431 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cstdio>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include <numbers>
+#include <algorithm>
+#include "ResamplingTest.hpp"
+
+/*
+ * Maximal number of pixels in the footprint of an interpolation method.
+ */
+#define MAX_FOOTPRINT (RESAMPLING_FOOTPRINT * RESAMPLING_FOOTPRINT)
+
+/*
+ * Fetches the pixels used by the interpolation of the point at (x,y) with the given method, and computes
+ * the weights of the columns and rows. This is the same footprint as in `Resampling.cpp`: the nearest pixel,
+ * or the 4 × 4 pixels starting one pixel before floor(x), floor(y) with coordinates clamped to the border.
+ * The pixels are stored in row-major order in `samples`. Returns the number of pixels, which is 1 or 16.
+ */
+static int footprint(InterpolationMethod method, const float* raster, int width, int height, double x, double y,
+                     float* samples, double* wx, double* wy)
+{
+    if (method == InterpolationMethod::NEAREST) {
+        int xr = std::min((int) std::floor(x + 0.5), width  - 1);
+        int yr = std::min((int) std::floor(y + 0.5), height - 1);
+        samples[0] = raster[width * yr + xr];
+        return 1;
+    }
+    double xb = std::floor(x);
+    double yb = std::floor(y);
+    if (method == InterpolationMethod::LANCZOS) {
+        lanczosWeights(x - xb, wx);
+        lanczosWeights(y - yb, wy);
+    } else {
+        bicubicWeights(x - xb, wx);
+        bicubicWeights(y - yb, wy);
+    }
+    for (int j=0; j<RESAMPLING_FOOTPRINT; j++) {
+        const float* row = raster + (size_t) std::clamp((int) yb - 1 + j, 0, height - 1) * width;
+        for (int i=0; i<RESAMPLING_FOOTPRINT; i++) {
+            samples[j * RESAMPLING_FOOTPRINT + i] = row[std::clamp((int) xb - 1 + i, 0, width - 1)];
+        }
+    }
+    return MAX_FOOTPRINT;
+}
+
+/*
+ * Combines the pixels fetched by `footprint(…)` with the weights. The column sums are accumulated over the rows,
+ * then combined with the column weights, in the same order of operations as the kernels of `Resampling.cpp`.
+ * Variables starting with "v" are converted from `float` to `double`.
+ */
+static double combine(int count, const float* samples, const double* wx, const double* wy) {
+    if (count == 1) {
+        return samples[0];
+    }
+    double sums[RESAMPLING_FOOTPRINT];
+    for (int i=0; i<RESAMPLING_FOOTPRINT; i++) {
+        sums[i] = wy[0] * samples[i];
+    }
+    for (int j=1; j<RESAMPLING_FOOTPRINT; j++) {
+        for (int i=0; i<RESAMPLING_FOOTPRINT; i++) {
+            double v = samples[j * RESAMPLING_FOOTPRINT + i];
+            sums[i] = std::fma(wy[j], v, sums[i]);
+        }
+    }
+    double result = wx[0] * sums[0];
+    for (int i=1; i<RESAMPLING_FOOTPRINT; i++) {
+        result = std::fma(wx[i], sums[i], result);
+    }
+    return result;
+}
+
+/*
+ * Returns the expected values of all verified iterations with the given interpolation method, computing them
+ * on the first call. This is the calculation of `TestNodata` with the bilinear interpolation replaced by the
+ * given method: the pixels are read from the "nodata" raster, a missing result is stored as the sentinel value
+ * having precedence, and the points are moved by the result (or by 1 if missing) after each iteration.
+ * Those values only check that the variants agree with each other: the correctness of the methods themselves
+ * is verified by `verifyResamplingMethods()` against the textbook formulas.
+ * Returns NULL if the values would be larger than `EXPECTED_RESULTS_CACHE_LIMIT`, if the raster or the coordinates
+ * cannot be read, or if a point is out of bounds.
+ */
+const double* DataCache::expectedResults(InterpolationMethod method) {
+    std::vector<double>& results = resampledResults[(int) method];
+    if (results.empty()) {
+        const int width     = config.width;
+        const int height    = config.height;
+        const int numPoints = config.numInterpolationPoints;
+        if ((size_t) config.numVerifiedIterations * numPoints * sizeof(double) > EXPECTED_RESULTS_CACHE_LIMIT) {
+            return NULL;
+        }
+        const RasterLayout layout(width, height, 0);
+        const float*  values = raster(false, std::endian::native, layout);
+        const double* source = coordinates(false);
+        if (!values || !source) {
+            return NULL;
+        }
+        std::vector<double> xy(source, source + 2 * (size_t) numPoints);
+        results.resize((size_t) config.numVerifiedIterations * numPoints);
+        double* target = results.data();
+        for (int it=0; it<config.numVerifiedIterations; it++) {
+            for (int i=0; i<numPoints; i++) {
+                double x = xy[2*i];
+                double y = xy[2*i + 1];
+                if (layout.offset((int) std::floor(x), (int) std::floor(y)) < 0) {
+                    results.clear();
+                    return NULL;
+                }
+                float  samples[MAX_FOOTPRINT];
+                double wx[RESAMPLING_FOOTPRINT], wy[RESAMPLING_FOOTPRINT];
+                int count = footprint(method, values, width, height, x, y, samples, wx, wy);
+                float missingValueReason = *std::max_element(samples, samples + count);
+                double result;
+                if (missingValueReason >= MISSING_VALUE_THRESHOLD) {
+                    *target++ = missingValueReason;
+                    result = 1;
+                } else {
+                    *target++ = result = combine(count, samples, wx, wy);
+                }
+                movePoint(&xy[2*i], result, width, height);
+            }
+        }
+    }
+    return results.data();
+}
+
+
+
+/*
+ * Kernels of the bicubic (Catmull-Rom, a = -½) and Lanczos (a = 2) methods for a distance `d` to a pixel,
+ * written as in the textbooks for verifying the factored computations of `Resampling.cpp` independently.
+ */
+static double catmullRom(double d) {
+    d = std::abs(d);
+    if (d <= 1) return (1.5 * d - 2.5) * d * d + 1;
+    if (d <  2) return ((-0.5 * d + 2.5) * d - 4) * d + 2;
+    return 0;
+}
+
+static double lanczos(double d) {
+    if (d == 0) return 1;
+    if (std::abs(d) >= 2) return 0;
+    const double p = std::numbers::pi * d;
+    return (std::sin(p) / p) * (std::sin(p / 2) / (p / 2));
+}
+
+/*
+ * Verifies the weights and the results of the interpolation methods independently of the data files, which is
+ * needed because the expected results of the tests are computed with the same weights as the tested variants.
+ * The weights are compared with the textbook kernels and shall sum to 1, the bicubic weights shall reproduce
+ * a linear ramp exactly, and `resample(…)` on a small raster shall give the values of a 2-dimensional sum
+ * of the pixels weighted by those kernels. Returns whether all verifications passed, after printing a message
+ * for each failure.
+ */
+bool verifyResamplingMethods() {
+    const double TOLERANCE = 1E-12;
+    bool success = true;
+    for (double t : {0.0, 0.125, 0.25, 1.0/3, 0.5, 2.0/3, 0.75, 0.875, 0.999}) {
+        double bicubic[RESAMPLING_FOOTPRINT], lanczos2[RESAMPLING_FOOTPRINT], expected[RESAMPLING_FOOTPRINT];
+        bicubicWeights(t, bicubic);
+        lanczosWeights(t, lanczos2);
+        double sum = 0, ramp = 0;
+        for (int i=0; i<RESAMPLING_FOOTPRINT; i++) {
+            sum  += lanczos(t + 1 - i);
+            ramp += bicubic[i] * (i - 1);
+        }
+        for (int i=0; i<RESAMPLING_FOOTPRINT; i++) {
+            expected[i] = lanczos(t + 1 - i) / sum;
+            if (std::abs(bicubic[i] - catmullRom(t + 1 - i)) > TOLERANCE || std::abs(lanczos2[i] - expected[i]) > TOLERANCE) {
+                printf("Wrong weight of pixel %d at t = %g.\n", i, t);
+                success = false;
+            }
+        }
+        double bicubicSum = 0, lanczosSum = 0;
+        for (int i=0; i<RESAMPLING_FOOTPRINT; i++) {
+            bicubicSum += bicubic[i];
+            lanczosSum += lanczos2[i];
+        }
+        if (std::abs(bicubicSum - 1) > TOLERANCE || std::abs(lanczosSum - 1) > TOLERANCE) {
+            printf("Weights do not sum to 1 at t = %g.\n", t);
+            success = false;
+        }
+        if (std::abs(ramp - t) > TOLERANCE) {
+            printf("Bicubic weights do not reproduce a linear ramp at t = %g.\n", t);
+            success = false;
+        }
+    }
+    /*
+     * Interpolate inside a raster where the value is a plane plus a checkerboard, so that the Lanczos result
+     * depends on all weights. The points are far enough from the border for the footprint to be unclamped.
+     */
+    const int size = 8;
+    float values[size * size];
+    for (int y=0; y<size; y++) {
+        for (int x=0; x<size; x++) {
+            values[y * size + x] = 3*x - 2*y + 5 + (((x + y) & 1) ? 0.25f : -0.25f);
+        }
+    }
+    const Raster raster(values, size, size);
+    const double xy[] = {2, 3, 2.25, 3.5, 3.875, 2.125, 4.5, 4.5, 2.6, 4.3};
+    const int numPoints = sizeof(xy) / (2 * sizeof(double));
+    double  results[numPoints];
+    int32_t reasons[numPoints];
+    for (int m=0; m<NUM_INTERPOLATION_METHODS; m++) {
+        const InterpolationMethod method = (InterpolationMethod) m;
+        if (resample(raster, method, std::span(xy), std::span(results, numPoints), std::span(reasons, numPoints)) != numPoints) {
+            printf("%s: points out of bounds.\n", INTERPOLATION_METHOD_NAMES[m]);
+            success = false;
+            continue;
+        }
+        for (int i=0; i<numPoints; i++) {
+            const double x = xy[2*i], y = xy[2*i + 1];
+            double expected = 0, sum = 0;
+            if (method == InterpolationMethod::NEAREST) {
+                expected = values[(int) std::floor(y + 0.5) * size + (int) std::floor(x + 0.5)];
+                sum = 1;
+            } else for (int py=0; py<size; py++) {
+                for (int px=0; px<size; px++) {
+                    double w = (method == InterpolationMethod::LANCZOS) ? lanczos(x - px) * lanczos(y - py)
+                                                                        : catmullRom(x - px) * catmullRom(y - py);
+                    expected += w * values[py * size + px];
+                    sum += w;
+                }
+            }
+            expected /= sum;
+            if (std::abs(results[i] - expected) > 1E-9) {
+                printf("%s: expected %.12g but got %.12g at (%g, %g).\n", INTERPOLATION_METHOD_NAMES[m], expected, results[i], x, y);
+                success = false;
+            }
+        }
+    }
+    return success;
+}
+
+
+
+/*
+ * Creates a new test which will use "no data" sentinel values with the given interpolation method.
+ * The raster is used in row-major order and native byte order.
+ */
+TestNodataResampled::TestNodataResampled(Arena& arena, DataCache& cache, InterpolationMethod testedMethod)
+        : TestNodata(arena, cache, std::endian::native, 0)
+{
+    method = testedMethod;
+}
+
+/*
+ * Reads the raster, performs interpolations and compares against the expected values.
+ * This is the loop of `TestNodata::computeAndCompare()` with the footprint of the tested method.
+ * It returns the execution time (in nanoseconds) of the numerical computation part.
+ */
+double TestNodataResampled::computeAndCompare() {
+    std::chrono::time_point<std::chrono::high_resolution_clock> startTime, endTime;
+    const float* raster = loadRaster();
+    if (raster) {
+        double* coordinates = loadCoordinates();
+        const double* allExpected = cache.expectedResults(method);
+        if (coordinates && allExpected) {
+            ExpectedResults expectedResults;
+            expectedResults.open(allExpected, 0, config.numInterpolationPoints);
+            const int width  = config.width;
+            const int height = config.height;
+            uint64_t total[NUM_PERF_COUNTERS], snapshot[NUM_PERF_COUNTERS];
+            startTime = std::chrono::high_resolution_clock::now();
+            startCounters(total);
+            for (int it=0; it<config.numVerifiedIterations; it++) {
+                startCounters(snapshot);
+                const double* expectedResultCursor = expectedResults.next();
+                double stats = errorStatistics[it];
+                for (int i=0; i<config.numInterpolationPoints; i++) {
+                    int ix = i << 1;
+                    int iy = ix | 1;
+                    double x = coordinates[ix];
+                    double y = coordinates[iy];
+                    if (layout.offset((int) std::floor(x), (int) std::floor(y)) < 0) {
+                        printf("Coordinates out of bounds: (%g, %g) for point %d.\n", x, y, i);
+                        exit(1);
+                    }
+                    float  samples[MAX_FOOTPRINT];
+                    double wx[RESAMPLING_FOOTPRINT], wy[RESAMPLING_FOOTPRINT];
+                    int count = footprint(method, raster, width, height, x, y, samples, wx, wy);
+                    double result;    // To be computed below.
+                    /*
+                     * Check if any raster value is missing before the calculation, with the same trick as in
+                     * `TestNodata`: the maximal value is the "no data" having precedence. The footprint of the
+                     * bicubic and Lanczos methods has 16 pixels, so this check is 4 times longer than bilinear.
+                     */
+                    float missingValueReason = *std::max_element(samples, samples + count);
+                    const bool missing = (missingValueReason >= MISSING_VALUE_THRESHOLD);
+                    result = missing ? 0 : combine(count, samples, wx, wy);
+                    result = verifyResult(missing, missingValueReason, result, *expectedResultCursor++, nodataMismatches[it], stats);
+                    movePoint(coordinates + ix, result, width, height);
+                }
+                errorStatistics[it] = stats;
+                stopCounters(snapshot, it);
+            }
+            stopCounters(total, config.numVerifiedIterations);
+            endTime = std::chrono::high_resolution_clock::now();
+        }
+    }
+    return duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+/*
+ * Returns the index of this variant, because this test is the reference of the other variants of the same method.
+ */
+int TestNodataResampled::referenceVariant() const {
+    return FIRST_RESAMPLING_VARIANT + 3 * (int) method;
+}
+
+/*
+ * Prints the interpolation method.
+ */
+void TestNodataResampled::printDetails() const {
+    printf("Interpolation method: %s\n", INTERPOLATION_METHOD_NAMES[(int) method]);
+}
+
+
+
+/*
+ * Creates a new test which will use NaN values with the given interpolation method, computed either
+ * one point at a time in this class or by the fastest kernel of the `naninterp` library.
+ */
+TestNaNResampled::TestNaNResampled(Arena& arena, DataCache& cache, InterpolationMethod testedMethod, bool vectorized)
+        : TestNaN(arena, cache, std::endian::native, 0)
+{
+    method     = testedMethod;
+    kernel     = NULL;
+    kernelName = "none (1 point per step)";
+    if (vectorized) {
+        kernel = selectResamplingKernel(method, &kernelName);
+    }
+}
+
+/*
+ * Reads the raster, performs interpolations and compares against the expected values.
+ * Without kernel, this is the loop of `TestNaN::computeAndCompare()` with the footprint of the tested method.
+ * With a kernel, the interpolations are computed by batches of `SIMD_BATCH_SIZE` points before being verified,
+ * as in `TestNaNSIMD`. The results are missing if they are NaN, in which case the reason is the maximal bit
+ * pattern of the footprint. It returns the execution time (in nanoseconds) of the numerical computation part.
+ */
+double TestNaNResampled::computeAndCompare() {
+    std::chrono::time_point<std::chrono::high_resolution_clock> startTime, endTime;
+    const float* raster = loadRaster();
+    if (raster) {
+        double* coordinates = loadCoordinates();
+        const double* allExpected = cache.expectedResults(method);
+        if (coordinates && allExpected) {
+            ExpectedResults expectedResults;
+            expectedResults.open(allExpected, 0, config.numInterpolationPoints);
+            const int width     = config.width;
+            const int height    = config.height;
+            const int numPoints = config.numInterpolationPoints;
+            double  results[SIMD_BATCH_SIZE];
+            int32_t reasons[SIMD_BATCH_SIZE];
+            uint64_t total[NUM_PERF_COUNTERS], snapshot[NUM_PERF_COUNTERS];
+            startTime = std::chrono::high_resolution_clock::now();
+            startCounters(total);
+            for (int it=0; it<config.numVerifiedIterations; it++) {
+                startCounters(snapshot);
+                const double* expectedResultCursor = expectedResults.next();
+                double stats = errorStatistics[it];
+                for (int start=0; start < numPoints; start += SIMD_BATCH_SIZE) {
+                    auto batchStart  = startBatch();
+                    const int length = std::min(SIMD_BATCH_SIZE, numPoints - start);
+                    double* xy = coordinates + 2*start;
+                    if (kernel) {
+                        int valid = kernel(raster, width, height, xy, length, results, reasons);
+                        if (valid != length) {
+                            printf("Coordinates out of bounds: (%g, %g) for point %d.\n",
+                                   xy[2*valid], xy[2*valid + 1], start + valid);
+                            exit(1);
+                        }
+                    } else {
+                        /*
+                         * Apply the interpolation unconditionally, and take the maximal bit pattern of all pixels
+                         * as the missing value reason. The NaN of any pixel propagates to the result.
+                         */
+                        for (int i=0; i<length; i++) {
+                            double x = xy[2*i];
+                            double y = xy[2*i + 1];
+                            if (layout.offset((int) std::floor(x), (int) std::floor(y)) < 0) {
+                                printf("Coordinates out of bounds: (%g, %g) for point %d.\n", x, y, start + i);
+                                exit(1);
+                            }
+                            float  samples[MAX_FOOTPRINT];
+                            double wx[RESAMPLING_FOOTPRINT], wy[RESAMPLING_FOOTPRINT];
+                            int count = footprint(method, raster, width, height, x, y, samples, wx, wy);
+                            int32_t missingValueReason = floatToRawIntBits(samples[0]);
+                            for (int k=1; k<count; k++) {
+                                missingValueReason = std::max(missingValueReason, floatToRawIntBits(samples[k]));
+                            }
+                            results[i] = combine(count, samples, wx, wy);
+                            reasons[i] = missingValueReason;
+                        }
+                    }
+                    for (int i=0; i<length; i++) {
+                        double nodata = (reasons[i] - FIRST_QUIET_NAN) + MISSING_VALUE_THRESHOLD;
+                        double result = verifyResult(isMissing(results[i]), nodata, results[i], *expectedResultCursor++,
+                                                     nodataMismatches[it], stats);
+                        movePoint(xy + 2*i, result, width, height);
+                    }
+                    stopBatch(batchStart);
+                }
+                errorStatistics[it] = stats;
+                stopCounters(snapshot, it);
+            }
+            stopCounters(total, config.numVerifiedIterations);
+            endTime = std::chrono::high_resolution_clock::now();
+        }
+    }
+    return duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+/*
+ * Returns the index of the `TestNodataResampled` variant of the same method.
+ */
+int TestNaNResampled::referenceVariant() const {
+    return FIRST_RESAMPLING_VARIANT + 3 * (int) method;
+}
+
+/*
+ * Prints the interpolation method and the kernel used.
+ */
+void TestNaNResampled::printDetails() const {
+    printf("Interpolation method: %s, kernel: %s\n", INTERPOLATION_METHOD_NAMES[(int) method], kernelName);
+}
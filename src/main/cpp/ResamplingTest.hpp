@@ -0,0 +1,73 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#ifndef RESAMPLING_TEST_HPP
+#define RESAMPLING_TEST_HPP
+
+#include "TestCase.hpp"
+#include "Resampling.hpp"
+
+/*
+ * Index of the first variant of `createTestVariant(…)` using an interpolation method other than bilinear.
+ * There are 3 variants per method, in the order of `InterpolationMethod`: `TestNodataResampled`, then
+ * `TestNaNResampled` one point at a time, then `TestNaNResampled` with the vectorized kernel.
+ */
+#define FIRST_RESAMPLING_VARIANT 24
+
+/*
+ * Same calculation as `TestNodata` but with the nearest-neighbour, bicubic or Lanczos interpolation.
+ * This is the reference of the `TestNaNResampled` variants of the same method. All pixels of the footprint
+ * are checked before the calculation, and the "no data" sentinel value having precedence is the maximum.
+ *
+ * There is no file of expected results for those methods. Instead, the expected results are computed
+ * in memory by `DataCache::expectedResults(InterpolationMethod)`, in the same way as `DataGenerator`
+ * computes the expected results of the bilinear interpolation. Because they use the same weights,
+ * those values do not prove that the methods are correct: this is verified by `verifyResamplingMethods()`.
+ * The variants are skipped if the expected results would be larger than `EXPECTED_RESULTS_CACHE_LIMIT`.
+ */
+class TestNodataResampled : public TestNodata {
+    /*
+     * The interpolation method to test.
+     */
+    InterpolationMethod method;
+
+    public:
+        TestNodataResampled(Arena& arena, DataCache& cache, InterpolationMethod method);
+        double computeAndCompare();
+        int    referenceVariant() const;
+        void   printDetails() const;
+};
+
+/*
+ * Same calculation as `TestNaN` but with the nearest-neighbour, bicubic or Lanczos interpolation.
+ * The interpolation is computed unconditionally, and the missing value reason is the maximal bit pattern
+ * of all pixels of the footprint. Optionally, the interpolations are computed by the vectorized kernels
+ * of the `naninterp` library by batches of `SIMD_BATCH_SIZE` points, as in `TestNaNSIMD`.
+ * The results shall be identical to the results of the `TestNodataResampled` variant of the same method.
+ */
+class TestNaNResampled : public TestNaN {
+    /*
+     * The interpolation method to test.
+     */
+    InterpolationMethod method;
+
+    /*
+     * The kernel of the `naninterp` library and its name, or NULL for interpolating one point at a time.
+     */
+    InterpolationKernel kernel;
+    const char* kernelName;
+
+    public:
+        TestNaNResampled(Arena& arena, DataCache& cache, InterpolationMethod method, bool vectorized);
+        double computeAndCompare();
+        int    referenceVariant() const;
+        void   printDetails() const;
+};
+
+/*
+ * Verifies the interpolation methods against textbook formulas, independently of the data files.
+ */
+bool verifyResamplingMethods();
+
+#endif
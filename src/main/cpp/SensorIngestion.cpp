@@ -0,0 +1,190 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cstdint>
+#include <cmath>
+#include <bit>
+#include <span>
+#include <stdexcept>
+#include "SensorIngestion.hpp"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/*
+ * Value of the first positive quiet NaN, which is the NaN of the first sentinel code.
+ */
+#define FIRST_QUIET_NAN 0x7FC00000
+
+/*
+ * Converts one code at a time. Used when no vector instruction set is available, and for the last codes
+ * when their number is not a multiple of the vector length. The sentinels are replaced with selections
+ * on the bit patterns, so the NaN never go through a floating-point operation. If many sentinels are
+ * equal, the one of highest payload is used, as in the vectorized code.
+ */
+template<SensorType TYPE, bool SWAP>
+void ingestScalar(const uint16_t* source, size_t count, const SensorFormat& format, float* target) {
+    for (size_t i=0; i<count; i++) {
+        uint16_t bits = source[i];
+        if (SWAP) bits = (uint16_t) ((bits << 8) | (bits >> 8));
+        int32_t code  = (TYPE == SensorType::INT16) ? (int32_t) (int16_t) bits : (int32_t) bits;
+        int32_t value = std::bit_cast<int32_t>(std::fma((float) code, format.scale, format.offset));
+        for (int k=0; k<NUM_SENSOR_REASONS; k++) {
+            value = (code == format.sentinels[k]) ? FIRST_QUIET_NAN + k : value;
+        }
+        target[i] = std::bit_cast<float>(value);
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/*
+ * Converts 16 codes per step with AVX2 instructions. The bytes are swapped by a shuffle of the whole vector,
+ * then each half is widened to 8 integers of 32 bits, converted exactly to `float` and scaled by a fused
+ * multiply-add, which gives the same result as `std::fma` in the scalar code. The sentinels are replaced
+ * by blending their NaN where the codes are equal.
+ */
+template<SensorType TYPE, bool SWAP>
+__attribute__((target("avx2,fma")))
+void ingestAVX2(const uint16_t* source, size_t count, const SensorFormat& format, float* target) {
+    const __m256i swap   = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    const __m256  scale  = _mm256_set1_ps(format.scale);
+    const __m256  offset = _mm256_set1_ps(format.offset);
+    __m256i sentinels[NUM_SENSOR_REASONS], nans[NUM_SENSOR_REASONS];
+    for (int k=0; k<NUM_SENSOR_REASONS; k++) {
+        sentinels[k] = _mm256_set1_epi32(format.sentinels[k]);
+        nans[k]      = _mm256_set1_epi32(FIRST_QUIET_NAN + k);
+    }
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i bits = _mm256_loadu_si256((const __m256i*) (source + i));
+        if (SWAP) bits = _mm256_shuffle_epi8(bits, swap);
+        __m128i halves[2] = {_mm256_castsi256_si128(bits), _mm256_extracti128_si256(bits, 1)};
+        for (int h=0; h<2; h++) {
+            __m256i code  = (TYPE == SensorType::INT16) ? _mm256_cvtepi16_epi32(halves[h]) : _mm256_cvtepu16_epi32(halves[h]);
+            __m256i value = _mm256_castps_si256(_mm256_fmadd_ps(_mm256_cvtepi32_ps(code), scale, offset));
+            for (int k=0; k<NUM_SENSOR_REASONS; k++) {
+                value = _mm256_blendv_epi8(value, nans[k], _mm256_cmpeq_epi32(code, sentinels[k]));
+            }
+            _mm256_storeu_si256((__m256i*) (target + i + 8*h), value);
+        }
+    }
+    _mm256_zeroupper();     // Not always emitted by the compiler before the scalar code.
+    ingestScalar<TYPE, SWAP>(source + i, count - i, format, target + i);
+}
+
+/*
+ * Converts 16 codes per step with AVX-512 instructions. This is the same computation as `ingestAVX2`
+ * on vectors of 16 integers, with the sentinels replaced by masked moves.
+ */
+template<SensorType TYPE, bool SWAP>
+__attribute__((target("avx512f")))
+void ingestAVX512(const uint16_t* source, size_t count, const SensorFormat& format, float* target) {
+    const __m256i swap   = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    const __m512  scale  = _mm512_set1_ps(format.scale);
+    const __m512  offset = _mm512_set1_ps(format.offset);
+    __m512i sentinels[NUM_SENSOR_REASONS], nans[NUM_SENSOR_REASONS];
+    for (int k=0; k<NUM_SENSOR_REASONS; k++) {
+        sentinels[k] = _mm512_set1_epi32(format.sentinels[k]);
+        nans[k]      = _mm512_set1_epi32(FIRST_QUIET_NAN + k);
+    }
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i bits = _mm256_loadu_si256((const __m256i*) (source + i));
+        if (SWAP) bits = _mm256_shuffle_epi8(bits, swap);
+        __m512i code  = (TYPE == SensorType::INT16) ? _mm512_cvtepi16_epi32(bits) : _mm512_cvtepu16_epi32(bits);
+        __m512i value = _mm512_castps_si512(_mm512_fmadd_ps(_mm512_cvtepi32_ps(code), scale, offset));
+        for (int k=0; k<NUM_SENSOR_REASONS; k++) {
+            value = _mm512_mask_mov_epi32(value, _mm512_cmpeq_epi32_mask(code, sentinels[k]), nans[k]);
+        }
+        _mm512_storeu_si512(target + i, value);
+    }
+    ingestAVX2<TYPE, SWAP>(source + i, count - i, format, target + i);
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+/*
+ * Converts 8 codes per step with NEON instructions. This is the same computation as the AVX2 code
+ * on vectors of 4 integers, with the bytes swapped by `vrev16q_u8` and the sentinels replaced by bit selections.
+ */
+template<SensorType TYPE, bool SWAP>
+void ingestNEON(const uint16_t* source, size_t count, const SensorFormat& format, float* target) {
+    const float32x4_t scale  = vdupq_n_f32(format.scale);
+    const float32x4_t offset = vdupq_n_f32(format.offset);
+    int32x4_t sentinels[NUM_SENSOR_REASONS], nans[NUM_SENSOR_REASONS];
+    for (int k=0; k<NUM_SENSOR_REASONS; k++) {
+        sentinels[k] = vdupq_n_s32(format.sentinels[k]);
+        nans[k]      = vdupq_n_s32(FIRST_QUIET_NAN + k);
+    }
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint16x8_t bits = vld1q_u16(source + i);
+        if (SWAP) bits = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(bits)));
+        int32x4_t codes[2];
+        if (TYPE == SensorType::INT16) {
+            int16x8_t signed16 = vreinterpretq_s16_u16(bits);
+            codes[0] = vmovl_s16(vget_low_s16(signed16));
+            codes[1] = vmovl_high_s16(signed16);
+        } else {
+            codes[0] = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(bits)));
+            codes[1] = vreinterpretq_s32_u32(vmovl_high_u16(bits));
+        }
+        for (int h=0; h<2; h++) {
+            int32x4_t value = vreinterpretq_s32_f32(vfmaq_f32(offset, vcvtq_f32_s32(codes[h]), scale));
+            for (int k=0; k<NUM_SENSOR_REASONS; k++) {
+                value = vbslq_s32(vceqq_s32(codes[h], sentinels[k]), nans[k], value);
+            }
+            vst1q_s32((int32_t*) (target + i + 4*h), value);
+        }
+    }
+    ingestScalar<TYPE, SWAP>(source + i, count - i, format, target + i);
+}
+#endif
+
+/*
+ * Returns the specialization of the given converter template for the integer type and byte order of a format.
+ */
+#define SPECIALIZE_FORMAT(converter, format)                                                \
+    ((format).type == SensorType::INT16                                                     \
+        ? (((format).byteOrder == std::endian::native) ? converter<SensorType::INT16,  false>  \
+                                                       : converter<SensorType::INT16,  true>)  \
+        : (((format).byteOrder == std::endian::native) ? converter<SensorType::UINT16, false>  \
+                                                       : converter<SensorType::UINT16, true>))
+
+/*
+ * Returns the fastest converter supported by the processor on which this code is running, specialized
+ * for the integer type and byte order of the given format. The name of the selected instruction set
+ * is stored in `name` for information purpose.
+ */
+SensorConverter selectSensorConverter(const SensorFormat& format, const char** name) {
+    #if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx512f")) {
+        *name = "AVX-512 (16 codes per step)";
+        return SPECIALIZE_FORMAT(ingestAVX512, format);
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        *name = "AVX2 (16 codes per step)";
+        return SPECIALIZE_FORMAT(ingestAVX2, format);
+    }
+    #elif defined(__ARM_NEON) && defined(__aarch64__)
+    *name = "NEON (8 codes per step)";
+    return SPECIALIZE_FORMAT(ingestNEON, format);
+    #endif
+    *name = "scalar (1 code per step)";
+    return SPECIALIZE_FORMAT(ingestScalar, format);
+}
+
+/*
+ * Converts all codes of the source to `float` values with the fastest converter for the format.
+ * The target shall not be shorter than the source.
+ */
+void ingest(const SensorFormat& format, std::span<const uint16_t> source, std::span<float> target) {
+    if (target.size() < source.size()) {
+        throw std::length_error("The target array is shorter than the source array.");
+    }
+    const char* name;
+    selectSensorConverter(format, &name)(source.data(), source.size(), format, target.data());
+}
@@ -0,0 +1,56 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#ifndef SENSOR_INGESTION_HPP
+#define SENSOR_INGESTION_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <bit>
+
+/*
+ * Integer types of the raw products of sensors. Both are stored on 16 bits.
+ */
+enum class SensorType {
+    UINT16,
+    INT16
+};
+
+/*
+ * Number of sentinel codes of a sensor format. Code `i` is mapped to the quiet NaN of payload `i`,
+ * which are the `UNKNOWN`, `CLOUD`, `LAND` and `NO_PASS` reasons in precedence order.
+ */
+#define NUM_SENSOR_REASONS 4
+
+/*
+ * Description of a raster of integers produced by a sensor. The `float` value of a code which is not a sentinel
+ * is `fma(code, scale, offset)` computed in single precision. The sentinel codes are values of the integer type
+ * (for example 65535 for an unsigned type or -32768 for a signed type). A sentinel which is outside the range
+ * of the integer type never matches, which allows to use fewer than `NUM_SENSOR_REASONS` sentinels.
+ */
+struct SensorFormat {
+    SensorType  type;
+    std::endian byteOrder;
+    float       scale;
+    float       offset;
+    int32_t     sentinels[NUM_SENSOR_REASONS];
+};
+
+/*
+ * Signature of the functions converting `count` codes of a sensor raster to `float` values with NaN payloads.
+ * Each function is specialized for the integer type and byte order of the format given to `selectSensorConverter(…)`.
+ */
+typedef void (*SensorConverter)(const uint16_t* source, size_t count, const SensorFormat& format, float* target);
+
+SensorConverter selectSensorConverter(const SensorFormat&, const char**);
+
+/*
+ * Converts the codes of a sensor raster to `float` values in a single pass: swapping of bytes if the byte order
+ * is not the native one, application of the scale and offset, and replacement of the sentinel codes by their NaN.
+ * The source is typically a file mapped in memory. The target shall have at least the length of the source.
+ */
+void ingest(const SensorFormat&, std::span<const uint16_t> source, std::span<float> target);
+
+#endif
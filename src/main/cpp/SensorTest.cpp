@@ -0,0 +1,170 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cstdio>
+#include <cmath>
+#include <chrono>
+#include <limits>
+#include <iostream>
+#include <algorithm>
+#include "SensorTest.hpp"
+
+/*
+ * The formats of the sensor rasters: unsigned integers in big-endian byte order with the sentinels at the top
+ * of the range, and signed integers in little-endian byte order with the sentinels at the bottom of the range.
+ * Both use a step of 1/256, so the conversion of the codes to `float` is exact.
+ */
+const SensorFormat SENSOR_FORMATS[NUM_SENSOR_FORMATS] = {
+    {SensorType::UINT16, std::endian::big,    0x1p-8f, -128.0f, {65532, 65533, 65534, 65535}},
+    {SensorType::INT16,  std::endian::little, 0x1p-8f,    0.0f, {-32768, -32767, -32766, -32765}}
+};
+const char* SENSOR_FILES[NUM_SENSOR_FORMATS] = {
+    "sensor-uint16.raw", "sensor-int16.raw"
+};
+
+/*
+ * Returns the code of the given sensor format for a value of the "nodata" raster, with bytes in the byte order of
+ * that format. The sentinel values of that raster are mapped to the sentinel codes of the same reason, and the other
+ * values are quantized to the nearest code. This is used by `NaN-generate` for writing the files of `SENSOR_FILES`.
+ */
+uint16_t encodeSensorValue(const SensorFormat& format, float value) {
+    int32_t code;
+    if (value >= MISSING_VALUE_THRESHOLD) {
+        code = format.sentinels[std::min((int) value - MISSING_VALUE_THRESHOLD, NUM_SENSOR_REASONS - 1)];
+    } else {
+        code = (int32_t) std::lround((value - (double) format.offset) / format.scale);
+        code = (format.type == SensorType::INT16)
+                ? std::clamp(code, (int32_t) std::numeric_limits<int16_t>::min(), (int32_t) std::numeric_limits<int16_t>::max())
+                : std::clamp(code, (int32_t) 0, (int32_t) std::numeric_limits<uint16_t>::max());
+    }
+    uint16_t bits = (uint16_t) code;
+    if (format.byteOrder != std::endian::native) {
+        bits = (uint16_t) ((bits << 8) | (bits >> 8));
+    }
+    return bits;
+}
+
+/*
+ * Returns the codes of the sensor raster in the format at the given index of `SENSOR_FORMATS`, with bytes in the
+ * byte order of that format. On the first call, the file named by `SENSOR_FILES` is mapped in memory without copy.
+ * If that file does not exist, the "nodata" raster is encoded in memory instead. Returns NULL if neither that file
+ * nor the raster can be read.
+ */
+const uint16_t* DataCache::sensorRaster(int format) {
+    MappedFile& mapped = sensorFiles[format];
+    std::vector<uint16_t>& copy = sensorCopies[format];
+    if (!mapped.data() && copy.empty()) {
+        const size_t length = (size_t) config.width * config.height;
+        if (!mapped.map(file(false, SENSOR_FILES[format]), length * sizeof(uint16_t), 1, arena, true)) {
+            const float* values = raster(false, std::endian::native, RasterLayout(config.width, config.height, 0));
+            if (!values) {
+                return NULL;
+            }
+            copy.resize(length);
+            for (size_t i=0; i<length; i++) {
+                copy[i] = encodeSensorValue(SENSOR_FORMATS[format], values[i]);
+            }
+        }
+    }
+    return mapped.data() ? reinterpret_cast<const uint16_t*>(mapped.data()) : copy.data();
+}
+
+
+
+/*
+ * Creates a new test which will convert the sensor raster in the format at the given index of `SENSOR_FORMATS`.
+ * The raster is used in row-major order and native byte order after conversion.
+ */
+TestNaNSensor::TestNaNSensor(Arena& arena, DataCache& cache, int sensorFormat)
+        : TestNaN(arena, cache, std::endian::native, 0)
+{
+    format        = sensorFormat;
+    converterName = "none";
+    ingestionTime = 0;
+}
+
+/*
+ * Converts the sensor raster, performs interpolations and compares against the expected values.
+ * This is the loop of `TestNaNSIMD::computeRange(…)` in a single thread, except that the points
+ * are moved with the expected values. The conversion time is included in the returned execution
+ * time (in nanoseconds), because an application would do this conversion for each raster it reads.
+ */
+double TestNaNSensor::computeAndCompare() {
+    std::chrono::time_point<std::chrono::high_resolution_clock> startTime, ingestedTime, endTime;
+    const SensorFormat& sensor = SENSOR_FORMATS[format];
+    const uint16_t* codes = cache.sensorRaster(format);
+    if (codes) {
+        double* coordinates = loadCoordinates();
+        if (coordinates) {
+            ExpectedResults expectedResults;
+            if (openExpectedResults(expectedResults, 0, config.numInterpolationPoints)) {
+                const int width     = config.width;
+                const int height    = config.height;
+                const int numPoints = config.numInterpolationPoints;
+                const size_t length = (size_t) width * height;
+                float* values = arena.allocate<float>(length);
+                SensorConverter converter = selectSensorConverter(sensor, &converterName);
+                double  results[SIMD_BATCH_SIZE];
+                int32_t reasons[SIMD_BATCH_SIZE];
+                uint64_t total[NUM_PERF_COUNTERS], snapshot[NUM_PERF_COUNTERS];
+                startTime = std::chrono::high_resolution_clock::now();
+                startCounters(total);
+                converter(codes, length, sensor, values);
+                ingestedTime = std::chrono::high_resolution_clock::now();
+                const Raster raster(values, width, height);
+                for (int it=0; it<config.numVerifiedIterations; it++) {
+                    startCounters(snapshot);
+                    const double* expectedResultCursor = expectedResults.next();
+                    if (!expectedResultCursor) {
+                        std::cout << "Cannot read the expected results of iteration " << it << ".\n";
+                        exit(1);
+                    }
+                    double stats = errorStatistics[it];
+                    for (int start=0; start < numPoints; start += SIMD_BATCH_SIZE) {
+                        auto batchStart  = startBatch();
+                        const int count  = std::min(SIMD_BATCH_SIZE, numPoints - start);
+                        double* xy = coordinates + 2*start;
+                        int valid = interpolate(raster, std::span(xy, 2*count), std::span(results, count), std::span(reasons, count));
+                        if (valid != count) {
+                            printf("Coordinates out of bounds: (%g, %g) for point %d.\n",
+                                   std::floor(xy[2*valid]), std::floor(xy[2*valid + 1]), start + valid);
+                            exit(1);
+                        }
+                        for (int i=0; i<count; i++) {
+                            double expected = *expectedResultCursor++;
+                            double nodata   = (reasons[i] - FIRST_QUIET_NAN) + MISSING_VALUE_THRESHOLD;
+                            verifyResult(isMissing(results[i]), nodata, results[i], expected, nodataMismatches[it], stats);
+                            double result = (expected >= MISSING_VALUE_THRESHOLD) ? 1.0 : expected;   // Same path as the reference.
+                            movePoint(xy + 2*i, result, width, height);
+                        }
+                        stopBatch(batchStart);
+                    }
+                    errorStatistics[it] = stats;
+                    stopCounters(snapshot, it);
+                }
+                stopCounters(total, config.numVerifiedIterations);
+                endTime = std::chrono::high_resolution_clock::now();
+                ingestionTime = duration_cast<std::chrono::nanoseconds>(ingestedTime - startTime).count();
+            }
+        }
+    }
+    return duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+/*
+ * Returns the quantization step of the sensor format. The rounding error of each value is at most half a step,
+ * and a bilinear interpolation does not increase that error, so the margin is for the rounding of the interpolation.
+ */
+double TestNaNSensor::tolerance() const {
+    return SENSOR_FORMATS[format].scale;
+}
+
+/*
+ * Prints the sensor format, the converter used and the time of the last conversion.
+ */
+void TestNaNSensor::printDetails() const {
+    double numBytes = (double) config.width * config.height * sizeof(uint16_t);
+    printf("Sensor raster: %s, converter: %s, conversion: %.3f ms (%.2f GB/s read)\n", SENSOR_FILES[format],
+           converterName, ingestionTime / 1E6, (ingestionTime > 0) ? numBytes / ingestionTime : 0.0);
+}
@@ -0,0 +1,51 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#ifndef SENSOR_TEST_HPP
+#define SENSOR_TEST_HPP
+
+#include "TestCase.hpp"
+#include "SensorIngestion.hpp"
+
+/*
+ * The formats of the sensor rasters read by `TestNaNSensor`, with the names of their files in the "nodata"
+ * sub-directory of the data directory. The array length is `NUM_SENSOR_FORMATS`. The values are quantized
+ * with a step of 1/256, which stores the values of the test between -100 and +100 in 16 bits.
+ * See `DataCache::sensorRaster(…)`.
+ */
+extern const SensorFormat SENSOR_FORMATS[NUM_SENSOR_FORMATS];
+extern const char* SENSOR_FILES[NUM_SENSOR_FORMATS];
+
+uint16_t encodeSensorValue(const SensorFormat&, float);
+
+/*
+ * Same calculation as `TestNaNSIMD` but with the raster converted from the integers of a sensor raster
+ * by `ingest(…)` before the first iteration. The conversion maps the sentinel codes to the NaN of their
+ * missing value reason, after which the vectorized kernels apply unchanged.
+ *
+ * The quantization of the sensor values causes rounding errors, so the results cannot be identical to the
+ * ones of `TestNodata` and the points are moved with the expected values instead of the interpolated ones,
+ * as in the `TestPolicy` variants with half-precision elements. The statistics are the rounding errors,
+ * and the test is successful if they do not exceed `tolerance()` and no missing value reason differs.
+ */
+class TestNaNSensor : public TestNaN {
+    /*
+     * Index of the format in `SENSOR_FORMATS`.
+     */
+    int format;
+
+    /*
+     * Name of the converter selected for the format and time of the last conversion, in nanoseconds.
+     */
+    const char* converterName;
+    double ingestionTime;
+
+    public:
+        TestNaNSensor(Arena& arena, DataCache& cache, int format);
+        double computeAndCompare();
+        double tolerance() const;
+        void   printDetails() const;
+};
+
+#endif
@@ -5,231 +5,545 @@
 #include <cstdint>
 #include <cstring>
 #include <fstream>
+#include <string>
 #include <iostream>
 #include <filesystem>
 #include <cmath>
+#include <bit>
 #include <chrono>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <future>
+#include <memory>
+#include <functional>
+#include "ByteOrder.hpp"
+#include "TestCase.hpp"
+#include "PagedRaster.hpp"
+#include "ResamplingTest.hpp"
+#include "SensorTest.hpp"
+#if defined(__unix__) || defined(__APPLE__)
+#define USE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 /*
- * The raster size, in pixels.
+ * The configuration of the tests. Shall not be modified after the command line has been parsed.
  */
-#define WIDTH  800
-#define HEIGHT 600
+Configuration config;
+
 
 /*
- * Number of points where to interpolate.
+ * Creates the layout of a raster of the given size. If `tileSize` is 0, the layout is row-major.
+ * Otherwise, `tileSize` shall be a power of 2.
  */
-#define NUM_INTERPOLATION_POINTS 20000
+RasterLayout::RasterLayout(int rasterWidth, int rasterHeight, int tileSize) {
+    width       = rasterWidth;
+    height      = rasterHeight;
+    tileShift   = (tileSize > 1) ? std::countr_zero((unsigned) tileSize) : 0;
+    tilesPerRow = (tileShift != 0) ? (width - 1 + tileSize - 1) / tileSize : 1;
+    rowStride   = (tileShift != 0) ? tileSize + 1 : width;
+}
 
 /*
- * Number of iterations for which we verify the conformance against expected results.
- * We verify a small number of iterations because the actual results diverge strongly
- * from the expected results after about 8 iterations, because of the intentionally
- * chaotic nature of the calculation.
+ * Returns the number of values in an array using this layout.
  */
-#define NUM_VERIFIED_ITERATIONS 10
+size_t RasterLayout::length() const {
+    if (tileShift == 0) {
+        return (size_t) width * height;
+    }
+    int tileSize    = 1 << tileShift;
+    int tilesPerCol = (height - 1 + tileSize - 1) / tileSize;
+    return (size_t) tilesPerRow * tilesPerCol * rowStride * rowStride;
+}
 
 /*
- * The threshold used for deciding if a value should be considered as a missing value
- * when using the "no data" sentinel values approach instead of IEEE 754 NaN values.
- * Any value greater than this threshold will be considered a missing value.
- *
- * Note that this strategy works only if all missing values are greater than all valid values.
- * Conversely, a strategy where all missing values are smaller than valid values would also work.
- * However, if the missing values can be anything (for example some of them smaller and some of
- * them greater than valid values), then the code would need to be more complex and slower.
+ * Creates a test case which will use the given data.
+ * The files to use depend on whether the subclass is testing NaN or "no data" sentinel values.
+ * If `tileSize` is not 0, the raster will be copied in tiles of that size after loading.
+ * All arrays are taken from the given arena, which shall not be reset while this test case is in use.
  */
-#define MISSING_VALUE_THRESHOLD 10000
+TestCase::TestCase(Arena& memory, DataCache& data, bool testNaN, std::endian testByteOrder, int tileSize)
+        : arena(memory), cache(data), layout(config.width, config.height, tileSize)
+{
+    useNaN               = testNaN;
+    byteOrder            = testByteOrder;
+    errorStatistics      = arena.allocate<double>(config.numVerifiedIterations, true);
+    nodataMismatches     = arena.allocate<int>   (config.numVerifiedIterations, true);
+    counters             = NULL;
+    counterValues        = NULL;
+    iterationLatencies   = NULL;
+    batchLatencies       = NULL;
+}
 
+/*
+ * Enables the measurement of the given hardware performance counters during `computeAndCompare()`,
+ * or disables the measurements if the argument is NULL. The counters shall be owned by the thread
+ * which will invoke `computeAndCompare()`.
+ */
+void TestCase::setCounters(PerfCounters* values) {
+    counters      = values;
+    counterValues = values ? arena.allocate<uint64_t>((config.numVerifiedIterations + 1) * NUM_PERF_COUNTERS, true) : NULL;
+}
 
 /*
- * Base class shared by the two test cases.
+ * Enables the recording of the duration of each iteration and of each batch of points in the given histograms,
+ * or disables the recording if the arguments are NULL. Only the variants computing the interpolations
+ * by batches in the current thread record the batches. The histograms shall not be shared between threads.
  */
-class TestCase {
-    /*
-     * Whether this test case uses NaN instead of "no data" sentinel values.
-     */
-    bool useNaN;
+void TestCase::setLatencyHistograms(LatencyHistogram* iterations, LatencyHistogram* batches) {
+    iterationLatencies = iterations;
+    batchLatencies     = batches;
+}
 
-    /*
-     * Path to a RAW file containing raster data as `float` values in an endianness specified by `byteOrder`.
-     * The raster size is WIDTH × HEIGHT pixels and the values are random `float` values between -100 and +100.
-     * The file contains random missing values identified by "no data" sentinel values or by NaN values,
-     * depending on which test is executed.
-     */
-    std::filesystem::path rasterFile;
+/*
+ * Reads the first `numBytes` bytes from the specified file into the given array.
+ * If `swapSize` is greater than 1, the byte order of each element of that size is reversed
+ * during the read. Returns whether the file has been found and all bytes have been read.
+ */
+bool readAllBytes(const std::filesystem::path& file, char* target, size_t numBytes, int swapSize) {
+    std::ifstream stream(file, std::ios_base::binary);
+    return stream.is_open() && readAndSwap(stream, target, numBytes, swapSize);
+}
 
-    /*
-     * Whether the values in the raster file are in big-endian or little-endian byte order.
-     */
-    std::endian byteOrder;
+/*
+ * Returns the number of bytes to swap for converting values from the given byte order to the native one.
+ * This is 1 (meaning no swap) if the given byte order is already the native one.
+ */
+int swapSize(std::endian byteOrder, int elementSize) {
+    return (byteOrder == std::endian::native) ? 1 : elementSize;
+}
 
-    /*
-     * Path to a RAW file containing pixel coordinates as {@code double} values in big-endian byte order.
-     * For simplicity, coordinates are from 0 inclusive to the width or height minus one, exclusive.
-     * This is for avoiding the need to check for bounds before bilinear interpolations.
-     */
-    std::filesystem::path coordinatesFile;
+/*
+ * Creates an initially empty file buffer.
+ */
+MappedFile::MappedFile() {
+    bytes  = NULL;
+    length = 0;
+    mapped = false;
+}
 
-    /**
-     * Path to a RAW file containing expected results as {@code double} values in big-endian byte order.
-     * This file may be large, so it is not loaded fully in memory. Missing results are represented by
-     * sentinel values only. NaNs are not used for avoiding any suspicion about test reliability.
-     */
-    std::filesystem::path expectedResultsFile;
+/*
+ * Releases the memory, if any.
+ */
+MappedFile::~MappedFile() {
+    unmap();
+}
 
-    protected:
-        /*
-         * Statistics about the differences between computed values and expected values.
-         * The array length is `NUM_VERIFIED_ITERATIONS`.
-         */
-        double* errorStatistics;
+/*
+ * Releases the memory used by the last file loaded by `map(…)`.
+ * This method does nothing if there is no file in memory, or if the file was copied in an arena
+ * (in which case the memory is released when the arena is reset).
+ */
+void MappedFile::unmap() {
+    #ifdef USE_MMAP
+    if (mapped) {
+        munmap(bytes, length);
+    }
+    #endif
+    bytes  = NULL;
+    mapped = false;
+}
 
+/*
+ * Loads the first `numBytes` bytes of the specified file, releasing the previously loaded file if any.
+ * If the file cannot be found or is shorter than `numBytes`, this method returns NULL. If `exactSize` is true,
+ * this method also returns NULL if the file is longer than `numBytes`, for rejecting rasters of another size.
+ *
+ * If `swapSize` is 1, the file is mapped in memory without copy. Otherwise, the byte order of each element
+ * of `swapSize` bytes is reversed while copying the file in an array taken from the given arena. The copy
+ * is done by chunks, and the pages of the file are released after each chunk, so that the memory used by
+ * the file and by its swapped copy is never more than the swapped copy plus one chunk.
+ */
+char* MappedFile::map(const std::filesystem::path& file, size_t numBytes, int swapSize, Arena& arena, bool exactSize) {
+    unmap();
+    #ifdef USE_MMAP
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat info;
+    void* address = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && (size_t) info.st_size >= numBytes && (!exactSize || (size_t) info.st_size == numBytes)) {
+        address = mmap(NULL, numBytes, (swapSize > 1) ? PROT_READ : PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);      // The mapping stays valid after the file is closed.
+    if (address == MAP_FAILED) {
+        return NULL;
+    }
+    if (swapSize <= 1) {
         /*
-         * Number of times where the "no data" values do not match the expected values.
-         * This value should be zero during the first iterations, and become non-zero only
-         * after the calculation has drifted. Note that the latter case is not an indication
-         * that NaN does no work: identical mismatches happen with the "no data" approach too.
+         * Random accesses need all pages anyway (the points cover the whole raster),
+         * so we ask the kernel to start reading them now instead of on first touch.
          */
-        int* nodataMismatches;
-
-        TestCase(bool, std::endian);
-        ~TestCase();
-        float*  loadRaster();
-        double* loadCoordinates();
-        double* loadExpectedResults();
-        bool    resultEquals(TestCase*);
-
-    public:
-        virtual double computeAndCompare() = 0;
-        bool    success();
-        void    printStatistics();
-};
-
+        madvise(address, numBytes, MADV_WILLNEED);
+        bytes  = static_cast<char*>(address);
+        mapped = true;
+    } else {
+        madvise(address, numBytes, MADV_SEQUENTIAL);
+        char* source = static_cast<char*>(address);
+        char* target = arena.allocate<char>(numBytes);
+        for (size_t position = 0; position < numBytes; position += SWAP_CHUNK_SIZE) {
+            size_t chunk = std::min((size_t) SWAP_CHUNK_SIZE, numBytes - position);
+            swapBytes(source + position, target + position, chunk, swapSize);
+            madvise(source + position, chunk, MADV_DONTNEED);
+        }
+        munmap(address, numBytes);
+        bytes = target;
+    }
+    #else
+    std::error_code error;
+    if (exactSize && std::filesystem::file_size(file, error) != numBytes) {
+        return NULL;
+    }
+    char* target = arena.allocate<char>(numBytes);
+    if (!readAllBytes(file, target, numBytes, swapSize)) {
+        return NULL;
+    }
+    bytes = target;
+    #endif
+    length = numBytes;
+    return bytes;
+}
 
 /*
- * Determines the paths to the files needed by the test.
- * The files to load depend on whether the subclass is testing NaN or "no data" sentinel values.
+ * Returns the path to the given file in the "nan" or "nodata" sub-directory of the data directory.
  */
-TestCase::TestCase(bool testNaN, std::endian testByteOrder) {
-    std::filesystem::path directory("../generated-data");
-    directory /= (testNaN ? "nan" : "nodata");
-    useNaN               = testNaN;
-    byteOrder            = testByteOrder;
-    rasterFile           = directory / (testByteOrder == std::endian::little ? "little-endian.raw" : "big-endian.raw");
-    coordinatesFile      = directory / "coordinates.raw";
-    expectedResultsFile  = directory / "expected-results.raw";
-    errorStatistics      = new double[NUM_VERIFIED_ITERATIONS];
-    nodataMismatches     = new int[NUM_VERIFIED_ITERATIONS];
-    memset(errorStatistics,  0, NUM_VERIFIED_ITERATIONS * sizeof(double));
-    memset(nodataMismatches, 0, NUM_VERIFIED_ITERATIONS * sizeof(int));
+std::filesystem::path DataCache::file(bool useNaN, const char* name) const {
+    return std::filesystem::path(config.dataDirectory) / (useNaN ? "nan" : "nodata") / name;
 }
 
 /*
- * Frees the memory allocated by this test case.
+ * Returns all floating-point values of the raster, loading them on the first call. If the file cannot be found,
+ * returns NULL. If the byte order (big-endian versus little-endian) is not the native byte order, the bytes are
+ * swapped. No replacement of NaN or "no data" value occurs, unless an encoder is specified. If the byte order is
+ * the native one, the returned array is the file mapped in memory without copy, unless a tiled layout or an encoder
+ * is requested. In the latter case, a copy is made on the first request for that layout and encoder (see `layout`
+ * for how to find a pixel in the array). The encoder, if non-null, is applied on all values of the copy.
  */
-TestCase::~TestCase() {
-    free(nodataMismatches);
-    free(errorStatistics);
+const float* DataCache::raster(bool useNaN, std::endian byteOrder, const RasterLayout& layout, ValueEncoder encoder) {
+    MappedFile& mapped = rasterFiles[useNaN][byteOrder == std::endian::big];
+    const char* bytes  = mapped.data();
+    if (!bytes) {
+        bytes = mapped.map(file(useNaN, (byteOrder == std::endian::little) ? "little-endian.raw" : "big-endian.raw"),
+                           (size_t) config.width * config.height * sizeof(float), swapSize(byteOrder, sizeof(float)),
+                           arena, true);
+    }
+    if (!bytes || (layout.tileShift == 0 && !encoder)) {
+        return reinterpret_cast<const float*>(bytes);
+    }
+    for (const DerivedRaster& copy : derivedRasters) {
+        if (copy.useNaN == useNaN && copy.byteOrder == byteOrder && copy.tileShift == layout.tileShift &&
+            copy.encoder == encoder && copy.converter == NULL)
+        {
+            return static_cast<const float*>(copy.values);
+        }
+    }
+    /*
+     * Copy the values in tiles, including the duplicated column and row at the right and bottom
+     * of each tile. Values are copied as integers for making clear that no FPU is involved.
+     * Pixels beyond the raster bounds are never read, but are initialized for determinism.
+     * In the row-major layout, this is a plain copy.
+     */
+    const int32_t* source = reinterpret_cast<const int32_t*>(bytes);
+    int32_t* copy   = arena.allocate<int32_t>(layout.length());
+    int32_t* target = copy;
+    if (layout.tileShift == 0) {
+        memcpy(copy, source, layout.length() * sizeof(int32_t));
+    } else {
+        int tileSize = 1 << layout.tileShift;
+        for (size_t tile = 0; tile < layout.length() / (layout.rowStride * layout.rowStride); tile++) {
+            int x0 = (tile % layout.tilesPerRow) * tileSize;
+            int y0 = (tile / layout.tilesPerRow) * tileSize;
+            for (int dy=0; dy<layout.rowStride; dy++) {
+                int y = std::min(y0 + dy, layout.height - 1);
+                for (int dx=0; dx<layout.rowStride; dx++) {
+                    int x = std::min(x0 + dx, layout.width - 1);
+                    *target++ = source[(size_t) y * layout.width + x];
+                }
+            }
+        }
+    }
+    float* values = reinterpret_cast<float*>(copy);
+    if (encoder) {
+        for (size_t i=0; i<layout.length(); i++) {
+            values[i] = encoder(values[i]);
+        }
+    }
+    derivedRasters.push_back({useNaN, byteOrder, layout.tileShift, encoder, NULL, values});
+    return values;
 }
 
 /*
- * Reads all bytes from the specified file. If the file cannot be found,
- * or if there is not enough memory left, this method returns NULL.
+ * Returns the raster values in native byte order converted to another element type of `elementSize` bytes.
+ * The conversion is done by the given function on the first request for that layout and converter, from the
+ * values returned by `raster(useNaN, std::endian::native, layout)`. If the file cannot be found, returns NULL.
  */
-char* readAllBytes(std::filesystem::path file, int numBytes) {
-    std::ifstream stream(file, std::ios_base::binary);
-    if (stream.is_open()) {
-        char* bytes = new char[numBytes];
-        if (bytes) {
-            stream.read(bytes, numBytes);
-            if (!stream.good()) {
-                free(bytes);
-                bytes = NULL;
-            }
+const void* DataCache::raster(bool useNaN, const RasterLayout& layout, ElementConverter converter, size_t elementSize) {
+    for (const DerivedRaster& copy : derivedRasters) {
+        if (copy.useNaN == useNaN && copy.tileShift == layout.tileShift && copy.converter == converter) {
+            return copy.values;
         }
-        stream.close();
-        return bytes;
     }
-    return NULL;
+    const float* source = raster(useNaN, std::endian::native, layout);
+    if (!source) {
+        return NULL;
+    }
+    void* values = arena.allocate(layout.length() * elementSize);
+    converter(source, values, layout.length());
+    derivedRasters.push_back({useNaN, std::endian::native, layout.tileShift, NULL, converter, values});
+    return values;
 }
 
 /*
- * Loads all floating-point values of the raster. If the file cannot be found, return NULL.
- * If the byte order (big-endian versus little-endian) is not the native byte order, this
- * method swaps the bytes. No replacement of NaN or "no data" value occurs.
+ * Returns the raster values in the given byte order, without swapping bytes. If the byte order is the native one,
+ * this is the same array as `raster(…)` in row-major layout. Otherwise, the returned array is the file mapped in
+ * memory without copy, and the caller is responsible for swapping the bytes of each value that it reads.
+ * If the file cannot be found, returns NULL.
  */
-float* TestCase::loadRaster() {
-    char* bytes = readAllBytes(rasterFile, WIDTH * HEIGHT * sizeof(float));
-    if (bytes && std::endian::native != byteOrder) {
-        uint32_t* p = (uint32_t*) bytes;
-        uint32_t* limit = p + WIDTH * HEIGHT;
-        do {
-            // There is probably a more efficient way to swap bytes in C/C++, but I didn't find it.
-            uint32_t v = *p;
-            *p =  (v >> 24)
-               | ((v <<  8) & 0x00FF0000)
-               | ((v >>  8) & 0x0000FF00)
-               |  (v << 24);
-        } while (++p < limit);
+const float* DataCache::rawRaster(bool useNaN, std::endian byteOrder) {
+    if (byteOrder == std::endian::native) {
+        return raster(useNaN, byteOrder, RasterLayout(config.width, config.height, 0));
+    }
+    MappedFile& mapped = rawRasterFiles[useNaN];
+    const char* bytes  = mapped.data();
+    if (!bytes) {
+        bytes = mapped.map(file(useNaN, (byteOrder == std::endian::little) ? "little-endian.raw" : "big-endian.raw"),
+                           (size_t) config.width * config.height * sizeof(float), 1, arena, true);
     }
-    return reinterpret_cast<float*>(bytes);
+    return reinterpret_cast<const float*>(bytes);
 }
 
 /*
- * If this system uses the litte-endian byte order, swaps bytes in the given array from big-endian.
- * The number of values must be greater than 0. This method does nothing if the given pointer is NULL.
+ * Returns the coordinate values, loading them on the first call. If the file cannot be found, returns NULL.
+ * Otherwise, bytes are swapped from big-endian to native byte order.
  */
-void toNativeByteOrder(uint64_t* p, int numValues) {
-    if (p && std::endian::native == std::endian::little) {
-        uint64_t* limit = p + numValues;
-        do {
-            // There is probably a more efficient way to swap bytes in C/C++, but I didn't find it.
-            uint64_t v = *p;
-            *p =  (v >> 56)
-               | ((v << 40) & 0x00FF000000000000)
-               | ((v << 24) & 0x0000FF0000000000)
-               | ((v <<  8) & 0x000000FF00000000)
-               | ((v >>  8) & 0x00000000FF000000)
-               | ((v >> 24) & 0x0000000000FF0000)
-               | ((v >> 40) & 0x000000000000FF00)
-               |  (v << 56);
-        } while (++p < limit);
+const double* DataCache::coordinates(bool useNaN) {
+    MappedFile& mapped = coordinatesFiles[useNaN];
+    const char* bytes  = mapped.data();
+    if (!bytes) {
+        bytes = mapped.map(file(useNaN, "coordinates.raw"), 2 * (size_t) config.numInterpolationPoints * sizeof(double),
+                           swapSize(std::endian::big, sizeof(double)), arena);
     }
+    return reinterpret_cast<const double*>(bytes);
 }
 
 /*
- * Loads coordinate values. If the file cannot be found, return NULL.
+ * Returns the expected values of all verified iterations, loading them on the first call.
+ * If the file cannot be found, or if it is larger than `EXPECTED_RESULTS_CACHE_LIMIT`, returns NULL.
  * Otherwise, bytes are swapped from big-endian to native byte order.
  */
+const double* DataCache::expectedResults(bool useNaN) {
+    size_t numBytes = (size_t) config.numVerifiedIterations * config.numInterpolationPoints * sizeof(double);
+    if (numBytes > EXPECTED_RESULTS_CACHE_LIMIT) {
+        return NULL;
+    }
+    MappedFile& mapped = expectedResultsFiles[useNaN];
+    const char* bytes  = mapped.data();
+    if (!bytes) {
+        bytes = mapped.map(file(useNaN, "expected-results.raw"), numBytes, swapSize(std::endian::big, sizeof(double)), arena);
+    }
+    return reinterpret_cast<const double*>(bytes);
+}
+
+/*
+ * Returns the raster in the compressed format, loading it on the first call from the "raster.nanz" file.
+ * If that file does not exist, the raster in native byte order is compressed in memory with tiles of
+ * `config.tileSize` pixels. Returns NULL if the raster cannot be found or if the compressed raster is
+ * invalid or does not have the expected size.
+ */
+const CompressedRaster* DataCache::compressedRaster(bool useNaN) {
+    CompressedRaster& compressed = compressedRasters[useNaN];
+    if (compressed.numTiles() == 0) {
+        std::filesystem::path path = file(useNaN, "raster.nanz");
+        std::error_code error;
+        size_t numBytes = std::filesystem::file_size(path, error);
+        const char* bytes = error ? NULL : compressedFiles[useNaN].map(path, numBytes, 1, arena);
+        if (!bytes) {
+            const float* values = raster(useNaN, std::endian::native, RasterLayout(config.width, config.height, 0));
+            if (!values) {
+                return NULL;
+            }
+            std::vector<uint8_t>& copy = compressedCopies[useNaN];
+            copy     = compressRaster(values, config.width, config.height, config.tileSize);
+            bytes    = reinterpret_cast<const char*>(copy.data());
+            numBytes = copy.size();
+        }
+        if (!compressed.attach(bytes, numBytes) || compressed.width != config.width || compressed.height != config.height) {
+            compressed = CompressedRaster();
+            return NULL;
+        }
+    }
+    return &compressed;
+}
+
+/*
+ * Returns the raster values shared by all test cases, in the layout of this test case.
+ * If the file cannot be found, returns NULL. The returned array shall not be modified.
+ */
+const float* TestCase::loadRaster() {
+    return cache.raster(useNaN, byteOrder, layout);
+}
+
+/*
+ * Returns a copy of the coordinate values in native byte order. If the file cannot be found, returns NULL.
+ * The array is modified by the tests, so a new copy of the values loaded by the first test case is returned
+ * on each call. Those changes are never written to the file.
+ */
 double* TestCase::loadCoordinates() {
-    char* bytes = readAllBytes(coordinatesFile, 2*NUM_INTERPOLATION_POINTS * sizeof(double));
-    toNativeByteOrder((uint64_t*) bytes, 2*NUM_INTERPOLATION_POINTS);
-    return reinterpret_cast<double*>(bytes);
+    const double* values = cache.coordinates(useNaN);
+    if (!values) {
+        return NULL;
+    }
+    size_t length = 2 * (size_t) config.numInterpolationPoints;
+    double* copy  = arena.allocate<double>(length);
+    memcpy(copy, values, length * sizeof(double));
+    return copy;
+}
+
+/*
+ * Creates a reader which is not yet associated to a file.
+ */
+ExpectedResults::ExpectedResults() {
+    firstPoint = 0;
+    numPoints  = 0;
+    iteration  = config.numVerifiedIterations;
+    values     = NULL;
+    buffers[0] = NULL;
+    buffers[1] = NULL;
+}
+
+/*
+ * Opens the file of expected results for reading the values of the points in the range from `first`
+ * inclusive to `first + count` exclusive. The first block is read immediately, so that the first call
+ * to `next()` does not wait. The two blocks are taken from the given arena.
+ * Returns whether the file has been opened and the first block read.
+ */
+bool ExpectedResults::open(const std::filesystem::path& file, int first, int count, Arena& arena) {
+    stream.open(file, std::ios_base::binary);
+    if (!stream.is_open()) {
+        return false;
+    }
+    firstPoint = first;
+    numPoints  = count;
+    buffers[0] = arena.allocate<double>(count);
+    buffers[1] = arena.allocate<double>(count);
+    if (!readBlock(0, buffers[0])) {
+        return false;
+    }
+    iteration = 0;
+    return true;
+}
+
+/*
+ * Uses expected values already in memory for returning the values of the points in the range from `first`
+ * inclusive to `first + count` exclusive. The given array shall contain all blocks of the file in native
+ * byte order, and shall not be modified or released while this reader is in use. Always returns `true`.
+ */
+bool ExpectedResults::open(const double* allValues, int first, int count) {
+    values     = allValues;
+    firstPoint = first;
+    numPoints  = count;
+    iteration  = 0;
+    return true;
+}
+
+/*
+ * Reads the values of the block at the given iteration into the given array.
+ * Bytes are swapped from big-endian to native byte order during the read.
+ */
+bool ExpectedResults::readBlock(int it, double* target) {
+    stream.seekg(((std::streamoff) it * config.numInterpolationPoints + firstPoint) * sizeof(double));
+    return readAndSwap(stream, reinterpret_cast<char*>(target), numPoints * sizeof(double),
+                       swapSize(std::endian::big, sizeof(double)));
+}
+
+/*
+ * Returns the expected values of the next iteration. The block returned by the previous call to this method
+ * becomes invalid, as its memory is reused for reading the block after the returned one. If the block could
+ * not be read, or if all iterations have already been returned, then this method returns NULL.
+ */
+const double* ExpectedResults::next() {
+    if (values) {
+        if (iteration >= config.numVerifiedIterations) {
+            return NULL;
+        }
+        return values + (size_t) (iteration++) * config.numInterpolationPoints + firstPoint;
+    }
+    if (iteration >= config.numVerifiedIterations || (iteration != 0 && !pending.get())) {
+        iteration = config.numVerifiedIterations;
+        return NULL;
+    }
+    const double* ready = buffers[iteration & 1];
+    if (++iteration < config.numVerifiedIterations) {
+        pending = std::async(std::launch::async, &ExpectedResults::readBlock, this, iteration, buffers[iteration & 1]);
+    }
+    return ready;
+}
+
+/*
+ * Opens the expected values for the points in the range from `first` inclusive to `first + count` exclusive.
+ * If the expected results are small enough for being kept in memory, the reader uses the values loaded by
+ * the first test case. Otherwise, this method differs from the Java implementation in that the next iteration
+ * is read in a background thread. Returns whether the file has been successfully opened.
+ */
+bool TestCase::openExpectedResults(ExpectedResults& reader, int first, int count) {
+    const double* values = cache.expectedResults(useNaN);
+    if (values) {
+        return reader.open(values, first, count);
+    }
+    return reader.open(cache.file(useNaN, "expected-results.raw"), first, count, arena);
 }
 
 /*
- * Loads all expected values. This method differs from the Java implementation,
- * which uses streaming in its `prepareNextVerification(...)` method.
- * For the C/C++ version, it was easier to just read everything.
+ * Returns the number of threads used by `computeAndCompare()`. This is 1 by default.
  */
-double* TestCase::loadExpectedResults() {
-    char* bytes = readAllBytes(expectedResultsFile, NUM_INTERPOLATION_POINTS * NUM_VERIFIED_ITERATIONS * sizeof(double));
-    toNativeByteOrder((uint64_t*) bytes, NUM_INTERPOLATION_POINTS * NUM_VERIFIED_ITERATIONS);
-    return reinterpret_cast<double*>(bytes);
+int TestCase::threadCount() const {
+    return 1;
+}
+
+/*
+ * Returns the maximal error tolerated by `success()`. If zero (the default), the results
+ * are expected to be identical to the ones of the reference test, except for the drift
+ * explained in `success()`. Otherwise, the results are not compared with the reference.
+ */
+double TestCase::tolerance() const {
+    return 0;
+}
+
+/*
+ * Returns the index in `createTestVariant(…)` of the variant having the results to which the results of this test
+ * are compared when `tolerance()` is zero. This is 0 by default, the reference having "no data" sentinel values.
+ * A variant returning its own index is itself a reference.
+ */
+int TestCase::referenceVariant() const {
+    return 0;
+}
+
+/*
+ * Prints information specific to a test variant after the statistics. The default implementation prints nothing.
+ */
+void TestCase::printDetails() const {
 }
 
 /*
  * Returns whether the test was successful.
- * The test is considered successful if the first iterations have no errors.
+ * The test is considered successful if the first `config.numStrictIterations` iterations have no errors.
  * A drift is tolerated in the last iterations because this test intentionally
  * uses chaotic algorithm in order to test the effect of optimizations enabled
  * by compiler options in the C/C++ variant of this test.
  */
 bool TestCase::success() {
-    for (int i=0; i<NUM_VERIFIED_ITERATIONS; i++) {
+    const double tolerance = this->tolerance();
+    for (int i=0; i<config.numVerifiedIterations; i++) {
+        if (tolerance != 0 && (nodataMismatches[i] != 0 || errorStatistics[i] > tolerance)) {
+            return false;
+        }
         if (nodataMismatches[i] != 0) {
-            if (i < 8) {
+            if (i < config.numStrictIterations) {
                 return false;
             }
         }
@@ -241,7 +555,7 @@ bool TestCase::success() {
  * Returns whether the results of another test are equal to the results of this test.
  */
 bool TestCase::resultEquals(TestCase* other) {
-    for (int i=0; i<NUM_VERIFIED_ITERATIONS; i++) {
+    for (int i=0; i<config.numVerifiedIterations; i++) {
         if (errorStatistics [i] != other->errorStatistics [i] ||
             nodataMismatches[i] != other->nodataMismatches[i])
         {
@@ -260,65 +574,53 @@ bool TestCase::resultEquals(TestCase* other) {
  */
 void TestCase::printStatistics() {
     std::cout << "Errors in the use of raster data with " << (useNaN ? "NaN" : "\"No data\" sentinel")
-              << " values in " << (byteOrder == std::endian::big ? "big" : "little") << "-endian byte order:\n"
-              << "    Maximum   Number of \"missing value\" mismatches\n";
-    for (int i=0; i<NUM_VERIFIED_ITERATIONS; i++) {
-        printf("%11.4f %6d\n", errorStatistics[i], nodataMismatches[i]);
+              << " values in " << (byteOrder == std::endian::big ? "big" : "little") << "-endian byte order"
+              << (layout.tileShift != 0 ? " and tiled layout" : "") << ":\n"
+              << "    Maximum   Number of \"missing value\" mismatches";
+    if (counters) {
+        for (int c=0; c<NUM_PERF_COUNTERS; c++) {
+            printf(" %14s", PERF_COUNTER_NAMES[c]);
+        }
     }
+    std::cout << '\n';
+    for (int i=0; i<=config.numVerifiedIterations; i++) {
+        if (i < config.numVerifiedIterations) {
+            printf("%11.4f %6d", errorStatistics[i], nodataMismatches[i]);
+        } else if (counters) {
+            printf("%11s %6s", "Total", "");
+        } else {
+            break;
+        }
+        if (counters) {
+            /*
+             * Align the counters after the header of the mismatches column. The counters of each iteration
+             * are not measured when the iterations are executed in many threads: only the total is known.
+             */
+            printf("%30s", "");
+            for (int c=0; c<NUM_PERF_COUNTERS; c++) {
+                if (!counters->available(c)) {
+                    printf(" %14s", "n/a");
+                } else if (i < config.numVerifiedIterations && threadCount() > 1) {
+                    printf(" %14s", "-");
+                } else {
+                    printf(" %14llu", (unsigned long long) counterValues[i * NUM_PERF_COUNTERS + c]);
+                }
+            }
+        }
+        std::cout << '\n';
+    }
+    printDetails();
 }
 
 
 
-/*
- * Returns the bit pattern of the given floating point number.
- * Equivalent to Java's `Float.floatToRawIntBits(float)`.
- *
- * Note: NaN values have a sign bit (we can have "negative" NaN), so we really need the signed type below.
- * The choice of signed or unsigned type changes the way that the `max` function will behave when checking
- * which NaN has precedence in this test.
- */
-inline int32_t floatToRawIntBits(float value) {
-    return std::bit_cast<int32_t>(value);
-}
-
-
-
-
-/*
- * Demonstrates that NaN values can be read and processed without any lost of information.
- * The calculation is a bilinear interpolation.
- */
-class TestNaN : public TestCase {
-    /*
-     * Value of the first positive quiet NaN.
-     */
-    const int32_t FIRST_QUIET_NAN = 0x7FC00000;
-
-    /*
-     * NaN bit pattern for a missing data. A value may be missing for different reasons, which are identified
-     * by different NaN values. This test uses the following values, in precedence order. For example,
-     * if a calculation involves two pixels missing for `CLOUD` and `LAND` reasons respectively,
-     * then the result will be considered missing for the `LAND` reason.
-     *
-     *   - Missing because the remote sensor didn't pass over that area.
-     *   - Missing because the pixel is on a land (assuming that the data are for some oceanographic phenomenon).
-     *   - Missing because of a cloud.
-     *   - Missing for an unknown reason.
-     */
-    const int32_t UNKNOWN = FIRST_QUIET_NAN,      // This is the default NaN value in Java.
-                  CLOUD   = FIRST_QUIET_NAN + 1,
-                  LAND    = FIRST_QUIET_NAN + 2,
-                  NO_PASS = FIRST_QUIET_NAN + 3;
-
-    public:
-        TestNaN(std::endian testByteOrder);
-        double computeAndCompare();
-};
-
 /*
  * Creates a new test which will use NaN values for identifying the missing values.
+ * The tile size is 0 for using the raster in row-major order as stored in the file.
  */
-TestNaN::TestNaN(std::endian testByteOrder) : TestCase(true, testByteOrder) {
+TestNaN::TestNaN(Arena& arena, DataCache& cache, std::endian testByteOrder, int tileSize)
+        : TestCase(arena, cache, true, testByteOrder, tileSize)
+{
 }
 
 /*
@@ -329,17 +631,26 @@ TestNaN::TestNaN(std::endian testByteOrder) : TestCase(true, testByteOrder) {
  */
 double TestNaN::computeAndCompare() {
     std::chrono::time_point<std::chrono::high_resolution_clock> startTime, endTime;
-    float* raster = loadRaster();
+    const float* raster = loadRaster();
     if (raster) {
         double* coordinates = loadCoordinates();
         if (coordinates) {
-            double* expectedResults = loadExpectedResults();
-            if (expectedResults) {
-                double* expectedResultCursor = expectedResults;
+            ExpectedResults expectedResults;
+            if (openExpectedResults(expectedResults, 0, config.numInterpolationPoints)) {
+                const int width  = config.width;
+                const int height = config.height;
+                uint64_t total[NUM_PERF_COUNTERS], snapshot[NUM_PERF_COUNTERS];
                 startTime = std::chrono::high_resolution_clock::now();
-                for (int it=0; it<NUM_VERIFIED_ITERATIONS; it++) {
+                startCounters(total);
+                for (int it=0; it<config.numVerifiedIterations; it++) {
+                    startCounters(snapshot);
+                    const double* expectedResultCursor = expectedResults.next();
+                    if (!expectedResultCursor) {
+                        std::cout << "Cannot read the expected results of iteration " << it << ".\n";
+                        exit(1);
+                    }
                     double stats = errorStatistics[it];
-                    for (int i=0; i<NUM_INTERPOLATION_POINTS; i++) {
+                    for (int i=0; i<config.numInterpolationPoints; i++) {
                         /*
                          * Get all sample values that we need for the bilinear interpolation.
                          * Variables starting with "v" are converted from `float` to `double`.
@@ -354,14 +665,14 @@ double TestNaN::computeAndCompare() {
                          * The following bound check is implicit in Java.
                          * We make it explicit in C/C++ for avoiding a core dump.
                          */
-                        int offset = WIDTH * ((int) yb) + ((int) xb);
-                        if (offset < 0 || offset >= (HEIGHT - 1) * WIDTH + (WIDTH - 1)) {
+                        int offset = layout.offset((int) xb, (int) yb);
+                        if (offset < 0) {
                             printf("Coordinates out of bounds: (%g, %g) for point %d.\n", xb, yb, i);
                             exit(1);
                         }
                         float v00 = raster[offset];
                         float v01 = raster[offset + 1];
-                        float v10 = raster[offset += WIDTH];
+                        float v10 = raster[offset += layout.rowStride];
                         float v11 = raster[offset + 1];
                         /*
                          * Apply bilinear interpolation. Contrarily to the `TestNodata` case, we compute
@@ -396,81 +707,283 @@ double TestNaN::computeAndCompare() {
                          *     if (missingValueReason >= FIRST_QUIET_NAN) { ... }
                          *
                          * This trick uses the fact that "positive" quiet NaNs are greater than all other IEEE 754
-                         * values when compared as signed integers.
+                         * values when compared as signed integers. This alternative is selected automatically
+                         * when the compiler defines `__FINITE_MATH_ONLY__` (see `isMissing(double)`).
                          */
-                        if (std::isnan(result)) {
+                        double nodata = 0;
+                        #if __FINITE_MATH_ONLY__ && !defined(NAN_FORCE_ISNAN)
+                        int32_t missingValueReason = std::max(
+                                std::max(floatToRawIntBits(v00), floatToRawIntBits(v01)),
+                                std::max(floatToRawIntBits(v10), floatToRawIntBits(v11)));
+                        const bool missing = (missingValueReason >= FIRST_QUIET_NAN);
+                        if (missing) {
+                        #else
+                        const bool missing = std::isnan(result);
+                        if (missing) {
                             int32_t missingValueReason = std::max(
                                     std::max(floatToRawIntBits(v00), floatToRawIntBits(v01)),
                                     std::max(floatToRawIntBits(v10), floatToRawIntBits(v11)));
+                        #endif
                             /*
                              * Convert the NaN pattern to the "no data" sentinel value used by `DataGenerator`.
                              * This step is not needed in an application using NaN. This test is doing that
                              * conversion only because we choose to store missing values as "no data" in the
                              * "expected-results.raw" file.
                              */
-                            double nodata = (missingValueReason - FIRST_QUIET_NAN) + MISSING_VALUE_THRESHOLD;
-                            if (nodata != *expectedResultCursor) {
-                                nodataMismatches[it]++;
-                            }
-                            result = 1;      // For moving to another position during the next iteration.
-                        } else {
-                            double expected = *expectedResultCursor;
-                            if (expected >= MISSING_VALUE_THRESHOLD) {
-                                nodataMismatches[it]++;
-                            } else {
-                                stats = std::max(stats, std::abs(result - expected));
-                            }
+                            nodata = (missingValueReason - FIRST_QUIET_NAN) + MISSING_VALUE_THRESHOLD;
                         }
-                        coordinates[ix] = std::fmod(std::abs(x + result), WIDTH  - 1);
-                        coordinates[iy] = std::fmod(std::abs(y + result), HEIGHT - 1);
-                        expectedResultCursor++;
+                        result = verifyResult(missing, nodata, result, *expectedResultCursor++, nodataMismatches[it], stats);
+                        movePoint(coordinates + ix, result, width, height);
                     }
                     errorStatistics[it] = stats;
+                    stopCounters(snapshot, it);
                 }
+                stopCounters(total, config.numVerifiedIterations);
                 endTime = std::chrono::high_resolution_clock::now();
-                free(expectedResults);
             }
-            free(coordinates);
         }
-        free(raster);
     }
     return duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
 }
 
 
 
+/*
+ * Creates a new test which will use NaN values and the fastest kernel available on this processor.
+ */
+TestNaNSIMD::TestNaNSIMD(Arena& arena, DataCache& cache, std::endian testByteOrder, int threads, bool sortPoints,
+                         bool packReasons, bool summarizeTiles, bool readCompressed)
+        : TestNaN(arena, cache, testByteOrder, 0)
+{
+    numThreads = std::max(threads, 1);
+    binning    = sortPoints;
+    packed     = packReasons;
+    summary    = summarizeTiles;
+    compressed = readCompressed;
+    source     = NULL;
+    decodedValues = NULL;
+    if (compressed) {
+        numThreads = 1;         // The tiles are decoded when first needed, which is not thread-safe.
+    }
+}
+
+/*
+ * Returns the number of threads in which the interpolation points are split.
+ */
+int TestNaNSIMD::threadCount() const {
+    return numThreads;
+}
 
 /*
- * Same calculation as `TestNaN` but using sentinel values.
- * Used only for comparison purposes (reference implementation).
+ * Returns the number of tiles of `config.tileSize` pixels used by `binPoints(…)`.
  */
-class TestNodata : public TestCase {
-    /*
-     * Sentinel value for a missing data. A value may be missing for different reasons, which are identified
-     * by different sentinel values. This test uses the following values, in precedence order. For example,
-     * if a calculation involves two pixels missing for `CLOUD` and `LAND` reasons respectively,
-     * then the result will be considered missing for the `LAND` reason.
-     *
-     *   - Missing because the remote sensor didn't pass over that area.
-     *   - Missing because the pixel is on a land (assuming that the data are for some oceanographic phenomenon).
-     *   - Missing because of a cloud.
-     *   - Missing for an unknown reason.
-     */
-    const float UNKNOWN = 10000,    // Shall be equal to MISSING_VALUE_THRESHOLD for this test.
-                CLOUD   = 10001,
-                LAND    = 10002,
-                NO_PASS = 10003;
-
-    public:
-        TestNodata(std::endian testByteOrder);
-        double computeAndCompare();
-        bool testAndCompare(double*, bool);
-};
+int TestNaNSIMD::numBins() const {
+    const RasterLayout tiles(config.width, config.height, config.tileSize);
+    return (int) (tiles.length() / (tiles.rowStride * tiles.rowStride));
+}
+
+/*
+ * Sorts the points in the range from `first` inclusive to `last` exclusive by the tile that contains them.
+ * This is a counting sort on the tile index computed from `(int) yb` and `(int) xb`, which preserves the
+ * order of points in the same tile. The first `last - first` elements of the `order` array receive the
+ * indices of the points in sorted order, and the `sorted` array receives their (x,y) coordinates in the
+ * same order. The `order` array is also used as a work space: its length shall be `2*(last - first)`
+ * plus `numBins() + 1`, and the length of `sorted` shall be `2*(last - first)`.
+ */
+void TestNaNSIMD::binPoints(const double* coordinates, int first, int last, int* order, double* sorted) {
+    const RasterLayout tiles(config.width, config.height, config.tileSize);
+    const int numBins = this->numBins();
+    int* bins   = order + (last - first);
+    int* starts = bins  + (last - first);
+    std::fill(starts, starts + numBins + 1, 0);
+    for (int i=first; i<last; i++) {
+        int x = (int) coordinates[2*i];
+        int y = (int) coordinates[2*i + 1];
+        int bin = (y >> tiles.tileShift) * tiles.tilesPerRow + (x >> tiles.tileShift);
+        bin = std::clamp(bin, 0, numBins - 1);      // Out of bounds points will be reported by the kernel.
+        bins[i - first] = bin;
+        starts[bin + 1]++;
+    }
+    for (int bin=0; bin<numBins; bin++) {
+        starts[bin + 1] += starts[bin];
+    }
+    for (int i=first; i<last; i++) {
+        int j = starts[bins[i - first]]++;
+        order [j]         = i;
+        sorted[2*j]       = coordinates[2*i];
+        sorted[2*j + 1]   = coordinates[2*i + 1];
+    }
+}
+
+/*
+ * Performs all iterations on the points in the range from `first` inclusive to `last` exclusive.
+ * The expected values of those points are read from the given reader, which shall have been opened
+ * for the same range. The statistics are stored in the `stats` and `mismatches` arrays of length
+ * `config.numVerifiedIterations` provided by the caller, for avoiding contention between threads on the
+ * `errorStatistics` and `nodataMismatches` arrays.
+ *
+ * If binning is enabled, the points are interpolated in the order computed by `binPoints(…)`.
+ * The permutation is used for finding the expected value and the coordinates to update for each result.
+ * The `order` and `sorted` arrays are the work space of `binPoints(…)`, ignored if binning is disabled.
+ */
+void TestNaNSIMD::computeRange(const Raster& raster, double* coordinates, ExpectedResults* expectedResults,
+                               int first, int last, double* stats, int* mismatches, int* order, double* sorted)
+{
+    double  results[SIMD_BATCH_SIZE];
+    int32_t reasons[SIMD_BATCH_SIZE];
+    uint8_t packedReasons[SIMD_BATCH_SIZE / REASONS_PER_BYTE];
+    const int width  = config.width;
+    const int height = config.height;
+    const bool measure = (numThreads == 1);     // The counters cannot be read by the workers.
+    uint64_t snapshot[NUM_PERF_COUNTERS];
+    for (int it=0; it<config.numVerifiedIterations; it++) {
+        if (measure) startCounters(snapshot);
+        const double* expectedResultCursor = expectedResults->next();
+        if (!expectedResultCursor) {
+            std::cout << "Cannot read the expected results of iteration " << it << ".\n";
+            exit(1);
+        }
+        if (binning) {
+            binPoints(coordinates, first, last, order, sorted);
+        }
+        double maxError = stats[it];
+        for (int start=0; start < last - first; start += SIMD_BATCH_SIZE) {
+            auto batchStart = startBatch();
+            const double* batch = binning ? &sorted[2*start] : coordinates + 2*(first + start);
+            int count = std::min(SIMD_BATCH_SIZE, last - first - start);
+            int numMissing = count;
+            if (compressed && source->decodeTouched(batch, count, decodedValues, decodedTiles) < 0) {
+                std::cout << "Invalid compressed raster.\n";
+                exit(1);
+            }
+            int valid = packed ? interpolatePacked(raster, std::span(batch, 2*count), std::span(results, count), std::span(packedReasons), &numMissing)
+                               : interpolate      (raster, std::span(batch, 2*count), std::span(results, count), std::span(reasons, count));
+            if (valid != count) {
+                printf("Coordinates out of bounds: (%g, %g) for point %d.\n",
+                        std::floor(batch[2*valid]), std::floor(batch[2*valid + 1]),
+                        binning ? order[start + valid] : first + start + valid);
+                exit(1);
+            }
+            for (int i=0; i<count; i++) {
+                int point = binning ? order[start + i] : first + start + i;
+                int ix = point << 1;
+                double result = results[i];
+                const bool missing = (numMissing != 0 && isMissing(result));
+                double nodata = 0;
+                if (missing) {
+                    int32_t payload = packed ? (packedReasons[i / REASONS_PER_BYTE] >> (2 * (i % REASONS_PER_BYTE))) & 3
+                                             : reasons[i] - FIRST_QUIET_NAN;
+                    nodata = payload + MISSING_VALUE_THRESHOLD;
+                }
+                result = verifyResult(missing, nodata, result, expectedResultCursor[point - first], mismatches[it], maxError);
+                movePoint(coordinates + ix, result, width, height);
+            }
+            if (measure) stopBatch(batchStart);
+        }
+        stats[it] = maxError;
+        if (measure) stopCounters(snapshot, it);
+    }
+}
+
+/*
+ * Reads the raster, performs interpolations and compares against the expected values.
+ * This method is equivalent to `TestNaN::computeAndCompare()`, except that the interpolations
+ * are computed by batches of `SIMD_BATCH_SIZE` points before being verified, and that the
+ * batches may be distributed over many threads. Each thread collects its own statistics,
+ * which are merged in `errorStatistics` and `nodataMismatches` after all threads finished.
+ * If the raster is compressed, each tile is decoded when first touched by a batch of points,
+ * and the decoding time is included in the returned execution time.
+ * It returns the execution time (in nanoseconds) of the numerical computation part.
+ */
+double TestNaNSIMD::computeAndCompare() {
+    std::chrono::time_point<std::chrono::high_resolution_clock> startTime, endTime;
+    const float* values;
+    if (compressed) {
+        source = cache.compressedRaster(true);
+        values = decodedValues = source ? arena.allocate<float>((size_t) config.width * config.height) : NULL;
+        decodedTiles.assign(source ? source->numTiles() : 0, 0);
+    } else {
+        values = loadRaster();
+    }
+    if (values) {
+        Raster raster(values, config.width, config.height);
+        if (summary) {
+            raster.summarize(RasterLayout(config.width, config.height, config.tileSize).tileShift);
+        }
+        double* coordinates = loadCoordinates();
+        if (coordinates) {
+            /*
+             * Give to each thread a range of points which is a multiple of the batch size,
+             * except for the last range. Consequently, the unequal number of points in the
+             * last batch is the only difference compared to the single-thread case.
+             * Each thread reads the expected values of its range with its own reader.
+             * All arrays are allocated here because the arena cannot be used by the workers.
+             */
+            const int numPoints     = config.numInterpolationPoints;
+            const int numIterations = config.numVerifiedIterations;
+            int numBatches = (numPoints + SIMD_BATCH_SIZE - 1) / SIMD_BATCH_SIZE;
+            int chunkSize  = ((numBatches + numThreads - 1) / numThreads) * SIMD_BATCH_SIZE;
+            std::vector<ExpectedResults> expectedResults(numThreads);
+            bool opened = true;
+            for (int t=0; t<numThreads; t++) {
+                int first = std::min(t * chunkSize, numPoints);
+                int last  = std::min(first + chunkSize, numPoints);
+                opened &= openExpectedResults(expectedResults[t], first, last - first);
+            }
+            if (opened) {
+                double* stats      = arena.allocate<double>(numThreads * numIterations, true);
+                int*    mismatches = arena.allocate<int>   (numThreads * numIterations, true);
+                int*    order      = NULL;
+                double* sorted     = NULL;
+                int orderLength    = 2 * chunkSize + numBins() + 1;
+                if (binning) {
+                    order  = arena.allocate<int>   (numThreads * (size_t) orderLength);
+                    sorted = arena.allocate<double>(numThreads * (size_t) chunkSize * 2);
+                }
+                uint64_t total[NUM_PERF_COUNTERS];
+                startTime = std::chrono::high_resolution_clock::now();
+                startCounters(total);
+                if (numThreads == 1) {
+                    computeRange(raster, coordinates, &expectedResults[0], 0, numPoints,
+                                 stats, mismatches, order, sorted);
+                } else {
+                    std::vector<std::thread> workers;
+                    for (int t=0; t<numThreads; t++) {
+                        int first = t * chunkSize;
+                        int last  = std::min(first + chunkSize, numPoints);
+                        if (first >= last) break;
+                        workers.emplace_back(&TestNaNSIMD::computeRange, this, std::cref(raster), coordinates, &expectedResults[t],
+                                             first, last, &stats[t * numIterations], &mismatches[t * numIterations],
+                                             binning ? &order [t * (size_t) orderLength] : NULL,
+                                             binning ? &sorted[t * (size_t) chunkSize * 2] : NULL);
+                    }
+                    for (std::thread& worker : workers) {
+                        worker.join();
+                    }
+                }
+                for (int t=0; t<numThreads; t++) {
+                    for (int it=0; it<numIterations; it++) {
+                        errorStatistics [it]  = std::max(errorStatistics[it], stats[t * numIterations + it]);
+                        nodataMismatches[it] += mismatches[t * numIterations + it];
+                    }
+                }
+                stopCounters(total, config.numVerifiedIterations);
+                endTime = std::chrono::high_resolution_clock::now();
+            }
+        }
+    }
+    return duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+
 
 /*
  * Creates a new test which will use "no data" sentinel values for identifying the missing values.
+ * The tile size is 0 for using the raster in row-major order as stored in the file.
  */
-TestNodata::TestNodata(std::endian testByteOrder) : TestCase(false, testByteOrder) {
+TestNodata::TestNodata(Arena& arena, DataCache& cache, std::endian testByteOrder, int tileSize)
+        : TestCase(arena, cache, false, testByteOrder, tileSize)
+{
 }
 
 /*
@@ -481,17 +994,26 @@ TestNodata::TestNodata(std::endian testByteOrder) : TestCase(false, testByteOrde
  */
 double TestNodata::computeAndCompare() {
     std::chrono::time_point<std::chrono::high_resolution_clock> startTime, endTime;
-    float* raster = loadRaster();
+    const float* raster = loadRaster();
     if (raster) {
         double* coordinates = loadCoordinates();
         if (coordinates) {
-            double* expectedResults = loadExpectedResults();
-            if (expectedResults) {
-                double* expectedResultCursor = expectedResults;
+            ExpectedResults expectedResults;
+            if (openExpectedResults(expectedResults, 0, config.numInterpolationPoints)) {
+                const int width  = config.width;
+                const int height = config.height;
+                uint64_t total[NUM_PERF_COUNTERS], snapshot[NUM_PERF_COUNTERS];
                 startTime = std::chrono::high_resolution_clock::now();
-                for (int it=0; it<NUM_VERIFIED_ITERATIONS; it++) {
+                startCounters(total);
+                for (int it=0; it<config.numVerifiedIterations; it++) {
+                    startCounters(snapshot);
+                    const double* expectedResultCursor = expectedResults.next();
+                    if (!expectedResultCursor) {
+                        std::cout << "Cannot read the expected results of iteration " << it << ".\n";
+                        exit(1);
+                    }
                     double stats = errorStatistics[it];
-                    for (int i=0; i<NUM_INTERPOLATION_POINTS; i++) {
+                    for (int i=0; i<config.numInterpolationPoints; i++) {
                         /*
                          * Get all sample values that we need for the bilinear interpolation.
                          * Variables starting with "v" are converted from `float` to `double`.
@@ -506,14 +1028,14 @@ double TestNodata::computeAndCompare() {
                          * The following bound check is implicit in Java.
                          * We make it explicit in C/C++ for avoiding a core dump.
                          */
-                        int offset = WIDTH * ((int) yb) + ((int) xb);
-                        if (offset < 0 || offset >= (HEIGHT - 1) * WIDTH + (WIDTH - 1)) {
+                        int offset = layout.offset((int) xb, (int) yb);
+                        if (offset < 0) {
                             printf("Coordinates out of bounds: (%g, %g) for point %d.\n", xb, yb, i);
                             exit(1);
                         }
                         float v00 = raster[offset];
                         float v01 = raster[offset + 1];
-                        float v10 = raster[offset += WIDTH];
+                        float v10 = raster[offset += layout.rowStride];
                         float v11 = raster[offset + 1];
                         double result;    // To be computed below.
                         /*
@@ -534,174 +1056,429 @@ double TestNodata::computeAndCompare() {
                         float missingValueReason = std::max(
                                 std::max(v00, v01),
                                 std::max(v10, v11));
-                        if (missingValueReason >= MISSING_VALUE_THRESHOLD) {
-                            if (missingValueReason != *expectedResultCursor) {
-                                nodataMismatches[it]++;
-                            }
-                            result = 1;      // For moving to another position during the next iteration.
-                        } else {
+                        const bool missing = (missingValueReason >= MISSING_VALUE_THRESHOLD);
+                        if (!missing) {
                             /*
-                             * Apply the bilinear interpolation and compare against the expected value.
+                             * Apply the bilinear interpolation only if all values are valid.
                              */
                             double xf = x - xb;
                             double yf = y - yb;
                             double v0 = std::fma(v01 - (double) v00, xf, v00);
                             double v1 = std::fma(v11 - (double) v10, xf, v10);
                             result = std::fma(v1 - v0, yf, v0);
-                            double expected = *expectedResultCursor;
-                            if (expected >= MISSING_VALUE_THRESHOLD) {
-                                nodataMismatches[it]++;
-                            } else {
-                                stats = std::max(stats, std::abs(result - expected));
-                            }
+                        } else {
+                            result = 0;     // Ignored.
                         }
-                        coordinates[ix] = std::fmod(std::abs(x + result), WIDTH  - 1);
-                        coordinates[iy] = std::fmod(std::abs(y + result), HEIGHT - 1);
-                        expectedResultCursor++;
+                        result = verifyResult(missing, missingValueReason, result, *expectedResultCursor++, nodataMismatches[it], stats);
+                        movePoint(coordinates + ix, result, width, height);
                     }
                     errorStatistics[it] = stats;
+                    stopCounters(snapshot, it);
                 }
+                stopCounters(total, config.numVerifiedIterations);
                 endTime = std::chrono::high_resolution_clock::now();
-                free(expectedResults);
             }
-            free(coordinates);
         }
-        free(raster);
     }
     return duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
 }
 
 /*
- * Run many variants of the tests (with "no data", with NaN).
- * The instance on which this method is invoked is taken as the reference.
- * It should be an instance using "no data" sentinel values, for avoiding
- * any doubt. This method returns whether the test was successful.
- */
-#define NUM_TEST_VARIANTS 4
-bool TestNodata::testAndCompare(double* executionTimes, bool printStatistics) {
-    TestNodata nodataLittleEndian(std::endian::little);
-    TestNaN    nanBigEndian      (std::endian::big);
-    TestNaN    nanLittleEndian   (std::endian::little);
-
-    bool success = true;
-    for (int t=0; t<NUM_TEST_VARIANTS; t++) {
-        TestCase *test;
-        switch (t) {
-            case 0:  test = this; break;
-            case 1:  test = &nodataLittleEndian; break;
-            case 2:  test = &nanBigEndian; break;
-            case 3:  test = &nanLittleEndian; break;
-            default: return false;      // Should never happen.
-        }
-        executionTimes[t] += test->computeAndCompare();
-        success &= test->success();
-        if (!resultEquals(test)) {
-            test->printStatistics();
-            success = false;
+ * Creates a new test which will use "no data" sentinel values without branch on the missing value check.
+ * The raster is used in row-major order as stored in the file.
+ */
+TestNodataBranchFree::TestNodataBranchFree(Arena& arena, DataCache& cache, std::endian testByteOrder)
+        : TestNodata(arena, cache, testByteOrder, 0)
+{
+}
+
+/*
+ * Reads the raster, performs interpolations and compares against the expected values.
+ * This method computes the same results as `TestNodata::computeAndCompare()`, but the
+ * bilinear interpolation is computed for all points, including the ones having a "no data"
+ * value. The missing value check only selects which value to keep. Likewise, the statistics
+ * are updated with integer additions and selected values instead of conditional statements.
+ * It returns the execution time (in nanoseconds) of the numerical computation part.
+ */
+double TestNodataBranchFree::computeAndCompare() {
+    std::chrono::time_point<std::chrono::high_resolution_clock> startTime, endTime;
+    const float* raster = loadRaster();
+    if (raster) {
+        double* coordinates = loadCoordinates();
+        if (coordinates) {
+            ExpectedResults expectedResults;
+            if (openExpectedResults(expectedResults, 0, config.numInterpolationPoints)) {
+                const int width  = config.width;
+                const int height = config.height;
+                uint64_t total[NUM_PERF_COUNTERS], snapshot[NUM_PERF_COUNTERS];
+                startTime = std::chrono::high_resolution_clock::now();
+                startCounters(total);
+                for (int it=0; it<config.numVerifiedIterations; it++) {
+                    startCounters(snapshot);
+                    const double* expectedResultCursor = expectedResults.next();
+                    if (!expectedResultCursor) {
+                        std::cout << "Cannot read the expected results of iteration " << it << ".\n";
+                        exit(1);
+                    }
+                    double stats = errorStatistics[it];
+                    int mismatches = nodataMismatches[it];
+                    for (int i=0; i<config.numInterpolationPoints; i++) {
+                        int ix = i << 1;
+                        int iy = ix | 1;
+                        double x  = coordinates[ix];
+                        double y  = coordinates[iy];
+                        double xb = std::floor(x);
+                        double yb = std::floor(y);
+                        int offset = layout.offset((int) xb, (int) yb);
+                        if (offset < 0) {
+                            printf("Coordinates out of bounds: (%g, %g) for point %d.\n", xb, yb, i);
+                            exit(1);
+                        }
+                        float v00 = raster[offset];
+                        float v01 = raster[offset + 1];
+                        float v10 = raster[offset += layout.rowStride];
+                        float v11 = raster[offset + 1];
+                        /*
+                         * Apply the bilinear interpolation unconditionally, as in `TestNaN`. If a value is missing,
+                         * the result is meaningless (a mix of sentinel values) but is not used. The maximal value is
+                         * computed for all points too, and the comparison with the threshold becomes a mask.
+                         */
+                        double xf = x - xb;
+                        double yf = y - yb;
+                        double v0 = std::fma(v01 - (double) v00, xf, v00);
+                        double v1 = std::fma(v11 - (double) v10, xf, v10);
+                        double interpolated = std::fma(v1 - v0, yf, v0);
+                        float missingValueReason = std::max(
+                                std::max(v00, v01),
+                                std::max(v10, v11));
+                        bool missing = (missingValueReason >= MISSING_VALUE_THRESHOLD);
+                        /*
+                         * Compare against the expected value. `verifyResult(…)` has no branch either: a mismatch
+                         * is either a different sentinel value if the result is missing, or an expected sentinel
+                         * value if the result is valid, and the error is zero if any of them is missing.
+                         */
+                        double result = verifyResult(missing, missingValueReason, interpolated, *expectedResultCursor++, mismatches, stats);
+                        movePoint(coordinates + ix, result, width, height);
+                    }
+                    errorStatistics [it] = stats;
+                    nodataMismatches[it] = mismatches;
+                    stopCounters(snapshot, it);
+                }
+                stopCounters(total, config.numVerifiedIterations);
+                endTime = std::chrono::high_resolution_clock::now();
+            }
         }
     }
-    if (success && printStatistics) {
-        nanLittleEndian.printStatistics();
+    return duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+/*
+ * Creates a test case for the convention of missing values given by the policy,
+ * with the raster read in the given byte order. The tiled layout is not used.
+ */
+template<class Policy, std::endian ORDER>
+TestPolicy<Policy, ORDER>::TestPolicy(Arena& arena, DataCache& cache)
+        : TestCase(arena, cache, Policy::USE_NAN, ORDER, 0)
+{
+}
+
+/*
+ * Returns the rounding error tolerated by the element type, or 0 if the values are stored exactly.
+ */
+template<class Policy, std::endian ORDER>
+double TestPolicy<Policy, ORDER>::tolerance() const {
+    return ElementType<Element>::TOLERANCE;
+}
+
+/*
+ * Reads the raster, performs interpolations and compares against the expected values.
+ * This is the loop of `TestNodataBranchFree::computeAndCompare()` with the missing value
+ * checks delegated to the policy, with the bytes of samples swapped after each load
+ * if the byte order is not the native one, and with the elements converted to `float`
+ * or `double` after each load if they are not of one of those types.
+ * It returns the execution time (in nanoseconds) of the numerical computation part.
+ */
+template<class Policy, std::endian ORDER>
+double TestPolicy<Policy, ORDER>::computeAndCompare() {
+    typedef typename Policy::Reason Reason;
+    typedef ElementType<Element> Type;
+    std::chrono::time_point<std::chrono::high_resolution_clock> startTime, endTime;
+    const Element* raster;
+    if constexpr (!std::is_same_v<Element, float>) {
+        raster = static_cast<const Element*>(cache.raster(Policy::USE_NAN, layout, convertElements<Element>, sizeof(Element)));
+    } else if constexpr (ORDER == std::endian::native) {
+        raster = cache.raster(Policy::USE_NAN, ORDER, layout, Policy::ENCODER);
+    } else {
+        raster = cache.rawRaster(Policy::USE_NAN, ORDER);
     }
-    return success;
+    if (raster) {
+        double* coordinates = loadCoordinates();
+        if (coordinates) {
+            ExpectedResults expectedResults;
+            if (openExpectedResults(expectedResults, 0, config.numInterpolationPoints)) {
+                const int width  = config.width;
+                const int height = config.height;
+                uint64_t total[NUM_PERF_COUNTERS], snapshot[NUM_PERF_COUNTERS];
+                startTime = std::chrono::high_resolution_clock::now();
+                startCounters(total);
+                for (int it=0; it<config.numVerifiedIterations; it++) {
+                    startCounters(snapshot);
+                    const double* expectedResultCursor = expectedResults.next();
+                    if (!expectedResultCursor) {
+                        std::cout << "Cannot read the expected results of iteration " << it << ".\n";
+                        exit(1);
+                    }
+                    double stats = errorStatistics[it];
+                    int mismatches = nodataMismatches[it];
+                    for (int i=0; i<config.numInterpolationPoints; i++) {
+                        int ix = i << 1;
+                        int iy = ix | 1;
+                        double x  = coordinates[ix];
+                        double y  = coordinates[iy];
+                        double xb = std::floor(x);
+                        double yb = std::floor(y);
+                        int offset = layout.offset((int) xb, (int) yb);
+                        if (offset < 0) {
+                            printf("Coordinates out of bounds: (%g, %g) for point %d.\n", xb, yb, i);
+                            exit(1);
+                        }
+                        Element e00 = load<ORDER>(raster + offset);
+                        Element e01 = load<ORDER>(raster + offset + 1);
+                        Element e10 = load<ORDER>(raster + (offset += layout.rowStride));
+                        Element e11 = load<ORDER>(raster + offset + 1);
+                        typename Type::Value v00 = Type::value(e00);
+                        typename Type::Value v01 = Type::value(e01);
+                        typename Type::Value v10 = Type::value(e10);
+                        typename Type::Value v11 = Type::value(e11);
+                        double xf = x - xb;
+                        double yf = y - yb;
+                        double v0 = std::fma(v01 - (double) v00, xf, v00);
+                        double v1 = std::fma(v11 - (double) v10, xf, v10);
+                        double interpolated = std::fma(v1 - v0, yf, v0);
+                        Reason missingValueReason = Policy::precedence(
+                                Policy::precedence(Policy::reason(e00), Policy::reason(e01)),
+                                Policy::precedence(Policy::reason(e10), Policy::reason(e11)));
+                        bool missing = Policy::isMissing(missingValueReason);
+                        double expected = *expectedResultCursor++;
+                        double result = verifyResult(missing, Policy::toNodata(missingValueReason), interpolated, expected, mismatches, stats);
+                        if constexpr (!Type::EXACT) {
+                            result = (expected >= MISSING_VALUE_THRESHOLD) ? 1.0 : expected;    // Same path as the reference.
+                        }
+                        movePoint(coordinates + ix, result, width, height);
+                    }
+                    errorStatistics [it] = stats;
+                    nodataMismatches[it] = mismatches;
+                    stopCounters(snapshot, it);
+                }
+                stopCounters(total, config.numVerifiedIterations);
+                endTime = std::chrono::high_resolution_clock::now();
+            }
+        }
+    }
+    return duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
 }
 
+/*
+ * Labels of the test variants for human reading, and identifiers used as benchmark names.
+ * Arrays are in the order of the `variant` argument of `createTestVariant(…)`.
+ */
+const char* TEST_VARIANT_NAMES[NUM_TEST_VARIANTS] = {
+    "\"no data\":", "\"no data\":", "NaN values:", "NaN values:", "NaN + SIMD:", "NaN + threads:",
+    "\"no data\" tiled:", "NaN tiled:", "NaN + binning:", "\"no data\" branch-free:",
+    "NaN policy:", "NaN policy:", "\"no data\" policy:", "\"no data\" policy:",
+    "\"no data\" below policy:", "\"no data\" mixed policy:", "NaN double:", "NaN half:", "NaN bfloat16:",
+    "NaN + packed reasons:", "NaN + tile summary:", "NaN + compressed tiles:",
+    "NaN paged:", "NaN paged + binning:",
+    "\"no data\" nearest:", "NaN nearest:", "NaN + SIMD nearest:",
+    "\"no data\" bicubic:", "NaN bicubic:", "NaN + SIMD bicubic:",
+    "\"no data\" Lanczos:", "NaN Lanczos:", "NaN + SIMD Lanczos:",
+    "NaN + SIMD uint16 sensor:", "NaN + SIMD int16 sensor:"
+};
+const char* TEST_VARIANT_IDS[NUM_TEST_VARIANTS] = {
+    "TestNodata/big-endian", "TestNodata/little-endian", "TestNaN/big-endian", "TestNaN/little-endian",
+    "TestNaNSIMD/vectorized", "TestNaNSIMD/threads", "TestNodata/tiled", "TestNaN/tiled", "TestNaNSIMD/binning",
+    "TestNodata/branch-free", "TestPolicy/nan", "TestPolicy/nan-big-endian", "TestPolicy/sentinel-above",
+    "TestPolicy/sentinel-above-big-endian", "TestPolicy/sentinel-below", "TestPolicy/sentinel-mixed-sign",
+    "TestPolicy/nan-double", "TestPolicy/nan-half", "TestPolicy/nan-bfloat16",
+    "TestNaNSIMD/packed-reasons", "TestNaNSIMD/tile-summary", "TestNaNSIMD/compressed",
+    "TestNaN/paged", "TestNaN/paged-binned",
+    "TestNodata/nearest", "TestNaN/nearest", "TestNaNSIMD/nearest",
+    "TestNodata/bicubic", "TestNaN/bicubic", "TestNaNSIMD/bicubic",
+    "TestNodata/lanczos", "TestNaN/lanczos", "TestNaNSIMD/lanczos",
+    "TestNaNSIMD/sensor-uint16", "TestNaNSIMD/sensor-int16"
+};
 
 /*
- * Helper method for diagnostic before test in the main method.
+ * Creates the test case of the given variant, from 0 inclusive to `NUM_TEST_VARIANTS` exclusive.
+ * The caller is responsible for deleting the returned test case before the arena is reset.
+ * Variant 0 is the reference implementation with "no data" sentinel values in big-endian byte order.
+ * The variants from `FIRST_RESAMPLING_VARIANT` use other interpolation methods, with their own references.
  */
-void printNaNSupport(const char* functionName, double result) {
-    printf("Test support in %-6s %f\n", functionName, result);
+TestCase* createTestVariant(int variant, Arena& arena, DataCache& cache) {
+    switch (variant) {
+        case 0:  return new TestNodata (arena, cache, std::endian::big,    0);
+        case 1:  return new TestNodata (arena, cache, std::endian::little, 0);
+        case 2:  return new TestNaN    (arena, cache, std::endian::big,    0);
+        case 3:  return new TestNaN    (arena, cache, std::endian::little, 0);
+        case 4:  return new TestNaNSIMD(arena, cache, std::endian::little, 1, false);
+        case 5:  return new TestNaNSIMD(arena, cache, std::endian::little, std::thread::hardware_concurrency(), false);
+        case 6:  return new TestNodata (arena, cache, std::endian::little, config.tileSize);
+        case 7:  return new TestNaN    (arena, cache, std::endian::little, config.tileSize);
+        case 8:  return new TestNaNSIMD(arena, cache, std::endian::little, 1, true);
+        case 9:  return new TestNodataBranchFree(arena, cache, std::endian::little);
+        case 10: return new TestPolicy<NaNPayloadPolicy<float>,    std::endian::little>(arena, cache);
+        case 11: return new TestPolicy<NaNPayloadPolicy<float>,    std::endian::big>   (arena, cache);
+        case 12: return new TestPolicy<SentinelAbovePolicy,        std::endian::little>(arena, cache);
+        case 13: return new TestPolicy<SentinelAbovePolicy,        std::endian::big>   (arena, cache);
+        case 14: return new TestPolicy<SentinelBelowPolicy,        std::endian::native>(arena, cache);
+        case 15: return new TestPolicy<SentinelMixedSignPolicy,    std::endian::native>(arena, cache);
+        case 16: return new TestPolicy<NaNPayloadPolicy<double>,   std::endian::native>(arena, cache);
+        case 17: return new TestPolicy<NaNPayloadPolicy<Half>,     std::endian::native>(arena, cache);
+        case 18: return new TestPolicy<NaNPayloadPolicy<BFloat16>, std::endian::native>(arena, cache);
+        case 19: return new TestNaNSIMD(arena, cache, std::endian::little, 1, false, true);
+        case 20: return new TestNaNSIMD(arena, cache, std::endian::little, 1, true,  false, true);
+        case 21: return new TestNaNSIMD(arena, cache, std::endian::little, 1, false, false, false, true);
+        case 22: return new TestNaNPaged(arena, cache, std::endian::big, false);
+        case 23: return new TestNaNPaged(arena, cache, std::endian::little, true);
+        case 24: return new TestNodataResampled(arena, cache, InterpolationMethod::NEAREST);
+        case 25: return new TestNaNResampled   (arena, cache, InterpolationMethod::NEAREST, false);
+        case 26: return new TestNaNResampled   (arena, cache, InterpolationMethod::NEAREST, true);
+        case 27: return new TestNodataResampled(arena, cache, InterpolationMethod::BICUBIC);
+        case 28: return new TestNaNResampled   (arena, cache, InterpolationMethod::BICUBIC, false);
+        case 29: return new TestNaNResampled   (arena, cache, InterpolationMethod::BICUBIC, true);
+        case 30: return new TestNodataResampled(arena, cache, InterpolationMethod::LANCZOS);
+        case 31: return new TestNaNResampled   (arena, cache, InterpolationMethod::LANCZOS, false);
+        case 32: return new TestNaNResampled   (arena, cache, InterpolationMethod::LANCZOS, true);
+        case 33: return new TestNaNSensor(arena, cache, 0);
+        case 34: return new TestNaNSensor(arena, cache, 1);
+        default: return NULL;
+    }
 }
 
 /*
- * Helper method for testing `std::nanf(const char*)` in the main method.
+ * Returns whether the given variant shall be executed by the tests and the benchmark with the current configuration.
+ * The variants of the other interpolation methods are skipped if their expected results, which are computed in memory,
+ * would be larger than `EXPECTED_RESULTS_CACHE_LIMIT`.
  */
-void testDistinctNaN(const char* tagp) {
-    float value = std::nanf(tagp);
-    printf("%-8s isNaN=%s, bits=%8x\n", tagp, std::isnan(value) ? "true" : "false", floatToRawIntBits(value));
+bool isVariantEnabled(int variant) {
+    if (variant >= FIRST_RESAMPLING_VARIANT && variant < FIRST_RESAMPLING_VARIANT + 3 * NUM_INTERPOLATION_METHODS) {
+        return (size_t) config.numVerifiedIterations * config.numInterpolationPoints * sizeof(double)
+                <= EXPECTED_RESULTS_CACHE_LIMIT;
+    }
+    return variant != THRASHING_VARIANT || config.thrashing;
 }
 
 /*
- * Test the support of NaN in a few mathematical functions, then run the test.
+ * Run many variants of the tests (with "no data", with NaN).
+ * The instance on which this method is invoked is taken as the reference.
+ * It should be an instance using "no data" sentinel values, for avoiding
+ * any doubt. The variants having another reference (see `referenceVariant()`)
+ * are compared with that reference instead, which is kept until the end.
+ * This method returns whether the test was successful. A variant which computes nothing,
+ * for example because a data file is missing or does not match the options, is a failure.
+ * This method does not measure execution times: see the benchmark for that purpose.
+ * If `counters` is non-null, the hardware performance counters are measured and the
+ * statistics of all variants are printed together with the counter values.
  */
-int main() {
-    float n = rand();
-    printNaNSupport("+:",     n + NAN);
-    printNaNSupport("-:",     n - NAN);
-    printNaNSupport("*:",     n * NAN);
-    printNaNSupport("/:",     n / NAN);
-    printNaNSupport("sin:",   std::sin  (NAN));
-    printNaNSupport("cos:",   std::cos  (NAN));
-    printNaNSupport("tan:",   std::tan  (NAN));
-    printNaNSupport("asin:",  std::asin (NAN));
-    printNaNSupport("acos:",  std::acos (NAN));
-    printNaNSupport("atan:",  std::atan (NAN));
-    printNaNSupport("atan2:", std::atan2(NAN, 1));
-    printNaNSupport("floor:", std::floor(NAN));
-    printNaNSupport("ceil:",  std::ceil (NAN));
-    printNaNSupport("trunc:", std::trunc(NAN));
-    printNaNSupport("pow:",   std::pow  (NAN, 2));
-    printNaNSupport("sqrt:",  std::sqrt (NAN));
-    printNaNSupport("hypot:", std::hypot(NAN, 3));
-    printf("Test support in %-6s %s\n", "isnan:", std::isnan(n + NAN) ? "ok" : "FAIL");
-    #ifdef __FAST_MATH__
-    std::cout << "Fast math option detected.\n";
-    #endif
-    /*
-     * Bonus: the C++ 11 standard has methods for creating distincts quiet NaN values,
-     * and even for parsing them from character strings.
-     */
-    std::cout << '\n';
-    std::cout << "Test the std::nanf(char*) function from C++ 11 standard:\n";
-    testDistinctNaN("cloud");
-    testDistinctNaN("land");
-    testDistinctNaN("no_pass");
-    testDistinctNaN("1");
-    testDistinctNaN("2");
-    testDistinctNaN("35");
-    testDistinctNaN("400");
-    printf("%s bits=%8x\n", "strtof(\"NAN(cloud)\"):", floatToRawIntBits(std::strtof("NAN(cloud)", NULL)));
-    printf("%s bits=%8x\n", "strtof(\"NAN(2)\"):",     floatToRawIntBits(std::strtof("NAN(2)", NULL)));
-    std::cout << '\n';
-    /*
-     * The test loading a RAW file. The same tests are executed many times
-     * in order to perform time measurements.
-     */
-    const int numIterations = 20;
-    double executionTimes[NUM_TEST_VARIANTS * numIterations];
-    memset(executionTimes, 0, NUM_TEST_VARIANTS * numIterations * sizeof(double));
-    for (int it = numIterations; --it >= 0;) {
-        TestNodata test(std::endian::big);
-        if (!test.testAndCompare(executionTimes + it*NUM_TEST_VARIANTS, it == 0)) {
-            std::cout << "TEST FAILURE.\n";
-            return 1;
+bool TestNodata::testAndCompare(bool printStatistics, PerfCounters* counters) {
+    std::vector<std::unique_ptr<TestCase>> tests(NUM_TEST_VARIANTS);
+    setCounters(counters);
+    if (computeAndCompare() <= 0) {
+        std::cout << TEST_VARIANT_IDS[0] << ": nothing computed (are the data files present and matching the options?)\n";
+        return false;
+    }
+    bool success = this->success();
+    if (counters) {
+        std::cout << TEST_VARIANT_IDS[0] << '\n';
+        this->printStatistics();
+        std::cout << '\n';
+    }
+    for (int t=1; t<NUM_TEST_VARIANTS; t++) {
+        if (!isVariantEnabled(t)) {
+            continue;
+        }
+        tests[t].reset(createTestVariant(t, arena, cache));
+        TestCase* test = tests[t].get();
+        test->setCounters(counters);
+        if (test->computeAndCompare() <= 0) {
+            std::cout << TEST_VARIANT_IDS[t] << ": nothing computed (are the data files present and matching the options?)\n";
+            success = false;
+            continue;
+        }
+        success &= test->success();
+        const int r = test->referenceVariant();
+        TestCase* reference = (r == 0) ? this : tests[r].get();
+        if (test->tolerance() == 0 && r != t && !reference->resultEquals(test)) {
+            std::cout << "Results of " << TEST_VARIANT_IDS[t] << " differ from the reference " << TEST_VARIANT_IDS[r] << ":\n";
+            test->printStatistics();
+            success = false;
+        } else if (counters) {
+            std::cout << TEST_VARIANT_IDS[t] << '\n';
+            test->printStatistics();
+            std::cout << '\n';
         }
     }
-    std::cout << "Success (mismatches in the last iterations are normal).\n";
-    /*
-     * Compute average execution time together with standard deviations.
-     * The standard deviations are necessary for determining if the effect
-     * of a compiler option is only noise.
-     */
-    for (int t=0; t<NUM_TEST_VARIANTS; t++) {
-        double mean = 0;
-        for (int it=0; it<numIterations; it++) {
-            mean += executionTimes[it*NUM_TEST_VARIANTS + t];
+    if (success && printStatistics && !counters) {
+        tests[3]->printStatistics();
+    }
+    return success;
+}
+
+
+/*
+ * Parses the command-line options. Recognized options are `--width=…`, `--height=…`, `--points=…`,
+ * `--iterations=…`, `--strict=…`, `--tile=…`, `--cache-tiles=…`, `--data=…`, `--thrashing` and `--perf`.
+ * Options not specified on the command line keep their default values.
+ * Returns `false` if an option is not recognized or has an invalid value, after printing a message
+ * with the usage of the program named by `argv[0]`.
+ */
+bool Configuration::parse(int argc, char** argv) {
+    for (int i=1; i<argc; i++) {
+        const char* arg = argv[i];
+        const char* value = strchr(arg, '=');
+        if (strcmp(arg, "--perf") == 0) {
+            perfCounters = true;
+            continue;
         }
-        mean /= numIterations;
-        double variance = 0;
-        for (int it=0; it<numIterations; it++) {
-            double d = executionTimes[it*NUM_TEST_VARIANTS + t] - mean;
-            variance += d*d;
+        if (strcmp(arg, "--thrashing") == 0) {
+            thrashing = true;
+            continue;
         }
-        variance = std::sqrt(variance / (numIterations - 1));
-        printf("Execution time width %-12s %5.3f +/- %6.3f milliseconds.\n",
-                (t < NUM_TEST_VARIANTS/2) ? "\"no data\":" : "NaN values:",
-                mean / 1E+6, variance / 1E+6);
-    }
-    std::cout << "Note: differences in execution times are not necessarily because of NaNs,\n"
-              << "because the branch testing NaN intentionally performs more interpolations.\n"
-              << '\n';
-    return 0;
+        if (value) {
+            std::string name(arg, value++ - arg);
+            int* target  = NULL;
+            int  minimum = 2;
+            if      (name == "--width")       target = &width;
+            else if (name == "--height")      target = &height;
+            else if (name == "--points")     {target = &numInterpolationPoints; minimum = 1;}
+            else if (name == "--iterations")  target = &numVerifiedIterations;
+            else if (name == "--strict")     {target = &numStrictIterations;    minimum = 0;}
+            else if (name == "--tile")        target = &tileSize;
+            else if (name == "--cache-tiles") target = &cacheTiles;
+            else if (name == "--data") {
+                dataDirectory = value;
+                continue;
+            }
+            if (target) {
+                char* end;
+                long n = strtol(value, &end, 10);
+                if (*end == 0 && n >= minimum && n <= 1000000000
+                        && (target != &tileSize || std::has_single_bit((unsigned long) n)))
+                {
+                    *target = (int) n;
+                    continue;
+                }
+            }
+        }
+        std::cout << "Invalid option: " << arg << '\n'
+                  << "Usage: " << std::filesystem::path(argv[0]).filename().string()
+                  << " [--width=800] [--height=600] [--points=20000] [--iterations=10] [--strict=8]"
+                     " [--tile=64] [--cache-tiles=16] [--data=../generated-data] [--thrashing] [--perf]\n";
+        return false;
+    }
+    if ((long) width * height > INT32_MAX) {
+        std::cout << "The raster is too large for 32 bits offsets.\n";
+        return false;
+    }
+    return true;
 }
@@ -0,0 +1,793 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#ifndef TEST_CASE_HPP
+#define TEST_CASE_HPP
+
+#include <cstdint>
+#include <chrono>
+#include <fstream>
+#include <filesystem>
+#include <future>
+#include <vector>
+#include <bit>
+#include <cmath>
+#include <algorithm>
+#include "Arena.hpp"
+#include "ElementType.hpp"
+#include "Interpolation.hpp"
+#include "Resampling.hpp"
+#include "CompressedRaster.hpp"
+#include "PerfCounters.hpp"
+#include "LatencyHistogram.hpp"
+
+/*
+ * The raster size and the number of points, together with the directory of the data files.
+ * Default values are those of the files generated by the Java `DataGenerator`. They can be
+ * changed on the command line for running the same binary on rasters of other sizes.
+ */
+struct Configuration {
+    /*
+     * The raster size, in pixels.
+     */
+    int width  = 800;
+    int height = 600;
+
+    /*
+     * Number of points where to interpolate.
+     */
+    int numInterpolationPoints = 20000;
+
+    /*
+     * Number of iterations for which we verify the conformance against expected results.
+     * We verify a small number of iterations because the actual results diverge strongly
+     * from the expected results after about 8 iterations, because of the intentionally
+     * chaotic nature of the calculation.
+     */
+    int numVerifiedIterations = 10;
+
+    /*
+     * Number of first iterations which shall have no "missing value" mismatch for a test to be successful.
+     * The default value is suitable for the default number of points. With more points, the chaotic drift
+     * moves some points to other pixels in earlier iterations, so this number needs to be reduced.
+     */
+    int numStrictIterations = 8;
+
+    /*
+     * Size in pixels of the square tiles used by the test variants with a tiled raster layout.
+     * Shall be a power of 2.
+     */
+    int tileSize = 64;
+
+    /*
+     * Number of tiles kept in memory by the test variants reading the raster by tiles when first needed.
+     */
+    int cacheTiles = 16;
+
+    /*
+     * Whether to include the `TestNaN/paged` variant, which reads the tiles in the random order of the points.
+     * With the default cache size, this variant reads a tile on most interpolations and is orders of magnitude
+     * slower than the other variants, so it is excluded by default.
+     */
+    bool thrashing = false;
+
+    /*
+     * Whether to measure the hardware performance counters of each test variant and print them.
+     */
+    bool perfCounters = false;
+
+    /*
+     * The directory which contains the "nan" and "nodata" sub-directories with the data files.
+     */
+    std::filesystem::path dataDirectory = "../generated-data";
+
+    bool parse(int, char**);
+};
+
+/*
+ * The configuration of the tests. Shall not be modified after the command line has been parsed.
+ */
+extern Configuration config;
+
+/*
+ * The threshold used for deciding if a value should be considered as a missing value
+ * when using the "no data" sentinel values approach instead of IEEE 754 NaN values.
+ * Any value greater than this threshold will be considered a missing value.
+ *
+ * Note that this strategy works only if all missing values are greater than all valid values.
+ * Conversely, a strategy where all missing values are smaller than valid values would also work.
+ * However, if the missing values can be anything (for example some of them smaller and some of
+ * them greater than valid values), then the code would need to be more complex and slower.
+ */
+#define MISSING_VALUE_THRESHOLD 10000
+
+/*
+ * Compares a result with its expected value, and returns the displacement of the point for the next iteration.
+ * If `missing` is true, `nodata` is the sentinel value of the missing value reason of the result, which shall be
+ * the expected value. Otherwise, `nodata` is ignored and the expected value shall not be a sentinel value.
+ * A mismatch increments `mismatches`, and the difference between a valid result and a valid expected value
+ * updates `maxError`. The displacement is the result, or 1 if the result is missing. This is the verification
+ * shared by all test variants, written without branches for allowing conditional moves in their loops.
+ */
+inline double verifyResult(bool missing, double nodata, double result, double expected, int& mismatches, double& maxError) {
+    bool expectedMissing = (expected >= MISSING_VALUE_THRESHOLD);
+    mismatches += missing ? (nodata != expected) : expectedMissing;
+    maxError = std::max(maxError, (missing | expectedMissing) ? 0.0 : std::abs(result - expected));
+    return missing ? 1.0 : result;          // 1 for moving to another position during the next iteration.
+}
+
+/*
+ * Moves the point at (`xy[0]`, `xy[1]`) by the given displacement, with the wraparound which keeps the points
+ * inside the raster. This is the intentionally chaotic calculation of the next position shared by all tests.
+ */
+inline void movePoint(double* xy, double displacement, int width, int height) {
+    xy[0] = std::fmod(std::abs(xy[0] + displacement), width  - 1);
+    xy[1] = std::fmod(std::abs(xy[1] + displacement), height - 1);
+}
+
+/*
+ * Bytes of a file loaded in memory. On platforms supporting `mmap`, a file which does not need byte swapping
+ * is mapped in copy-on-write mode: pages that are only read are shared with the operating system cache (no copy),
+ * while pages modified by the caller (e.g. for updating coordinates) become private copies and the file is left
+ * unchanged. Otherwise, the bytes are copied in an array taken from an `Arena`.
+ */
+class MappedFile {
+    /*
+     * The bytes of the file, or NULL if none.
+     */
+    char* bytes;
+
+    /*
+     * Number of bytes in the `bytes` array.
+     */
+    size_t length;
+
+    /*
+     * Whether `bytes` is a memory mapping to release with `munmap`, as opposed to an array owned by an arena.
+     */
+    bool mapped;
+
+    public:
+        MappedFile();
+        ~MappedFile();
+        char* map(const std::filesystem::path&, size_t, int, Arena&, bool exactSize = false);
+        void  unmap();
+
+        /*
+         * Returns the bytes of the file loaded by the last call to `map(…)`, or NULL if none.
+         */
+        inline char* data() const {
+            return bytes;
+        }
+};
+
+/*
+ * Reader of the expected results, one iteration at a time. The file contains `config.numVerifiedIterations`
+ * blocks of `config.numInterpolationPoints` values, and this reader returns a range of the values of each block.
+ * Only two blocks are kept in memory: the one being verified by the caller, and the next one which is read
+ * in a background thread while the caller is verifying the current block. This is the equivalent of the
+ * `prepareNextVerification(...)` method in the Java version, with the addition of asynchronous reads.
+ * Alternatively, the reader can return ranges of values already in memory, in which case nothing is read.
+ */
+class ExpectedResults {
+    /*
+     * The stream from which to read the expected values.
+     */
+    std::ifstream stream;
+
+    /*
+     * All expected values in native byte order if they are already in memory, or NULL for reading the stream.
+     */
+    const double* values;
+
+    /*
+     * Index of the first point and number of points to read in each block.
+     */
+    int firstPoint, numPoints;
+
+    /*
+     * Index of the next block to return, or `config.numVerifiedIterations` if none.
+     */
+    int iteration;
+
+    /*
+     * The block being verified by the caller and the block being read in background.
+     * The block of iteration `it` is stored in `buffers[it & 1]`.
+     */
+    double* buffers[2];
+
+    /*
+     * The background reading of the next block, with a result telling whether the read succeeded.
+     * This is valid only when `iteration` is greater than 0.
+     */
+    std::future<bool> pending;
+
+    bool readBlock(int, double*);
+
+    public:
+        ExpectedResults();
+        bool open(const std::filesystem::path&, int, int, Arena&);
+        bool open(const double*, int, int);
+        const double* next();
+};
+
+/*
+ * Mapping from pixel coordinates to offsets in the raster array. The raster can be stored either in
+ * row-major order, as in the file, or as square tiles of `tileSize` × `tileSize` pixels stored one
+ * after the other. In the latter case, each tile has an additional column and an additional row
+ * which duplicate the first column and row of the neighbor tiles. Consequently, the four pixels
+ * needed by a bilinear interpolation are always in the same tile, and the kernels can fetch them
+ * at `offset`, `offset + 1`, `offset + rowStride` and `offset + rowStride + 1` in both layouts.
+ * The benefit of tiles is that those pixels are in two cache lines that are close in memory.
+ */
+struct RasterLayout {
+    /*
+     * The raster size, in pixels.
+     */
+    int width, height;
+
+    /*
+     * Logarithm in base 2 of the tile size, or 0 for the row-major layout.
+     */
+    int tileShift;
+
+    /*
+     * Number of tiles in a row of tiles.
+     */
+    int tilesPerRow;
+
+    /*
+     * Number of values between a pixel and the pixel below it.
+     * This is the raster width in the row-major layout, or the tile size plus one otherwise.
+     */
+    int rowStride;
+
+    RasterLayout(int, int, int);
+    size_t length() const;
+
+    /*
+     * Returns the offset of the pixel at the given coordinates, or -1 if a bilinear interpolation
+     * cannot be applied at that position. The row-major case does the same bound check as the
+     * original code of this test.
+     */
+    inline int offset(int x, int y) const {
+        if (tileShift == 0) {
+            int offset = width * y + x;
+            return (offset < 0 || offset >= (height - 1) * width + (width - 1)) ? -1 : offset;
+        }
+        if ((unsigned) x >= (unsigned) (width - 1) || (unsigned) y >= (unsigned) (height - 1)) {
+            return -1;
+        }
+        int mask = (1 << tileShift) - 1;
+        int tile = (y >> tileShift) * tilesPerRow + (x >> tileShift);
+        return tile * rowStride * rowStride + (y & mask) * rowStride + (x & mask);
+    }
+};
+
+/*
+ * Maximal size in bytes of the expected results for loading them fully in memory.
+ * Larger files are read one iteration at a time by each test case.
+ */
+#define EXPECTED_RESULTS_CACHE_LIMIT (256 * 1024 * 1024)
+
+/*
+ * A function converting a raster value to another convention for missing values.
+ * See `DataCache::raster(…)`.
+ */
+typedef float (*ValueEncoder)(float);
+
+/*
+ * A function converting `count` raster values to another element type.
+ * See `DataCache::raster(…)` and `convertElements<T>(…)`.
+ */
+typedef void (*ElementConverter)(const float* source, void* target, size_t count);
+
+/*
+ * Number of integer formats of the sensor rasters. See `SENSOR_FORMATS` in `SensorTest.hpp`.
+ */
+#define NUM_SENSOR_FORMATS 2
+
+/*
+ * The data files loaded in memory, shared by all test cases and all repetitions of the tests.
+ * Each file is loaded on the first request, with bytes swapped to the native byte order, and is kept
+ * in memory until this cache is destroyed. The arrays returned by this class shall not be modified:
+ * test cases which modify the coordinates work on a copy (see `TestCase::loadCoordinates()`).
+ * Consequently, only the first repetition of the tests reads files.
+ *
+ * The files are in the "nan" or "nodata" sub-directory of `config.dataDirectory`:
+ *
+ *   - "big-endian.raw" and "little-endian.raw" contain raster data as `float` values in the byte order
+ *     given by the file name. The raster size is `config.width` × `config.height` pixels and the values
+ *     are random `float` values between -100 and +100. The files contain random missing values identified
+ *     by "no data" sentinel values or by NaN values, depending on the sub-directory.
+ *   - "coordinates.raw" contains pixel coordinates as `double` values in big-endian byte order.
+ *     For simplicity, coordinates are from 0 inclusive to the width or height minus one, exclusive.
+ *     This is for avoiding the need to check for bounds before bilinear interpolations.
+ *   - "expected-results.raw" contains expected results as `double` values in big-endian byte order.
+ *     This file may be large, so it is loaded in memory only if not larger than `EXPECTED_RESULTS_CACHE_LIMIT`.
+ *     Missing results are represented by sentinel values only. NaNs are not used for avoiding any suspicion
+ *     about test reliability.
+ *   - "raster.nanz" is optional and contains the raster in the compressed format described in `CompressedRaster`.
+ *     This file is created by the `NaN-compress` executable. If absent, the compression is done in memory.
+ *   - "sensor-uint16.raw" and "sensor-int16.raw" are optional and contain the "nodata" raster as 16 bits integers
+ *     of a sensor, in the formats described by `SENSOR_FORMATS`. These files are created by the `NaN-generate`
+ *     executable. If absent, the raster is encoded in memory.
+ *
+ * The expected results of the interpolation methods other than bilinear are not files, but are computed
+ * in memory on the first request from the "nodata" raster and coordinates (see `ResamplingTest.cpp`).
+ *
+ * This class is not thread-safe. Data shall be requested before starting worker threads.
+ */
+class DataCache {
+    /*
+     * A copy of a raster in a tiled layout, or with values converted by an encoder or to another element type.
+     */
+    struct DerivedRaster {
+        bool             useNaN;
+        std::endian      byteOrder;
+        int              tileShift;
+        ValueEncoder     encoder;
+        ElementConverter converter;
+        const void*      values;
+    };
+
+    /*
+     * The raster files indexed by `[useNaN][byteOrder == std::endian::big]`,
+     * and the coordinates and expected results files indexed by `[useNaN]`.
+     * The `rawRasterFiles` are the files in non-native byte order mapped without swapping.
+     */
+    MappedFile rasterFiles[2][2], rawRasterFiles[2], coordinatesFiles[2], expectedResultsFiles[2];
+
+    /*
+     * Copies of the rasters in the tiled layouts or with the encoders requested so far.
+     */
+    std::vector<DerivedRaster> derivedRasters;
+
+    /*
+     * The compressed rasters indexed by `[useNaN]`, with the file where they have been read
+     * or the bytes of the compression done in memory if there is no such file.
+     */
+    MappedFile compressedFiles[2];
+    std::vector<uint8_t> compressedCopies[2];
+    CompressedRaster compressedRasters[2];
+
+    /*
+     * The expected results of each interpolation method other than bilinear, or empty if not yet computed.
+     */
+    std::vector<double> resampledResults[NUM_INTERPOLATION_METHODS];
+
+    /*
+     * The sensor rasters in each format of `SENSOR_FORMATS`, either mapped from their file
+     * or encoded in memory if there is no such file.
+     */
+    MappedFile sensorFiles[NUM_SENSOR_FORMATS];
+    std::vector<uint16_t> sensorCopies[NUM_SENSOR_FORMATS];
+
+    /*
+     * The memory of the swapped and tiled copies. This arena is never reset.
+     */
+    Arena arena;
+
+    public:
+        std::filesystem::path file(bool, const char*) const;
+        const float*  raster(bool, std::endian, const RasterLayout&, ValueEncoder = NULL);
+        const float*  rawRaster(bool, std::endian);
+        const void*   raster(bool, const RasterLayout&, ElementConverter, size_t);
+        const double* coordinates(bool);
+        const double* expectedResults(bool);
+        const double* expectedResults(InterpolationMethod);
+        const CompressedRaster* compressedRaster(bool);
+        const uint16_t* sensorRaster(int);
+};
+
+/*
+ * Base class shared by the two test cases.
+ */
+class TestCase {
+    /*
+     * Whether this test case uses NaN instead of "no data" sentinel values.
+     */
+    bool useNaN;
+
+    /*
+     * Whether the values in the raster file are in big-endian or little-endian byte order.
+     */
+    std::endian byteOrder;
+
+    protected:
+        /*
+         * The memory from which this test case takes its arrays. It is owned by the caller,
+         * which may reuse the same memory for many test cases executed one after the other.
+         */
+        Arena& arena;
+
+        /*
+         * The data files, shared with the other test cases.
+         */
+        DataCache& cache;
+
+        /*
+         * The layout of the array returned by `loadRaster()`.
+         */
+        RasterLayout layout;
+
+        /*
+         * Statistics about the differences between computed values and expected values.
+         * The array length is `config.numVerifiedIterations`.
+         */
+        double* errorStatistics;
+
+        /*
+         * Number of times where the "no data" values do not match the expected values.
+         * This value should be zero during the first iterations, and become non-zero only
+         * after the calculation has drifted. Note that the latter case is not an indication
+         * that NaN does no work: identical mismatches happen with the "no data" approach too.
+         */
+        int* nodataMismatches;
+
+        /*
+         * The hardware performance counters to read around each iteration, or NULL if disabled.
+         */
+        PerfCounters* counters;
+
+        /*
+         * Values of the performance counters during each iteration, followed by the values during the whole
+         * computation. The array length is (`config.numVerifiedIterations` + 1) × `NUM_PERF_COUNTERS`, and
+         * values are zero for the iterations that are not measured. NULL if the counters are disabled.
+         */
+        uint64_t* counterValues;
+
+        /*
+         * The histograms where to record the duration of each iteration and of each batch of `SIMD_BATCH_SIZE`
+         * points, or NULL if disabled. The batches are recorded only by the variants computing the interpolations
+         * by batches in the current thread. The histograms are owned by the caller.
+         */
+        LatencyHistogram* iterationLatencies;
+        LatencyHistogram* batchLatencies;
+
+        /*
+         * Time of the last call to `startCounters(…)`, if the iteration latencies are recorded.
+         */
+        mutable std::chrono::high_resolution_clock::time_point iterationStart;
+
+        /*
+         * Takes a snapshot of the performance counters before the code to measure.
+         * Does nothing if the counters and the latency histograms are disabled.
+         */
+        inline void startCounters(uint64_t* snapshot) const {
+            if (counters) counters->read(snapshot);
+            if (iterationLatencies) iterationStart = std::chrono::high_resolution_clock::now();
+        }
+
+        /*
+         * Adds the counts since the given snapshot to the values of the given iteration,
+         * or of the whole computation if `it` is `config.numVerifiedIterations`.
+         * The time elapsed since the last call to `startCounters(…)` is recorded for iterations only.
+         * Does nothing if the counters and the latency histograms are disabled.
+         */
+        inline void stopCounters(const uint64_t* snapshot, int it) {
+            if (iterationLatencies && it < config.numVerifiedIterations) {
+                iterationLatencies->record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::high_resolution_clock::now() - iterationStart).count());
+            }
+            if (counters) counters->accumulate(snapshot, counterValues + it * NUM_PERF_COUNTERS);
+        }
+
+        /*
+         * Returns the time before the computation of a batch of points,
+         * or an arbitrary value if the batch latencies are not recorded.
+         */
+        inline std::chrono::high_resolution_clock::time_point startBatch() const {
+            return batchLatencies ? std::chrono::high_resolution_clock::now()
+                                  : std::chrono::high_resolution_clock::time_point();
+        }
+
+        /*
+         * Records the time elapsed since the given value of `startBatch()`.
+         * Does nothing if the batch latencies are not recorded.
+         */
+        inline void stopBatch(std::chrono::high_resolution_clock::time_point start) {
+            if (batchLatencies) {
+                batchLatencies->record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::high_resolution_clock::now() - start).count());
+            }
+        }
+
+        TestCase(Arena&, DataCache&, bool, std::endian, int);
+        const float* loadRaster();
+        double* loadCoordinates();
+        bool    openExpectedResults(ExpectedResults&, int, int);
+
+    public:
+        virtual ~TestCase() {}
+        virtual double computeAndCompare() = 0;
+        virtual int    threadCount() const;
+        virtual double tolerance() const;
+        virtual int    referenceVariant() const;
+        virtual void   printDetails() const;
+        void    setCounters(PerfCounters*);
+        void    setLatencyHistograms(LatencyHistogram*, LatencyHistogram*);
+        bool    success();
+        bool    resultEquals(TestCase*);
+        void    printStatistics();
+};
+
+/*
+ * Returns the bit pattern of the given floating point number.
+ * Equivalent to Java's `Float.floatToRawIntBits(float)`.
+ *
+ * Note: NaN values have a sign bit (we can have "negative" NaN), so we really need the signed type below.
+ * The choice of signed or unsigned type changes the way that the `max` function will behave when checking
+ * which NaN has precedence in this test.
+ */
+inline int32_t floatToRawIntBits(float value) {
+    return std::bit_cast<int32_t>(value);
+}
+
+/*
+ * Demonstrates that NaN values can be read and processed without any lost of information.
+ * The calculation is a bilinear interpolation.
+ */
+class TestNaN : public TestCase {
+    protected:
+        /*
+         * Value of the first positive quiet NaN.
+         */
+        const int32_t FIRST_QUIET_NAN = 0x7FC00000;
+
+        /*
+         * NaN bit pattern for a missing data. A value may be missing for different reasons, which are identified
+         * by different NaN values. This test uses the following values, in precedence order. For example,
+         * if a calculation involves two pixels missing for `CLOUD` and `LAND` reasons respectively,
+         * then the result will be considered missing for the `LAND` reason.
+         *
+         *   - Missing because the remote sensor didn't pass over that area.
+         *   - Missing because the pixel is on a land (assuming that the data are for some oceanographic phenomenon).
+         *   - Missing because of a cloud.
+         *   - Missing for an unknown reason.
+         */
+        const int32_t UNKNOWN = FIRST_QUIET_NAN,      // This is the default NaN value in Java.
+                      CLOUD   = FIRST_QUIET_NAN + 1,
+                      LAND    = FIRST_QUIET_NAN + 2,
+                      NO_PASS = FIRST_QUIET_NAN + 3;
+
+    public:
+        TestNaN(Arena& arena, DataCache& cache, std::endian testByteOrder, int tileSize);
+        double computeAndCompare();
+};
+
+/*
+ * Same calculation as `TestNaN` but with the interpolations computed by the vectorized kernels
+ * of the `naninterp` library, as an application would do.
+ * The verification against expected values is still done one point at a time, but that part
+ * is only a requirement of the test: an application would use the results directly.
+ *
+ * Optionally, the points can be split in ranges evaluated in parallel by different threads.
+ * This is possible because the chain of iterations of a point does not depend on other points.
+ */
+class TestNaNSIMD : public TestNaN {
+    /*
+     * Number of threads in which to split the interpolation points.
+     * A value of 1 means that the calculation is done in the current thread.
+     */
+    int numThreads;
+
+    /*
+     * Whether to sort the points by tiles of `config.tileSize` pixels before each iteration.
+     * Consecutive points then read pixels in the same region of the raster, which reduces
+     * cache misses on rasters larger than the cache.
+     */
+    bool binning;
+
+    /*
+     * Whether the kernel returns the missing value reasons packed on 2 bits per point
+     * instead of the full bit patterns. See `interpolatePacked(…)`.
+     */
+    bool packed;
+
+    /*
+     * Whether to compute the summary of tiles of `config.tileSize` pixels before the interpolations,
+     * for resolving the batches of points in fully missing tiles without interpolation. See `Raster::summarize(…)`.
+     */
+    bool summary;
+
+    /*
+     * Whether to read the raster from its compressed form, decoding only the tiles touched by each batch of points.
+     * In that case, `source` is the compressed raster, `decodedValues` the raster being decoded and `decodedTiles`
+     * the flags telling which tiles have already been decoded. See `DataCache::compressedRaster(…)`.
+     */
+    bool compressed;
+    const CompressedRaster* source;
+    float* decodedValues;
+    std::vector<uint8_t> decodedTiles;
+
+    int  numBins() const;
+    void binPoints(const double*, int, int, int*, double*);
+    void computeRange(const Raster&, double*, ExpectedResults*, int, int, double*, int*, int*, double*);
+
+    public:
+        TestNaNSIMD(Arena& arena, DataCache& cache, std::endian testByteOrder, int numThreads, bool binning,
+                    bool packed = false, bool summary = false, bool compressed = false);
+        double computeAndCompare();
+        int    threadCount() const;
+};
+
+/*
+ * Same calculation as `TestNaN` but using sentinel values.
+ * Used only for comparison purposes (reference implementation).
+ */
+class TestNodata : public TestCase {
+    protected:
+        /*
+         * Sentinel value for a missing data. A value may be missing for different reasons, which are identified
+         * by different sentinel values. This test uses the following values, in precedence order. For example,
+         * if a calculation involves two pixels missing for `CLOUD` and `LAND` reasons respectively,
+         * then the result will be considered missing for the `LAND` reason.
+         *
+         *   - Missing because the remote sensor didn't pass over that area.
+         *   - Missing because the pixel is on a land (assuming that the data are for some oceanographic phenomenon).
+         *   - Missing because of a cloud.
+         *   - Missing for an unknown reason.
+         */
+        const float UNKNOWN = 10000,    // Shall be equal to MISSING_VALUE_THRESHOLD for this test.
+                    CLOUD   = 10001,
+                    LAND    = 10002,
+                    NO_PASS = 10003;
+
+    public:
+        TestNodata(Arena& arena, DataCache& cache, std::endian testByteOrder, int tileSize);
+        double computeAndCompare();
+        bool testAndCompare(bool, PerfCounters*);
+};
+
+/*
+ * Same calculation as `TestNodata` but without branch on the "no data" check. The interpolation is computed
+ * unconditionally, as in `TestNaN`, then the result is selected with a mask. The verification is also written
+ * with selections instead of branches. This variant allows to distinguish the cost of the encoding of missing
+ * values (NaN versus sentinel values) from the cost of the branch structure.
+ */
+class TestNodataBranchFree : public TestNodata {
+    public:
+        TestNodataBranchFree(Arena& arena, DataCache& cache, std::endian testByteOrder);
+        double computeAndCompare();
+};
+
+/*
+ * Conventions for identifying missing values, used as template argument of `TestPolicy`.
+ * Each policy defines the following members:
+ *
+ *   - `USE_NAN`:      whether the raster is read from the files with NaN values or with sentinel values.
+ *   - `ENCODER`:      conversion applied on a copy of the raster before the test, or NULL if none.
+ *   - `Element`:      the type of raster elements, with properties given by `ElementType<Element>`.
+ *   - `Reason`:       the type of the value identifying why a value is missing, if it is missing.
+ *   - `reason(e)`:    the missing reason of raster element `e`, in a form where precedence is an order.
+ *   - `precedence`:   the reason having precedence between two reasons, which is also the reason of valid
+ *                     values when mixed with missing values. This is `max` or `min`, without branch.
+ *   - `isMissing(r)`: whether the given reason (computed with `precedence`) is for a missing value.
+ *   - `toNodata(r)`:  the "no data" value of the expected results file for the given missing reason.
+ *
+ * Those policies are the variations of the same optimization strategy discussed in the
+ * "Notes on an optimization strategy" section of the `README.md` file.
+ */
+
+/*
+ * Missing values are NaN, with the reason in the payload. The reason is the bit pattern
+ * compared as signed integer, in which "positive" quiet NaNs are greater than all other values.
+ * This is the strategy of `TestNaN`, generalized to all element types: `int64_t` for `double`,
+ * `int16_t` for `Half` and `BFloat16`.
+ */
+template<typename T> struct NaNPayloadPolicy {
+    static constexpr bool USE_NAN = true;
+    static constexpr ValueEncoder ENCODER = NULL;
+    typedef T Element;
+    typedef typename ElementType<T>::Bits Reason;
+    static constexpr Reason FIRST_QUIET_NAN = ElementType<T>::FIRST_QUIET_NAN;
+    static inline Reason reason(T element)               {return ElementType<T>::bits(element);}
+    static inline Reason precedence(Reason a, Reason b)  {return std::max(a, b);}
+    static inline bool   isMissing(Reason r)             {return r >= FIRST_QUIET_NAN;}
+    static inline double toNodata(Reason r)              {return (r - FIRST_QUIET_NAN) + MISSING_VALUE_THRESHOLD;}
+};
+
+/*
+ * Missing values are sentinel values greater than all valid values, with higher values for
+ * the reasons having precedence. This is the strategy of `TestNodata`.
+ */
+struct SentinelAbovePolicy {
+    static constexpr bool USE_NAN = false;
+    static constexpr ValueEncoder ENCODER = NULL;
+    typedef float Element;
+    typedef float Reason;
+    static inline Reason reason(float value)             {return value;}
+    static inline Reason precedence(Reason a, Reason b)  {return std::max(a, b);}
+    static inline bool   isMissing(Reason r)             {return r >= MISSING_VALUE_THRESHOLD;}
+    static inline double toNodata(Reason r)              {return r;}
+};
+
+/*
+ * Converts the sentinel values of the "no data" files to the negative values of `SentinelBelowPolicy`.
+ */
+inline float negateSentinel(float value) {
+    return (value >= MISSING_VALUE_THRESHOLD) ? -value : value;
+}
+
+/*
+ * Missing values are sentinel values less than all valid values, with lower values for the reasons having
+ * precedence. The `>=` comparisons of `SentinelAbovePolicy` become `<=`, and `max` becomes `min`.
+ */
+struct SentinelBelowPolicy {
+    static constexpr bool USE_NAN = false;
+    static constexpr ValueEncoder ENCODER = negateSentinel;
+    typedef float Element;
+    typedef float Reason;
+    static inline Reason reason(float value)             {return value;}
+    static inline Reason precedence(Reason a, Reason b)  {return std::min(a, b);}
+    static inline bool   isMissing(Reason r)             {return r <= -MISSING_VALUE_THRESHOLD;}
+    static inline double toNodata(Reason r)              {return -r;}
+};
+
+/*
+ * Converts the sentinel values of the "no data" files to the mix of positive and negative values
+ * of `SentinelMixedSignPolicy`. The `CLOUD` and `NO_PASS` values (the odd ones) become negative.
+ */
+inline float alternateSentinelSign(float value) {
+    return (value >= MISSING_VALUE_THRESHOLD && (((int) value) & 1)) ? -value : value;
+}
+
+/*
+ * Missing values are sentinel values either greater or less than all valid values. This works because
+ * the negative sentinel values are in the same range as the absolute values of the positive ones,
+ * and because all valid values are in a range where their absolute values are less than the threshold.
+ */
+struct SentinelMixedSignPolicy {
+    static constexpr bool USE_NAN = false;
+    static constexpr ValueEncoder ENCODER = alternateSentinelSign;
+    typedef float Element;
+    typedef float Reason;
+    static inline Reason reason(float value)             {return std::abs(value);}
+    static inline Reason precedence(Reason a, Reason b)  {return std::max(a, b);}
+    static inline bool   isMissing(Reason r)             {return r >= MISSING_VALUE_THRESHOLD;}
+    static inline double toNodata(Reason r)              {return r;}
+};
+
+/*
+ * The `TestNaN` and `TestNodata` calculation written once for all conventions of missing values.
+ * The missing value checks are provided by the `Policy` template argument (see `NaNPayloadPolicy`)
+ * and are inlined by the compiler, so each instantiation is a kernel as specialized as a hand-written one.
+ * The loop is branch-free, as in `TestNodataBranchFree`. The raster is read in the `ORDER` byte order:
+ * if it is not the native one, the file is mapped in memory without copy and the bytes of each sample
+ * are swapped in a register. This is not supported with the policies having an encoder.
+ *
+ * Rasters of element types other than `float` are copies of the `float` raster in native byte order.
+ * If the element type cannot store the values exactly (`Half` and `BFloat16`), the results cannot be
+ * identical to the ones of `TestNodata` and the chaotic displacement of the points would diverge quickly.
+ * In that case, the points are moved with the expected values instead of the interpolated ones, so that they
+ * follow the same path as in the reference. In those tests, the statistics are the errors caused by rounding,
+ * and the test is successful if they do not exceed `tolerance()` and no missing value reason differs.
+ */
+template<class Policy, std::endian ORDER> class TestPolicy : public TestCase {
+    typedef typename Policy::Element Element;
+    static_assert(ORDER == std::endian::native || (Policy::ENCODER == NULL && std::is_same_v<Element, float>),
+                  "Encoded rasters are copies in native byte order.");
+    public:
+        TestPolicy(Arena& arena, DataCache& cache);
+        double computeAndCompare();
+        double tolerance() const;
+};
+
+/*
+ * Number of variants executed by `TestNodata::testAndCompare(…)`, with their labels and benchmark names.
+ */
+#define NUM_TEST_VARIANTS 35
+extern const char* TEST_VARIANT_NAMES[NUM_TEST_VARIANTS];
+extern const char* TEST_VARIANT_IDS  [NUM_TEST_VARIANTS];
+
+/*
+ * Index of the `TestNaN/paged` variant, which is executed only if `config.thrashing` is true.
+ */
+#define THRASHING_VARIANT 22
+
+TestCase* createTestVariant(int, Arena&, DataCache&);
+bool isVariantEnabled(int);
+
+#endif
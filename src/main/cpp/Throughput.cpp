@@ -0,0 +1,124 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#include <cmath>
+#include <bit>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include "Throughput.hpp"
+
+/*
+ * Names of the throughput variants, in the order of the `variant` argument of `ThroughputTest::run(…)`.
+ */
+const char* THROUGHPUT_VARIANT_IDS[NUM_THROUGHPUT_VARIANTS] = {
+    "Throughput/scalar",
+    "Throughput/vectorized",
+    "Throughput/vectorized+prefetch"
+};
+
+/*
+ * Creates the points at random positions in the raster, then computes the reference results with the scalar variant.
+ * The seed is fixed, so all runs and all executions use the same points.
+ */
+ThroughputTest::ThroughputTest(const float* values, int width, int height, int count)
+        : raster(values, width, height), numPoints(count)
+{
+    std::mt19937_64 random(42);
+    std::uniform_real_distribution<double> x(0, width - 1), y(0, height - 1);
+    coordinates.resize(2 * (size_t) count);
+    for (int i=0; i<count; i++) {
+        coordinates[2*i]     = x(random);
+        coordinates[2*i + 1] = y(random);
+    }
+    results.resize(count);
+    reasons.resize(count);
+    expectedResults.resize(count);
+    expectedReasons.resize(count);
+    interpolateOneByOne(expectedResults.data(), expectedReasons.data());
+}
+
+/*
+ * Interpolates all points one at a time, with the same arithmetic as `TestNaN::computeAndCompare()`.
+ * No bound check is needed because the coordinates are generated inside the raster.
+ */
+void ThroughputTest::interpolateOneByOne(double* target, int32_t* reasonOfPoints) const {
+    const float* values = raster.values;
+    const int width = raster.width;
+    for (int i=0; i<numPoints; i++) {
+        double x  = coordinates[2*i];
+        double y  = coordinates[2*i + 1];
+        double xb = std::floor(x);
+        double yb = std::floor(y);
+        int offset = width * (int) yb + (int) xb;
+        float v00 = values[offset];
+        float v01 = values[offset + 1];
+        float v10 = values[offset += width];
+        float v11 = values[offset + 1];
+        double xf = x - xb;
+        double yf = y - yb;
+        double v0 = std::fma(v01 - (double) v00, xf, v00);
+        double v1 = std::fma(v11 - (double) v10, xf, v10);
+        target[i] = std::fma(v1 - v0, yf, v0);
+        reasonOfPoints[i] = std::max(std::max(std::bit_cast<int32_t>(v00), std::bit_cast<int32_t>(v01)),
+                                     std::max(std::bit_cast<int32_t>(v10), std::bit_cast<int32_t>(v11)));
+    }
+}
+
+/*
+ * Interpolates all points with the vectorized kernel by batches of `PREFETCH_BATCH_SIZE` points.
+ * Before each batch, the two raster rows used by each point of the next batch are prefetched, so the cache
+ * misses of the next batch are resolved while the current batch is computed. This is possible only because
+ * the coordinates of the next points do not depend on the results of the current points.
+ */
+void ThroughputTest::interpolateWithPrefetch() {
+    const float* values = raster.values;
+    const int width = raster.width;
+    for (int start=0; start < numPoints; start += PREFETCH_BATCH_SIZE) {
+        const int length = std::min(PREFETCH_BATCH_SIZE, numPoints - start);
+        const int end    = std::min(start + length + PREFETCH_BATCH_SIZE, numPoints);
+        for (int i = start + length; i < end; i++) {
+            const float* pixel = values + width * (int) coordinates[2*i + 1] + (int) coordinates[2*i];
+            __builtin_prefetch(pixel);
+            __builtin_prefetch(pixel + width);
+        }
+        raster.kernel(values, width, raster.height, coordinates.data() + 2*start, length,
+                      results.data() + start, reasons.data() + start);
+    }
+}
+
+/*
+ * Interpolates all points with the given variant, and returns the execution time in nanoseconds.
+ * The variants are the scalar code of the tests, the vectorized kernel of `interpolate(…)` in a single call,
+ * and the vectorized kernel with software prefetching.
+ */
+double ThroughputTest::run(int variant) {
+    std::fill(results.begin(), results.end(), 0.0);
+    auto startTime = std::chrono::high_resolution_clock::now();
+    switch (variant) {
+        case 0: interpolateOneByOne(results.data(), reasons.data()); break;
+        case 1: interpolate(raster, coordinates, results, reasons); break;
+        case 2: interpolateWithPrefetch(); break;
+    }
+    auto endTime = std::chrono::high_resolution_clock::now();
+    return duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+/*
+ * Returns whether the results of the last run are the same as the results of the scalar variant. Valid results
+ * shall have the same bit patterns. For missing results, the reasons are compared instead of the NaN payloads,
+ * because the payload of an operation on two NaN may depend on the order of the operands in the instructions.
+ */
+bool ThroughputTest::verify() const {
+    for (int i=0; i<numPoints; i++) {
+        if (isMissing(expectedResults[i])) {
+            if (!isMissing(results[i]) || reasons[i] != expectedReasons[i]) {
+                return false;
+            }
+        } else if (std::bit_cast<uint64_t>(results[i]) != std::bit_cast<uint64_t>(expectedResults[i])) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,58 @@
+/*
+ * This file is hereby placed into the Public Domain.
+ * This means anyone is free to do whatever they wish with this file.
+ */
+#ifndef THROUGHPUT_HPP
+#define THROUGHPUT_HPP
+
+#include <cstdint>
+#include <vector>
+#include "Interpolation.hpp"
+
+/*
+ * Number of variants of the throughput benchmark, and their names. See `ThroughputTest::run(…)`.
+ */
+#define NUM_THROUGHPUT_VARIANTS 3
+extern const char* THROUGHPUT_VARIANT_IDS[NUM_THROUGHPUT_VARIANTS];
+
+/*
+ * Number of points interpolated by the prefetching variant while the raster pixels of the next points are prefetched.
+ */
+#define PREFETCH_BATCH_SIZE 256
+
+/*
+ * Interpolations of a large fixed set of points in a single pass, for measuring the throughput of the kernels.
+ * Contrarily to the tests, the results are not fed back into the coordinates of a next iteration. That feedback
+ * is there for stressing the compiler optimizations, but it makes each point a long chain of dependent operations.
+ * Without it, all points are independent, so the processor can overlap the memory accesses of many points and the
+ * pixels of the next points can be prefetched.
+ *
+ * The coordinates are random with a fixed seed. Those points do not have expected results, so the results of each
+ * variant are verified against the results of the scalar variant computed at construction time, which is itself
+ * a copy of the `TestNaN` calculation. The chaotic iterations of the tests stay the correctness check.
+ */
+class ThroughputTest {
+    /*
+     * The raster to interpolate, in row-major order with NaN for missing values.
+     */
+    Raster raster;
+
+    /*
+     * The (x,y) coordinates of all points, the results of the last run and the results of the scalar variant.
+     */
+    std::vector<double>  coordinates;
+    std::vector<double>  results,  expectedResults;
+    std::vector<int32_t> reasons,  expectedReasons;
+
+    void interpolateOneByOne(double*, int32_t*) const;
+    void interpolateWithPrefetch();
+
+    public:
+        const int numPoints;
+
+        ThroughputTest(const float* values, int width, int height, int numPoints);
+        double run(int variant);
+        bool   verify() const;
+};
+
+#endif